@@ -0,0 +1,236 @@
+#define _GNU_SOURCE
+#include "affinity.h"
+#include <sched.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "log.h"
+
+extern char **environ;
+
+static bool configured = false;                 // FAINTER_CPU_* 가 하나라도 있으면
+static cpu_set_t process_mask;                  // 시작 시점에 허용된 CPU
+static cpu_set_t node_cpus[AFFINITY_MAX_NODES]; // 노드별 CPU (없는 노드는 비어 있다)
+static int node_count = 0;                      // 가장 큰 노드 번호 + 1
+
+// 보고서에 나오는 역할 (스레드 수가 여러 개인 역할은 스레드마다 CPU 하나씩)
+static const struct {
+    const char *name;
+    bool spread;
+} roles[] = {
+    {"main", false},
+    {"cm", false},
+    {"canvas", false},
+    {"worker", true},
+    {"sender", true},
+    {"log", false},
+    {"stats", false},
+};
+
+// "0-3,8" 형식의 CPU 목록
+static bool parse_cpulist(const char *text, cpu_set_t *set) {
+
+    CPU_ZERO(set);
+    const char *p = text;
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0' && *p != '\n') {
+            return false;
+        }
+    }
+    return CPU_COUNT(set) > 0;
+}
+
+// CPU 집합을 "0-3,8" 형식으로
+static void format_cpulist(const cpu_set_t *set, char *buf, size_t size) {
+
+    size_t offset = 0;
+    buf[0] = '\0';
+    for (int cpu = 0; cpu < CPU_SETSIZE && offset < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) {
+            last++;
+        }
+        int n = last > cpu ? snprintf(buf + offset, size - offset, "%s%d-%d", offset ? "," : "", cpu, last)
+                           : snprintf(buf + offset, size - offset, "%s%d", offset ? "," : "", cpu);
+        offset += n > 0 ? (size_t)n : 0;
+        cpu = last;
+    }
+}
+
+// 집합에 CPU가 들어 있는 노드 목록 ("0,1")
+static void format_nodes(const cpu_set_t *set, char *buf, size_t size) {
+
+    size_t offset = 0;
+    snprintf(buf, size, "?");
+    for (int node = 0; node < node_count && offset < size; node++) {
+        cpu_set_t both;
+        CPU_AND(&both, set, &node_cpus[node]);
+        if (CPU_COUNT(&both) > 0) {
+            int n = snprintf(buf + offset, size - offset, "%s%d", offset ? "," : "", node);
+            offset += n > 0 ? (size_t)n : 0;
+        }
+    }
+}
+
+// 역할의 환경 변수 값 (FAINTER_CPU_<역할 대문자>)
+static const char *role_env(const char *role) {
+
+    char name[64];
+    int n = snprintf(name, sizeof(name), "FAINTER_CPU_");
+    for (const char *c = role; *c != '\0' && n < (int)sizeof(name) - 1; c++) {
+        name[n++] = (char)toupper((unsigned char)*c);
+    }
+    name[n] = '\0';
+    return getenv(name);
+}
+
+// 역할에 설정된 CPU 집합 (설정이 없으면 0, 잘못된 값이면 -1)
+static int role_cpus(const char *role, cpu_set_t *set) {
+
+    const char *value = role_env(role);
+    if (value == NULL) {
+        return 0;
+    }
+
+    if (strncmp(value, "node", 4) == 0) {
+        char *end;
+        long node = strtol(value + 4, &end, 10);
+        if (end == value + 4 || *end != '\0' || node < 0 || node >= node_count) {
+            return -1;
+        }
+        *set = node_cpus[node];
+    }
+    else if (!parse_cpulist(value, set)) {
+        return -1;
+    }
+
+    // 컨테이너/taskset으로 허용된 CPU 밖은 뺀다
+    CPU_AND(set, set, &process_mask);
+    return CPU_COUNT(set) > 0 ? 1 : -1;
+}
+
+// index번째 CPU 하나만 남긴다 (같은 역할 스레드끼리 나눠 갖기)
+static void pick_cpu(cpu_set_t *set, int index) {
+
+    int target = index % CPU_COUNT(set);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, set) && target-- == 0) {
+            CPU_ZERO(set);
+            CPU_SET(cpu, set);
+            return;
+        }
+    }
+}
+
+void affinity_init(void) {
+
+    CPU_ZERO(&process_mask);
+    if (sched_getaffinity(0, sizeof(process_mask), &process_mask) == -1) {
+        return;
+    }
+
+    // sysfs에서 노드별 CPU 목록 (NUMA가 없는 커널이면 노드 0 하나로 본다)
+    for (int node = 0; node < AFFINITY_MAX_NODES; node++) {
+        char path[64], line[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *file = fopen(path, "r");
+        CPU_ZERO(&node_cpus[node]);
+        if (file == NULL) {
+            continue;
+        }
+        if (fgets(line, sizeof(line), file) != NULL && parse_cpulist(line, &node_cpus[node])) {
+            node_count = node + 1;
+        }
+        fclose(file);
+    }
+    if (node_count == 0) {
+        node_cpus[0] = process_mask;
+        node_count = 1;
+    }
+
+    for (char **env = environ; *env != NULL; env++) {
+        if (strncmp(*env, "FAINTER_CPU_", 12) == 0) {
+            configured = true;
+        }
+    }
+}
+
+int affinity_apply(const char *role, int index) {
+
+    if (!configured) {
+        return 0;
+    }
+
+    // 설정이 없거나 잘못된 역할은 만든 스레드의 고정을 물려받지 않도록 전체 마스크로
+    cpu_set_t set;
+    if (role_cpus(role, &set) != 1) {
+        set = process_mask;
+    }
+    else if (index >= 0) {
+        pick_cpu(&set, index);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+void affinity_report(void) {
+
+    char cpus[256], nodes[64];
+    format_cpulist(&process_mask, cpus, sizeof(cpus));
+    LOG_INFO("CPU 토폴로지: 사용 가능한 CPU %d개 (%s), NUMA 노드 %d개", CPU_COUNT(&process_mask), cpus, node_count);
+    for (int node = 0; node < node_count; node++) {
+        if (CPU_COUNT(&node_cpus[node]) > 0) {
+            format_cpulist(&node_cpus[node], cpus, sizeof(cpus));
+            LOG_INFO("  NUMA 노드 %d: CPU %s", node, cpus);
+        }
+    }
+
+    if (!configured) {
+        LOG_INFO("CPU 고정 없음 (FAINTER_CPU_<역할> 로 설정)");
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(roles) / sizeof(roles[0]); i++) {
+        cpu_set_t set;
+        int result = role_cpus(roles[i].name, &set);
+        if (result == -1) {
+            LOG_WARN("  %-6s: 잘못된 설정 \"%s\", 고정하지 않음", roles[i].name, role_env(roles[i].name));
+            continue;
+        }
+        if (result == 0) {
+            LOG_INFO("  %-6s: 고정하지 않음", roles[i].name);
+            continue;
+        }
+        format_cpulist(&set, cpus, sizeof(cpus));
+        format_nodes(&set, nodes, sizeof(nodes));
+        LOG_INFO("  %-6s: CPU %s (노드 %s)%s%s", roles[i].name, cpus, nodes,
+                 roles[i].spread ? ", 스레드마다 CPU 하나씩" : "",
+                 strchr(nodes, ',') ? " - 여러 노드에 걸침" : "");
+    }
+}
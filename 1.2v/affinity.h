@@ -0,0 +1,24 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// 스레드 역할별 CPU/NUMA 노드 고정
+// 역할마다 FAINTER_CPU_<역할> 환경 변수로 CPU 목록("0-3,8") 또는 NUMA 노드("node1")를 준다.
+//   FAINTER_CPU_MAIN, FAINTER_CPU_CM, FAINTER_CPU_CANVAS, FAINTER_CPU_WORKER, FAINTER_CPU_SENDER, FAINTER_CPU_LOG, FAINTER_CPU_STATS
+// 새 역할(리액터, 샤드 등)은 스레드 시작 시 affinity_apply("reactor", i)를 부르면 FAINTER_CPU_REACTOR 를 읽는다.
+// 하나도 설정하지 않으면 아무것도 하지 않는다. 설정이 없는 역할은 만든 스레드의 고정을 물려받지 않도록
+// 시작 시점의 CPU 마스크로 되돌린다.
+// 메모리는 first-touch: 역할 스레드가 고정된 뒤 자기 버퍼를 처음 쓰면 그 노드에 할당된다.
+
+#define AFFINITY_MAX_NODES 64
+
+// 시작 시점 CPU 마스크와 NUMA 토폴로지를 읽는다 (로그 스레드보다 먼저, 로그를 남기지 않는다)
+void affinity_init(void);
+
+// 현재 스레드를 역할의 CPU에 고정 (index >= 0 이면 같은 역할 스레드끼리 CPU 목록을 하나씩 나눠 가진다)
+// 실패하면 -1 (로그 스레드에서도 부르므로 로그를 남기지 않는다)
+int affinity_apply(const char *role, int index);
+
+// 토폴로지와 역할별 배치를 로그로 남긴다
+void affinity_report(void);
+
+#endif // AFFINITY_H
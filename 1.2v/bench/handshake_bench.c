@@ -0,0 +1,117 @@
+// WebSocket 핸드셰이크 처리량 벤치마크
+// 사용법: ./bench/handshake_bench [스레드 수] [스레드당 반복 횟수]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include "websocket_handshake.h"
+
+typedef struct {
+    int iterations;
+    int legacy;             // 1이면 기존 방식(매번 EVP_MD_CTX 할당 + snprintf)
+    double seconds;
+} BenchArgs;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 기존 구현 재현 (비교 기준)
+static int legacy_handshake(const char *client_key, char *response, size_t response_size) {
+    char combined_key[256];
+    unsigned char sha1_result[SHA_DIGEST_LENGTH];
+    char accept_key[256];
+
+    snprintf(combined_key, sizeof(combined_key), "%s%s", client_key, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+
+    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+    unsigned int md_len;
+    EVP_DigestInit_ex(mdctx, EVP_sha1(), NULL);
+    EVP_DigestUpdate(mdctx, combined_key, strlen(combined_key));
+    EVP_DigestFinal_ex(mdctx, sha1_result, &md_len);
+    EVP_MD_CTX_free(mdctx);
+
+    int encoded_length = EVP_EncodeBlock((unsigned char *)accept_key, sha1_result, SHA_DIGEST_LENGTH);
+    accept_key[encoded_length] = '\0';
+
+    return snprintf(response, response_size,
+                    "HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: %s\r\n"
+                    "\r\n",
+                    accept_key);
+}
+
+static void *bench_thread(void *arg) {
+    BenchArgs *args = (BenchArgs *)arg;
+    char client_key[32];
+    char response[WEBSOCKET_ACCEPT_RESPONSE_SIZE];
+    size_t checksum = 0;
+
+    double start = now_seconds();
+    for (int i = 0; i < args->iterations; i++) {
+        // 매 반복마다 다른 키 (24바이트 base64 형태)
+        snprintf(client_key, sizeof(client_key), "dGhlIHNhbXBsZSBub25j%04d", i % 10000);
+        int length = args->legacy ? legacy_handshake(client_key, response, sizeof(response))
+                                  : build_websocket_accept_response(client_key, response, sizeof(response));
+        checksum += length + (unsigned char)response[length - 5];
+    }
+    args->seconds = now_seconds() - start;
+
+    if (checksum == 0) {
+        printf("unreachable\n");
+    }
+    return NULL;
+}
+
+static void run(const char *name, int threads, int iterations, int legacy) {
+    pthread_t tids[threads];
+    BenchArgs args[threads];
+
+    for (int i = 0; i < threads; i++) {
+        args[i].iterations = iterations;
+        args[i].legacy = legacy;
+        pthread_create(&tids[i], NULL, bench_thread, &args[i]);
+    }
+
+    double slowest = 0;
+    double per_thread_sum = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        if (args[i].seconds > slowest) {
+            slowest = args[i].seconds;
+        }
+        per_thread_sum += iterations / args[i].seconds;
+    }
+
+    printf("%-8s threads=%d  total=%.0f handshakes/s  per-core=%.0f handshakes/s  %.1f ns/op\n",
+           name, threads, (double)threads * iterations / slowest, per_thread_sum / threads,
+           1e9 * threads / per_thread_sum);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 1;
+    int iterations = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // 정확성 확인: RFC 6455 예제
+    char accept_key[WEBSOCKET_ACCEPT_KEY_LEN + 1];
+    generate_websocket_accept_key("dGhlIHNhbXBsZSBub25jZQ==", accept_key);
+    if (strcmp(accept_key, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != 0) {
+        fprintf(stderr, "Accept 키 불일치: %s\n", accept_key);
+        return 1;
+    }
+
+    run("legacy", threads, iterations, 1);
+    run("fast", threads, iterations, 0);
+    return 0;
+}
@@ -0,0 +1,647 @@
+// 서버 핫 패스 마이크로벤치마크
+// 사용법: ./bench/micro_bench [-f 이름 필터] [-s 배율] [-i 기록된 메세지 파일]
+//   -f: 이름에 필터 문자열이 들어간 벤치마크만 실행
+//   -s: 반복 횟수 배율 (기본 1.0)
+//   -i: 클라이언트가 보낸 메세지를 한 줄에 하나씩 담은 파일 (process_json 등을 실제 입력으로도 잰다)
+//       브라우저 콘솔의 'send:' 로그를 모아서 만들 수 있다
+//
+// 결과는 ns/op, allocs/op(malloc/calloc/realloc 호출 수), 처리량(MB/s, ops/s)
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "canvas.h"
+#include "client_manager.h"
+#include "http_parser.h"
+#include "parsing_json.h"
+#include "rate_limit.h"
+#include "save_canvas.h"
+#include "task_queue.h"
+#include "timer_wheel.h"
+#include "websocket_frame.h"
+#include "websocket_handshake.h"
+
+#define BENCH_MESSAGES 1024         // 합성 입력 메세지 수
+#define BENCH_WIDTH 500
+#define BENCH_HEIGHT 500
+
+// ---- 할당 횟수 집계 (glibc malloc을 감싸서 이 스레드의 호출 수를 센다) ----
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static __thread unsigned long alloc_count = 0;
+
+void *malloc(size_t size) {
+    alloc_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    alloc_count++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+// ---- 측정/출력 ----
+
+typedef struct {
+    unsigned long start_ns;
+    unsigned long start_allocs;
+    unsigned long elapsed_ns;       // 누적 (구간을 여러 번 잴 수 있다)
+    unsigned long allocs;
+} Measure;
+
+static const char *filter = NULL;
+static double scale = 1.0;
+
+static unsigned long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static bool selected(const char *name) {
+    return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static unsigned long scaled(unsigned long iterations) {
+    unsigned long n = (unsigned long)(iterations * scale);
+    return n > 0 ? n : 1;
+}
+
+static void measure_start(Measure *m) {
+    m->start_allocs = alloc_count;
+    m->start_ns = now_ns();
+}
+
+static void measure_stop(Measure *m) {
+    m->elapsed_ns += now_ns() - m->start_ns;
+    m->allocs += alloc_count - m->start_allocs;
+}
+
+static void report(const char *name, const char *input, Measure *m, unsigned long ops, double bytes) {
+    double ns_per_op = (double)m->elapsed_ns / ops;
+    double seconds = m->elapsed_ns / 1e9;
+    printf("%-30s %-14s %12.1f ns/op %10.2f allocs/op %10.1f MB/s %14.0f ops/s\n",
+           name, input, ns_per_op, (double)m->allocs / ops,
+           bytes > 0 ? bytes / seconds / 1e6 : 0.0, ops / seconds);
+}
+
+// 측정 중 서버 코드의 printf 출력 숨기기
+static int saved_stdout = -1;
+
+static void mute_stdout(void) {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+}
+
+static void restore_stdout(void) {
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+}
+
+// ---- 입력 ----
+
+typedef struct {
+    char **items;
+    size_t *lens;
+    int count;
+    const char *name;
+} Inputs;
+
+static void synthetic_messages(Inputs *in) {
+    in->items = malloc(sizeof(char *) * BENCH_MESSAGES);
+    in->lens = malloc(sizeof(size_t) * BENCH_MESSAGES);
+    in->count = BENCH_MESSAGES;
+    in->name = "synthetic";
+    unsigned int seed = 12345;
+    for (int i = 0; i < BENCH_MESSAGES; i++) {
+        char buf[96];
+        int len = snprintf(buf, sizeof(buf), "{\"pixel\":{\"x\":%d,\"y\":%d,\"color\":\"#%06x\"}}",
+                           rand_r(&seed) % BENCH_WIDTH, rand_r(&seed) % BENCH_HEIGHT, rand_r(&seed) & 0xFFFFFF);
+        in->items[i] = strdup(buf);
+        in->lens[i] = (size_t)len;
+    }
+}
+
+static bool recorded_messages(Inputs *in, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("입력 파일 열기 실패");
+        return false;
+    }
+    int capacity = 256;
+    in->items = malloc(sizeof(char *) * capacity);
+    in->lens = malloc(sizeof(size_t) * capacity);
+    in->count = 0;
+    in->name = "recorded";
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    while ((len = getline(&line, &line_cap, file)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        if (in->count == capacity) {
+            capacity *= 2;
+            in->items = realloc(in->items, sizeof(char *) * capacity);
+            in->lens = realloc(in->lens, sizeof(size_t) * capacity);
+        }
+        in->items[in->count] = strdup(line);
+        in->lens[in->count] = (size_t)len;
+        in->count++;
+    }
+    free(line);
+    fclose(file);
+    if (in->count == 0) {
+        fprintf(stderr, "입력 파일이 비어 있습니다: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+// ---- 벤치마크용 캔버스/매니저 (스레드 없이 구조체만 채운다) ----
+
+static TaskQueue bench_queue;
+static ClientManager bench_manager;
+static Canvas bench_canvas;
+
+static void setup_fixtures(void) {
+    init_task_queue(&bench_queue, 1024, "bench");
+    memset(&bench_manager, 0, sizeof(bench_manager));
+    bench_manager.queue = &bench_queue;
+    bench_manager.canvas_queue = &bench_queue;
+    pthread_spin_init(&bench_manager.lock, PTHREAD_PROCESS_PRIVATE);
+
+    memset(&bench_canvas, 0, sizeof(bench_canvas));
+    bench_canvas.cm = &bench_manager;
+    bench_canvas.queue = &bench_queue;
+    bench_canvas.canvas_width = BENCH_WIDTH;
+    bench_canvas.canvas_height = BENCH_HEIGHT;
+    bench_canvas.pixels = malloc(sizeof(Pixel) * BENCH_WIDTH * BENCH_HEIGHT);
+    for (int i = 0; i < BENCH_WIDTH * BENCH_HEIGHT; i++) {
+        bench_canvas.pixels[i].x = i % BENCH_WIDTH;
+        bench_canvas.pixels[i].y = i / BENCH_WIDTH;
+        strcpy(bench_canvas.pixels[i].color, "#FFFFFF");
+    }
+    bench_canvas.modified_pixels = NULL;
+}
+
+static void clear_modified_pixels(void) {
+    ModifiedPixel *p, *tmp;
+    HASH_ITER(hh, bench_canvas.modified_pixels, p, tmp) {
+        HASH_DEL(bench_canvas.modified_pixels, p);
+        free(p);
+    }
+}
+
+// 벤치마크가 큐에 넣은 작업 정리
+static void drain_queue(void) {
+    while (task_queue_depth(&bench_queue) > 0) {
+        Task task = pop_task(&bench_queue);
+        free(task.data);
+    }
+}
+
+// 클라이언트가 보내는 마스킹된 텍스트 frame
+static size_t build_masked_frame(const char *payload, size_t len, uint8_t *out) {
+    static const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    size_t off = 0;
+    out[off++] = 0x81;
+    if (len < 126) {
+        out[off++] = 0x80 | (uint8_t)len;
+    } else {
+        out[off++] = 0x80 | 126;
+        out[off++] = (uint8_t)(len >> 8);
+        out[off++] = (uint8_t)len;
+    }
+    memcpy(out + off, mask, 4);
+    off += 4;
+    for (size_t i = 0; i < len; i++) {
+        out[off + i] = (uint8_t)payload[i] ^ mask[i % 4];
+    }
+    return off + len;
+}
+
+// ---- 벤치마크 ----
+
+static void bench_create_websocket_frame(void) {
+    const char *name = "create_websocket_frame";
+    if (!selected(name)) return;
+
+    static const struct { size_t size; const char *label; unsigned long iterations; } cases[] = {
+        {64, "64B", 2000000},
+        {4096, "4KB", 500000},
+        {1024 * 1024, "1MB", 2000},
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        uint8_t *payload = malloc(cases[c].size);
+        memset(payload, 'a', cases[c].size);
+        unsigned long ops = scaled(cases[c].iterations);
+        Measure m = {0};
+        measure_start(&m);
+        for (unsigned long i = 0; i < ops; i++) {
+            size_t frame_len;
+            uint8_t *frame = create_websocket_frame(payload, cases[c].size, &frame_len);
+            free(frame);
+        }
+        measure_stop(&m);
+        report(name, cases[c].label, &m, ops, (double)cases[c].size * ops);
+        free(payload);
+    }
+}
+
+static void bench_process_websocket_frame(Inputs *in) {
+    const char *name = "process_websocket_frame";
+    if (!selected(name)) return;
+
+    // 디마스킹이 제자리에서 일어나므로 매번 원본 frame을 복사해서 넘긴다 (복사 비용 포함)
+    uint8_t **frames = malloc(sizeof(uint8_t *) * in->count);
+    size_t *frame_lens = malloc(sizeof(size_t) * in->count);
+    double total_bytes = 0;
+    for (int i = 0; i < in->count; i++) {
+        frames[i] = malloc(in->lens[i] + 14);
+        frame_lens[i] = build_masked_frame(in->items[i], in->lens[i], frames[i]);
+    }
+    char scratch[REQUEST_BUFFER_SIZE];
+
+    unsigned long ops = scaled(1000000);
+    Measure m = {0};
+    for (unsigned long i = 0; i < ops; i++) {
+        int k = i % in->count;
+        if (frame_lens[k] > sizeof(scratch)) continue;
+        measure_start(&m);
+        memcpy(scratch, frames[k], frame_lens[k]);
+        process_websocket_frame(&bench_manager, 0, 0, scratch, frame_lens[k], 0);
+        Task task = pop_task(&bench_queue);
+        free(task.data);
+        measure_stop(&m);
+        total_bytes += frame_lens[k];
+    }
+    report(name, in->name, &m, ops, total_bytes);
+
+    for (int i = 0; i < in->count; i++) {
+        free(frames[i]);
+    }
+    free(frames);
+    free(frame_lens);
+}
+
+static void bench_parse_pixel_json(Inputs *in) {
+    const char *name = "parse_pixel_json";
+    if (!selected(name)) return;
+
+    unsigned long ops = scaled(1000000);
+    double total_bytes = 0;
+    Measure m = {0};
+    measure_start(&m);
+    for (unsigned long i = 0; i < ops; i++) {
+        int k = i % in->count;
+        Pixel *pixel = parse_pixel_json(in->items[k]);
+        free(pixel);
+        total_bytes += in->lens[k];
+    }
+    measure_stop(&m);
+    report(name, in->name, &m, ops, total_bytes);
+}
+
+static void bench_process_json(Inputs *in) {
+    const char *name = "process_json";
+    if (!selected(name)) return;
+
+    unsigned long ops = scaled(1000000);
+    double total_bytes = 0;
+    Measure m = {0};
+    measure_start(&m);
+    for (unsigned long i = 0; i < ops; i++) {
+        int k = i % in->count;
+        process_json(&bench_canvas, 0, in->items[k], in->lens[k], 0);
+        total_bytes += in->lens[k];
+    }
+    measure_stop(&m);
+    report(name, in->name, &m, ops, total_bytes);
+    clear_modified_pixels();
+}
+
+static void bench_trans_canvas_as_json(void) {
+    const char *name = "trans_canvas_as_json";
+    if (!selected(name)) return;
+
+    unsigned long ops = scaled(20);
+    double total_bytes = 0;
+    Measure m = {0};
+    mute_stdout();
+    for (unsigned long i = 0; i < ops; i++) {
+        measure_start(&m);
+        char *json = trans_canvas_as_json(&bench_canvas);
+        measure_stop(&m);
+        total_bytes += strlen(json);
+        free(json);
+    }
+    restore_stdout();
+    report(name, "500x500", &m, ops, total_bytes);
+}
+
+static void bench_broadcast_updates(void) {
+    const char *name = "broadcast_updates";
+    if (!selected(name)) return;
+
+    static const struct { int dirty; const char *label; unsigned long iterations; } cases[] = {
+        {10, "10 dirty", 100000},
+        {100, "100 dirty", 20000},
+        {1000, "1000 dirty", 2000},
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        unsigned long ops = scaled(cases[c].iterations);
+        double total_bytes = 0;
+        Measure m = {0};
+        for (unsigned long i = 0; i < ops; i++) {
+            // 틱 사이에 칠해진 픽셀 (측정 밖에서 채운다)
+            for (int d = 0; d < cases[c].dirty; d++) {
+                ModifiedPixel *p = malloc(sizeof(ModifiedPixel));
+                p->key = (int)((i * 7919 + d * 104729) % (BENCH_WIDTH * BENCH_HEIGHT));
+                strcpy(p->color, "#a1b2c3");
+                p->recv_ns = 0;
+                p->applied_ns = now_ns();
+                ModifiedPixel *found;
+                HASH_FIND_INT(bench_canvas.modified_pixels, &p->key, found);
+                if (found != NULL) {
+                    free(p);
+                    continue;
+                }
+                HASH_ADD_INT(bench_canvas.modified_pixels, key, p);
+            }
+            measure_start(&m);
+            broadcast_updates(&bench_canvas);
+            measure_stop(&m);
+            Task task = pop_task(&bench_queue);
+            total_bytes += task.data_len;
+            free(task.data);
+        }
+        report(name, cases[c].label, &m, ops, total_bytes);
+    }
+}
+
+typedef struct {
+    unsigned long count;
+} ProducerArgs;
+
+static TaskQueue contention_queue;
+
+// 종료 표시(TASK_BROADCAST)를 받을 때까지 꺼낸다 (픽셀 작업과 같은 레인이라 순서대로 온다)
+static void *consumer_thread(void *arg) {
+    unsigned long *popped = (unsigned long *)arg;
+    while (1) {
+        Task task = pop_task(&contention_queue);
+        if (task.type == TASK_BROADCAST) {
+            break;
+        }
+        (*popped)++;
+    }
+    return NULL;
+}
+
+static void *producer_thread(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
+    for (unsigned long i = 0; i < args->count; i++) {
+        Task task = {0, TASK_PIXEL_UPDATE, NULL, 0, 0, 0};
+        push_task(&contention_queue, task);
+    }
+    return NULL;
+}
+
+static void bench_task_queue(void) {
+    const char *name = "push_task/pop_task";
+    if (!selected(name)) return;
+
+    static const int producer_counts[] = {1, 2, 4, 8};
+    for (size_t c = 0; c < sizeof(producer_counts) / sizeof(producer_counts[0]); c++) {
+        int producers = producer_counts[c];
+        // 드롭 없이 락 경합만 재도록 전체 작업이 들어갈 크기로 만든다
+        ProducerArgs args = {scaled(1000000) / producers};
+        init_task_queue(&contention_queue, (int)(args.count * producers) + 2, "contention");
+        pthread_t tids[8], consumer;
+        unsigned long popped = 0;
+
+        Measure m = {0};
+        measure_start(&m);
+        pthread_create(&consumer, NULL, consumer_thread, &popped);
+        for (int p = 0; p < producers; p++) {
+            pthread_create(&tids[p], NULL, producer_thread, &args);
+        }
+        for (int p = 0; p < producers; p++) {
+            pthread_join(tids[p], NULL);
+        }
+        // 큐가 가득 차서 종료 표시가 버려지면 다시 넣는다
+        Task done = {0, TASK_BROADCAST, NULL, 0, 0, 0};
+        unsigned long pushed = atomic_load(&contention_queue.pushed);
+        do {
+            push_task(&contention_queue, done);
+        } while (atomic_load(&contention_queue.pushed) == pushed);
+        pthread_join(consumer, NULL);
+        measure_stop(&m);
+        m.allocs = 0;           // 생산자 스레드 생성에 쓰인 할당은 제외
+
+        char label[32];
+        snprintf(label, sizeof(label), "%dP/1C", producers);
+        report(name, label, &m, popped, 0);
+        if (atomic_load(&contention_queue.dropped) > 0) {
+            printf("%-30s %-14s dropped %lu\n", "", label, atomic_load(&contention_queue.dropped));
+        }
+        pthread_mutex_destroy(&contention_queue.lock);
+        pthread_cond_destroy(&contention_queue.cond);
+        for (int lane = 0; lane < TASK_LANE_COUNT; lane++) {
+            free(contention_queue.lanes[lane].tasks);
+            free(contention_queue.lanes[lane].enqueue_ns);
+        }
+    }
+}
+
+static void bench_http_parsing(void) {
+    const char *name = "http_parsing";
+    if (!selected(name)) return;
+
+    static const char request[] =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: ko-KR,ko;q=0.9,en-US;q=0.8\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+    // http_parsing은 입력을 잘라가며 파싱하므로 매번 복사본을 넘긴다
+    char buffer[sizeof(request)];
+    static HttpRequest parsed;
+
+    unsigned long ops = scaled(500000);
+    Measure m = {0};
+    measure_start(&m);
+    for (unsigned long i = 0; i < ops; i++) {
+        memcpy(buffer, request, sizeof(request));
+        http_parsing(buffer, &parsed);
+    }
+    measure_stop(&m);
+    report(name, "browser GET", &m, ops, (double)(sizeof(request) - 1) * ops);
+}
+
+static void bench_rate_limit(void) {
+    const char *name = "rate_limit_check";
+    if (!selected(name)) return;
+
+    // 연결 512개가 IP 64개를 나눠 쓰고, 메세지는 1us 간격으로 돌아가며 도착한다
+    enum { CONNS = 512, IPS = 64 };
+    static const struct {
+        const char *label;
+        double rate;
+    } cases[] = {
+        {"allow", 1e9},     // 모두 통과 (두 버킷 모두 갱신)
+        {"drop", 1},        // 버스트 이후 모두 버림
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        rate_limit_configure(cases[c].rate, cases[c].rate, cases[c].rate, cases[c].rate, 0);
+        for (int fd = 0; fd < CONNS; fd++) {
+            rate_limit_register_ip(fd, 0x0a000001 + fd % IPS);
+        }
+
+        unsigned long ops = scaled(5000000);
+        unsigned long now = 1000000000UL, allowed = 0;
+        Measure m = {0};
+        measure_start(&m);
+        for (unsigned long i = 0; i < ops; i++) {
+            now += 1000;
+            allowed += rate_limit_check((int)(i % CONNS), now) == RATE_ALLOW;
+        }
+        measure_stop(&m);
+        report(name, cases[c].label, &m, ops, 0);
+        printf("%-30s %-14s allowed %lu/%lu\n", "", cases[c].label, allowed, ops);
+    }
+    rate_limit_configure(0, 0, 0, 0, 0);
+}
+
+// 만료된 타이머를 30 tick 뒤로 다시 예약 (ping 주기처럼)
+static void rearm_timer(TimerNode *node, void *arg) {
+    TimerWheel *wheel = (TimerWheel *)arg;
+    timer_schedule(wheel, node, wheel->now + 30);
+}
+
+static void bench_timer_wheel(void) {
+    const char *name = "timer_wheel";
+    if (!selected(name)) return;
+
+    // 연결 10만 개의 타이머를 60 tick에 고르게 흩어 놓는다
+    enum { TIMERS = 100000, SPREAD = 60 };
+    static TimerWheel wheel;
+    TimerNode *nodes = (TimerNode *)calloc(TIMERS, sizeof(TimerNode));
+    timer_wheel_init(&wheel, 0);
+
+    unsigned long rounds = scaled(20);
+    Measure m = {0};
+    measure_start(&m);
+    for (unsigned long r = 0; r < rounds; r++) {
+        for (int i = 0; i < TIMERS; i++) {
+            timer_schedule(&wheel, &nodes[i], wheel.now + 1 + (unsigned long)(i * 7919) % SPREAD);
+        }
+        for (int i = 0; i < TIMERS; i++) {
+            timer_cancel(&wheel, &nodes[i]);
+        }
+    }
+    measure_stop(&m);
+    report(name, "schedule+cancel", &m, rounds * TIMERS, 0);
+
+    // 매 tick 1/60씩 만료되고 다시 예약된다
+    for (int i = 0; i < TIMERS; i++) {
+        timer_schedule(&wheel, &nodes[i], wheel.now + 1 + (unsigned long)(i * 7919) % SPREAD);
+    }
+    unsigned long ticks = scaled(600), fired = 0;
+    measure_start(&m);
+    for (unsigned long t = 0; t < ticks; t++) {
+        fired += timer_wheel_advance(&wheel, wheel.now + 1, rearm_timer, &wheel);
+    }
+    measure_stop(&m);
+    report(name, "advance 100k", &m, fired, 0);
+    printf("%-30s %-14s %lu ticks, %.0f timers/tick\n", "", "advance 100k", ticks, (double)fired / ticks);
+    free(nodes);
+}
+
+static void bench_generate_websocket_accept_key(void) {
+    const char *name = "generate_websocket_accept_key";
+    if (!selected(name)) return;
+
+    char client_key[32];
+    char accept_key[WEBSOCKET_ACCEPT_KEY_LEN + 1];
+    unsigned long ops = scaled(1000000);
+    Measure m = {0};
+    measure_start(&m);
+    for (unsigned long i = 0; i < ops; i++) {
+        snprintf(client_key, sizeof(client_key), "dGhlIHNhbXBsZSBub%07lu==", i % 10000000);
+        generate_websocket_accept_key(client_key, accept_key);
+    }
+    measure_stop(&m);
+    report(name, "24B key", &m, ops, 0);
+}
+
+int main(int argc, char *argv[]) {
+
+    const char *recorded_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:i:")) != -1) {
+        switch (opt) {
+            case 'f': filter = optarg; break;
+            case 's': scale = atof(optarg); break;
+            case 'i': recorded_path = optarg; break;
+            default:
+                fprintf(stderr, "사용법: %s [-f 이름 필터] [-s 배율] [-i 기록된 메세지 파일]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    setup_fixtures();
+    Inputs synthetic;
+    synthetic_messages(&synthetic);
+    Inputs recorded = {0};
+    bool has_recorded = recorded_path != NULL && recorded_messages(&recorded, recorded_path);
+
+    // 스레드별 메트릭 메모리처럼 처음 한 번만 일어나는 할당을 미리 끝낸다
+    process_json(&bench_canvas, 0, synthetic.items[0], synthetic.lens[0], 0);
+    clear_modified_pixels();
+
+    printf("%-30s %-14s %18s %20s %15s %20s\n", "benchmark", "input", "time", "allocs", "throughput", "rate");
+
+    bench_create_websocket_frame();
+    bench_process_websocket_frame(&synthetic);
+    if (has_recorded) bench_process_websocket_frame(&recorded);
+    bench_parse_pixel_json(&synthetic);
+    if (has_recorded) bench_parse_pixel_json(&recorded);
+    bench_process_json(&synthetic);
+    if (has_recorded) bench_process_json(&recorded);
+    bench_trans_canvas_as_json();
+    bench_broadcast_updates();
+    bench_task_queue();
+    bench_http_parsing();
+    bench_rate_limit();
+    bench_timer_wheel();
+    bench_generate_websocket_accept_key();
+
+    drain_queue();
+    return 0;
+}
@@ -0,0 +1,640 @@
+// 소켓 없는 파이프라인 시뮬레이션 벤치마크
+// 리슨 소켓 없이 Context(메인 이벤트 루프, CM, 캔버스 스레드)를 띄우고, 클라이언트마다 AF_UNIX socketpair를 만들어
+// 서버 쪽 끝을 TASK_REGISTER_CLIENT로 등록한다. 드라이버(이 프로그램의 main 스레드)가 핸드셰이크, 픽셀 frame,
+// 접속 종료를 정해진 속도로 넣고, 서버가 보낸 바이트를 모두 읽어서 센다.
+// TCP 스택, NIC, 브라우저가 빠지므로 캔버스/CM 코어만의 처리량과 지연 시간을 잴 수 있다.
+// 좌표는 캔버스 칸을 차례대로, 색은 시드로 정해지므로 같은 옵션이면 같은 입력이 들어간다.
+//
+// 사용법: ./bench/sim_bench [-c 연결 수] [-P painter 수] [-r painter당 초당 픽셀(0이면 최대 속도)]
+//                          [-d 실행 시간(초)] [-R 초당 연결 수(0이면 한 번에)] [-k 초당 재접속 수] [-s 시드]
+//                          [-F 브로드캐스트 송신 스레드 수(FAINTER_FANOUT_THREADS, 0이면 CM이 직접)]
+//                          [-B 한 번에 보내는 frame 수 점검(0이면 생략)]
+//
+// 출력: 드라이버 쪽 측정(참여 지연, 픽셀 전달 지연, 수신 바이트)과 서버 히스토그램(metrics.h)
+// 송신 스레드 수에 따른 틱 -> 마지막 바이트 지연은 -F를 바꿔 가며 fanout, end_to_end 히스토그램을 비교한다.
+// 페인트 중에 보낸 브로드캐스트가 기대 틱 수의 절반에 못 미치면 종료 코드 1
+// (참여/재접속과 페인트를 함께: -c 300 -P 50 -r 20 -d 5 -k 20, 스냅샷이 틱을 굶기지 않는지 확인).
+// 끝난 뒤 새 연결 하나로 -B개의 픽셀 frame을 send 한 번에 넣어, 속도 제한(초당 1개, 버스트 1)이 frame마다
+// 검사해서 N-1개를 버리는지, 제한을 끄고 frame 중간에서 나눠 보낸 N개가 모두 반영되는지 확인한다 (아니면 종료 코드 1).
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "client_manager.h"
+#include "context.h"
+#include "event_loop.h"
+#include "fanout.h"
+#include "histogram.h"
+#include "log.h"
+#include "metrics.h"
+#include "rate_limit.h"
+#include "task_queue.h"
+#include "trace.h"
+
+#define SIM_MAX_EVENTS 1024
+#define SIM_RECV_SIZE (64 * 1024)
+#define SIM_HEADER_MAX 4096             // 101 응답 헤더 최대 크기
+#define SIM_SEND_BATCH 64               // 최대 속도일 때 수신 확인 사이에 보내는 픽셀 수
+#define SIM_SNDBUF (4 * 1024 * 1024)     // 서버 쪽 송신 버퍼 (net.ipv4.tcp_wmem 최대치와 같게)
+#define SIM_SETTLE_NS 1500000000UL      // 끝난 뒤 마지막 브로드캐스트를 기다리는 시간
+#define SIM_TICK_MS 500                 // 캔버스 브로드캐스트 주기 (canvas.c)
+#define SIM_PIXEL_FRAME_MAX 128         // 픽셀 frame 하나의 최대 크기
+#define SIM_CHECK_TIMEOUT_NS 3000000000UL   // 점검에서 서버 카운터를 기다리는 시간
+
+static struct {
+    int connections;
+    int painters;
+    int rate;                   // painter당 초당 픽셀 (0이면 최대 속도)
+    int duration;
+    int join_rate;              // 초당 연결 수 (0이면 한 번에)
+    int churn;                  // 초당 끊고 다시 붙는 연결 수
+    int batch;                  // 끝난 뒤 send 한 번에 넣어 보는 frame 수 (0이면 생략)
+    unsigned int seed;
+} config = {
+    .connections = 100,
+    .painters = 10,
+    .rate = 100,
+    .duration = 5,
+    .join_rate = 0,
+    .churn = 0,
+    .batch = 16,
+    .seed = 1,
+};
+
+typedef enum {
+    SIM_IDLE,                   // 아직 연결 안 함
+    SIM_HANDSHAKE,              // 101 응답 대기
+    SIM_OPEN,                   // WebSocket 연결됨
+} SimState;
+
+typedef struct {
+    int fd;                     // 드라이버 쪽 끝
+    SimState state;
+    bool joined;                // 초기 캔버스 스냅샷을 다 받았는지
+    unsigned long join_ns;      // 등록 시각
+    unsigned char *buf;         // 받은 데이터 중 아직 처리 못한 부분
+    size_t len, cap;
+    unsigned long skip;         // 읽고 버릴 바이트 수 (스냅샷 본문)
+} SimConn;
+
+static Context ctx;
+static SimConn *conns;
+static int epoll_fd;
+static unsigned long *sent_ns;  // 칸별 마지막으로 칠한 시각 (전달 지연 계산)
+static int width = CANVAS_WIDTH, height = CANVAS_HEIGHT;
+
+static Histogram join_latency, delivery_latency;
+static unsigned long bytes_in = 0, frames_in = 0, deliveries = 0;
+static unsigned long pixels_sent = 0, send_failed = 0, joins = 0, leaves = 0, lost = 0;
+static unsigned long paint_cursor = 0;
+static unsigned int rng_state;
+
+static unsigned int next_random(void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void *event_loop_thread(void *arg) {
+    trace_set_thread_name("main");
+    event_loop_run((Context *)arg);
+    return NULL;
+}
+
+// ---- 연결 ----
+
+static bool append(SimConn *c, const unsigned char *data, size_t n) {
+    if (c->len + n > c->cap) {
+        size_t cap = c->cap ? c->cap : 4096;
+        while (cap < c->len + n) {
+            cap *= 2;
+        }
+        unsigned char *buf = realloc(c->buf, cap);
+        if (buf == NULL) {
+            return false;
+        }
+        c->buf = buf;
+        c->cap = cap;
+    }
+    memcpy(c->buf + c->len, data, n);
+    c->len += n;
+    return true;
+}
+
+// socketpair를 만들어 서버 쪽 끝을 CM에 등록하고 핸드셰이크 요청을 보낸다
+static void sim_join(SimConn *c) {
+
+    // 서버는 스냅샷(약 2.5MB)을 send 한 번으로 보낸다. TCP는 송신 버퍼가 커서 한 번에 들어가지만
+    // AF_UNIX는 기본 버퍼가 작아서 논블로킹이면 잘린다. 그래서 서버 쪽 끝은 블로킹으로 두고
+    // (이벤트 루프는 MSG_DONTWAIT로 읽는다) 송신 버퍼는 TCP 자동 조정 최대치만큼 키운다.
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == -1) {
+        perror("socketpair");
+        exit(1);
+    }
+    int sndbuf = SIM_SNDBUF;
+    if (setsockopt(pair[1], SOL_SOCKET, SO_SNDBUFFORCE, &sndbuf, sizeof(sndbuf)) == -1) {
+        setsockopt(pair[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    }
+    set_nonblocking(pair[0]);
+    c->fd = pair[0];
+    c->state = SIM_HANDSHAKE;
+    c->joined = false;
+    c->len = 0;
+    c->skip = 0;
+    c->join_ns = monotonic_ns();
+
+    // 등록 작업이 먼저 큐에 들어가므로 CM은 요청보다 클라이언트를 먼저 알게 된다
+    Task task = {pair[1], TASK_REGISTER_CLIENT, NULL, 0, 0, 0};
+    push_task(ctx.cm->queue, task);
+
+    static const char request[] =
+        "GET / HTTP/1.1\r\nHost: sim\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (send(c->fd, request, sizeof(request) - 1, MSG_NOSIGNAL) != (ssize_t)(sizeof(request) - 1)) {
+        perror("핸드셰이크 요청");
+        exit(1);
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+    joins++;
+}
+
+// 드라이버 쪽 끝을 닫는다 (서버는 EOF를 보고 TASK_CLIENT_CLOSE)
+static void sim_leave(SimConn *c) {
+    if (c->state == SIM_IDLE) {
+        return;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->state = SIM_IDLE;
+    c->len = 0;
+    leaves++;
+}
+
+// ---- 수신 ----
+
+// "key":숫자 를 찾아 값을 읽는다 (못 찾으면 NULL)
+static const unsigned char *json_number(const unsigned char *p, const unsigned char *end,
+                                        const char *key, size_t key_len, unsigned long *value) {
+
+    p = memmem(p, end - p, key, key_len);
+    if (p == NULL) {
+        return NULL;
+    }
+    p += key_len;
+    if (p >= end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    unsigned long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (unsigned long)(*p - '0');
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// {"client_count":N,"updated_pixel":[{"x":..,"y":..,"color":".."},...]}
+static void record_deliveries(const unsigned char *payload, size_t len) {
+
+    unsigned long now = monotonic_ns();
+    const unsigned char *p = payload, *end = payload + len;
+    unsigned long x, y;
+    while ((p = json_number(p, end, "\"x\":", 4, &x)) != NULL &&
+           (p = json_number(p, end, "\"y\":", 4, &y)) != NULL) {
+        if (x >= (unsigned long)width || y >= (unsigned long)height) {
+            continue;
+        }
+        unsigned long sent = sent_ns[y * width + x];
+        if (sent != 0 && sent <= now) {
+            histogram_record(&delivery_latency, now - sent);
+            deliveries++;
+        }
+    }
+}
+
+static void record_join(SimConn *c) {
+    histogram_record(&join_latency, monotonic_ns() - c->join_ns);
+    c->joined = true;
+}
+
+// 버퍼에 쌓인 frame 처리 (첫 frame은 스냅샷이라 본문을 읽고 버린다)
+static void process_frames(SimConn *c) {
+
+    size_t off = 0;
+    while (c->len - off >= 2) {
+        const unsigned char *p = c->buf + off;
+        size_t header = 2;
+        unsigned long payload = p[1] & 0x7F;
+        if (payload == 126) {
+            if (c->len - off < 4) break;
+            payload = ((unsigned long)p[2] << 8) | p[3];
+            header = 4;
+        } else if (payload == 127) {
+            if (c->len - off < 10) break;
+            payload = 0;
+            for (int i = 0; i < 8; i++) {
+                payload = (payload << 8) | p[2 + i];
+            }
+            header = 10;
+        }
+
+        if (!c->joined) {
+            frames_in++;
+            size_t available = c->len - off - header;
+            if (available < payload) {
+                c->skip = payload - available;     // 나머지는 on_data에서 버린다
+                off = c->len;
+                break;
+            }
+            record_join(c);
+            off += header + payload;
+            continue;
+        }
+
+        if (c->len - off - header < payload) {
+            break;
+        }
+        frames_in++;
+        if ((p[0] & 0x0F) == 0x1) {
+            record_deliveries(p + header, payload);
+        }
+        off += header + payload;
+    }
+    memmove(c->buf, c->buf + off, c->len - off);
+    c->len -= off;
+}
+
+static void on_data(SimConn *c, const unsigned char *data, size_t n) {
+
+    if (c->skip > 0) {
+        size_t skipped = n < c->skip ? n : c->skip;
+        c->skip -= skipped;
+        data += skipped;
+        n -= skipped;
+        if (c->skip == 0) {
+            record_join(c);
+        }
+    }
+    if (n == 0 || !append(c, data, n)) {
+        return;
+    }
+
+    if (c->state == SIM_HANDSHAKE) {
+        unsigned char *end = memmem(c->buf, c->len, "\r\n\r\n", 4);
+        if (end == NULL) {
+            if (c->len > SIM_HEADER_MAX) {
+                lost++;
+                sim_leave(c);
+            }
+            return;
+        }
+        if (c->len < 12 || memcmp(c->buf, "HTTP/1.1 101", 12) != 0) {
+            lost++;
+            sim_leave(c);
+            return;
+        }
+        size_t header_len = end + 4 - c->buf;
+        memmove(c->buf, c->buf + header_len, c->len - header_len);
+        c->len -= header_len;
+        c->state = SIM_OPEN;
+    }
+    process_frames(c);
+}
+
+// 서버가 보낸 데이터를 읽는다
+static void drain(int timeout_ms) {
+
+    static unsigned char buffer[SIM_RECV_SIZE];
+    struct epoll_event events[SIM_MAX_EVENTS];
+    int n = epoll_wait(epoll_fd, events, SIM_MAX_EVENTS, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        SimConn *c = events[i].data.ptr;
+        while (c->state != SIM_IDLE) {
+            ssize_t len = recv(c->fd, buffer, sizeof(buffer), 0);
+            if (len > 0) {
+                bytes_in += len;
+                on_data(c, buffer, len);
+                continue;
+            }
+            if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                lost++;         // 서버가 끊었다
+                sim_leave(c);
+            }
+            break;
+        }
+    }
+}
+
+// ---- 송신 ----
+
+// 칸 하나를 칠하는 픽셀 frame (frame 길이)
+static int encode_pixel(unsigned char *frame, unsigned long cell, unsigned int color) {
+
+    char payload[96];
+    int len = snprintf(payload, sizeof(payload), "{\"pixel\":{\"x\":%lu,\"y\":%lu,\"color\":\"#%06x\"}}",
+                       cell % width, cell / width, color);
+
+    // 클라이언트 frame은 마스킹해야 한다
+    static const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame[0] = 0x81;
+    frame[1] = 0x80 | (unsigned char)len;
+    memcpy(frame + 2, mask, 4);
+    for (int i = 0; i < len; i++) {
+        frame[6 + i] = payload[i] ^ mask[i % 4];
+    }
+    return 6 + len;
+}
+
+// socketpair 버퍼가 차서(서버가 못 따라와서) 못 보냈으면 false
+static bool send_pixel(SimConn *c) {
+
+    unsigned long cell = paint_cursor++ % ((unsigned long)width * height);
+    unsigned char frame[SIM_PIXEL_FRAME_MAX];
+    int len = encode_pixel(frame, cell, next_random() & 0xFFFFFF);
+
+    unsigned long now = monotonic_ns();
+    if (send(c->fd, frame, len, MSG_NOSIGNAL) != len) {
+        paint_cursor--;
+        return false;
+    }
+    sent_ns[cell] = now;
+    pixels_sent++;
+    return true;
+}
+
+// ---- 한 번에 여러 frame ----
+
+// 서버 카운터가 target에 닿을 때까지 받으면서 기다린다 (시간 초과면 false)
+static bool wait_metric(MetricId id, unsigned long target) {
+    unsigned long deadline = monotonic_ns() + SIM_CHECK_TIMEOUT_NS;
+    while (metrics_total(id) < target) {
+        if (monotonic_ns() > deadline) {
+            return false;
+        }
+        drain(1);
+    }
+    return true;
+}
+
+// 픽셀 frame count개를 이어 붙여서 send 한 번에 (split_frame이 0 이상이면 그 frame의 헤더 중간에서 두 번으로 나눈다)
+static bool send_batch(SimConn *c, unsigned long first_cell, int count, int split_frame) {
+
+    unsigned char *buffer = malloc((size_t)count * SIM_PIXEL_FRAME_MAX);
+    if (buffer == NULL) {
+        return false;
+    }
+    size_t len = 0, split = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == split_frame) {
+            split = len + 3;
+        }
+        len += encode_pixel(buffer + len, (first_cell + i) % ((unsigned long)width * height), next_random() & 0xFFFFFF);
+    }
+    size_t first = split > 0 ? split : len;
+    bool ok = send(c->fd, buffer, first, MSG_NOSIGNAL) == (ssize_t)first &&
+              (first == len || send(c->fd, buffer + first, len - first, MSG_NOSIGNAL) == (ssize_t)(len - first));
+    free(buffer);
+    return ok;
+}
+
+// recv 한 번에 frame 여러 개: 메인 스레드가 frame마다 나누고, 속도 제한도 frame마다 검사하는지
+static int check_batch(int count) {
+
+    // 속도 제한을 켠 뒤에 붙어야 새 연결로 등록된다 (초당 1개, 버스트 1: 같은 순간의 나머지는 모두 초과)
+    rate_limit_configure(1, 1, 0, 0, 0);
+    SimConn probe = {.fd = -1};
+    sim_join(&probe);
+    unsigned long deadline = monotonic_ns() + SIM_CHECK_TIMEOUT_NS;
+    while (probe.state != SIM_IDLE && !probe.joined && monotonic_ns() < deadline) {
+        drain(1);
+    }
+    if (!probe.joined) {
+        printf("frame 묶음: 점검 연결이 참여하지 못함\n");
+        rate_limit_configure(0, 0, 0, 0, 0);
+        sim_leave(&probe);
+        free(probe.buf);
+        return 1;
+    }
+
+    // 1. send 한 번에 count개: 검사도 count번 (처음 하나만 통과)
+    unsigned long applied = metrics_total(METRIC_PIXELS_APPLIED);
+    unsigned long limited = metrics_total(METRIC_RATE_LIMITED);
+    bool sent = send_batch(&probe, 0, count, -1);
+    wait_metric(METRIC_RATE_LIMITED, limited + count - 1);
+    wait_metric(METRIC_PIXELS_APPLIED, applied + 1);
+    unsigned long settle = monotonic_ns() + SIM_SETTLE_NS / 10;
+    while (monotonic_ns() < settle) {
+        drain(1);
+    }
+    unsigned long charged_limited = metrics_total(METRIC_RATE_LIMITED) - limited;
+    unsigned long charged_applied = metrics_total(METRIC_PIXELS_APPLIED) - applied;
+    rate_limit_configure(0, 0, 0, 0, 0);
+
+    // 2. 제한 없이 가운데 frame 중간에서 나눠 보낸 count개: 모두 반영
+    applied = metrics_total(METRIC_PIXELS_APPLIED);
+    sent = send_batch(&probe, count, count, count / 2) && sent;
+    wait_metric(METRIC_PIXELS_APPLIED, applied + count);
+    unsigned long split_applied = metrics_total(METRIC_PIXELS_APPLIED) - applied;
+    sim_leave(&probe);
+    free(probe.buf);
+
+    printf("frame 묶음 %d개: 속도 제한 버림 %lu (기대 %d), 반영 %lu (기대 1), 나눠 보낸 뒤 반영 %lu (기대 %d)\n",
+           count, charged_limited, count - 1, charged_applied, split_applied, count);
+    if (!sent || charged_limited != (unsigned long)count - 1 || charged_applied != 1 ||
+        split_applied != (unsigned long)count) {
+        printf("frame 묶음 점검 실패: 메인 스레드가 recv 단위가 아니라 frame 단위로 나누고 검사하는지 확인\n");
+        return 1;
+    }
+    return 0;
+}
+
+// ---- 실행 ----
+
+static void print_histogram(const char *name, Histogram *h) {
+    unsigned long count = atomic_load(&h->total);
+    printf("%-22s n=%-10lu mean=%9.3fms p50=%9.3fms p99=%9.3fms p999=%9.3fms\n", name, count,
+           count ? atomic_load(&h->sum) / 1e6 / count : 0.0,
+           histogram_percentile(h, 0.5) / 1e6, histogram_percentile(h, 0.99) / 1e6,
+           histogram_percentile(h, 0.999) / 1e6);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-c 연결 수] [-P painter 수] [-r painter당 초당 픽셀(0이면 최대)] [-d 실행 시간(초)]\n"
+                    "          [-R 초당 연결 수(0이면 한 번에)] [-k 초당 재접속 수] [-s 시드] [-F 송신 스레드 수]\n"
+                    "          [-B 한 번에 보내는 frame 수 점검(0이면 생략)]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:P:r:d:R:k:s:F:B:")) != -1) {
+        switch (opt) {
+            case 'c': config.connections = atoi(optarg); break;
+            case 'P': config.painters = atoi(optarg); break;
+            case 'r': config.rate = atoi(optarg); break;
+            case 'd': config.duration = atoi(optarg); break;
+            case 'R': config.join_rate = atoi(optarg); break;
+            case 'k': config.churn = atoi(optarg); break;
+            case 's': config.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'F': setenv("FAINTER_FANOUT_THREADS", optarg, 1); break;
+            case 'B': config.batch = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (config.connections <= 0 || config.painters < 0 || config.duration <= 0 || config.batch < 0) {
+        usage(argv[0]);
+    }
+    if (config.painters > config.connections) {
+        config.painters = config.connections;
+    }
+    rng_state = config.seed ? config.seed : 1;
+
+    // 서버 로그는 경고 이상만 (FAINTER_LOG_LEVEL로 바꿀 수 있다)
+    log_init();
+    if (getenv("FAINTER_LOG_LEVEL") == NULL) {
+        atomic_store(&log_level, LOG_LEVEL_WARN);
+    }
+    trace_init();
+    init_sim_context(&ctx);
+    pthread_t loop_tid;
+    pthread_create(&loop_tid, NULL, event_loop_thread, &ctx);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    conns = calloc(config.connections, sizeof(SimConn));
+    sent_ns = calloc((size_t)width * height, sizeof(unsigned long));
+    if (epoll_fd == -1 || conns == NULL || sent_ns == NULL) {
+        perror("초기화 실패");
+        return 1;
+    }
+    for (int i = 0; i < config.connections; i++) {
+        conns[i].fd = -1;
+    }
+    histogram_init(&join_latency);
+    histogram_init(&delivery_latency);
+
+    // 1. 참여: 모든 연결이 스냅샷을 받을 때까지
+    unsigned long join_start = monotonic_ns();
+    int opened = 0, joined = 0;
+    while (joined < config.connections) {
+        unsigned long elapsed = monotonic_ns() - join_start;
+        int due = config.join_rate > 0 ? (int)(elapsed * config.join_rate / 1000000000UL) + 1 : config.connections;
+        while (opened < config.connections && opened < due) {
+            sim_join(&conns[opened++]);
+        }
+        drain(1);
+        joined = 0;
+        for (int i = 0; i < opened; i++) {
+            joined += conns[i].joined;
+        }
+        if (elapsed > 60 * 1000000000UL) {
+            fprintf(stderr, "참여 시간 초과: %d/%d\n", joined, config.connections);
+            break;
+        }
+    }
+    double join_elapsed = (monotonic_ns() - join_start) / 1e9;
+    unsigned long bytes_after_join = bytes_in;
+    unsigned long broadcasts_after_join = metrics_total(METRIC_BROADCASTS);
+
+    // 2. 칠하기: painter는 앞쪽 연결, 재접속은 뒤쪽 viewer 중에서 고른다
+    unsigned long start = monotonic_ns();
+    unsigned long end = start + (unsigned long)config.duration * 1000000000UL;
+    unsigned long total_rate = (unsigned long)config.painters * config.rate;
+    unsigned long churned = 0;
+    int next_painter = 0;
+    unsigned long now;
+    while ((now = monotonic_ns()) < end) {
+        unsigned long elapsed = now - start;
+
+        if (config.painters > 0) {
+            // 최대 속도면 한 묶음씩, 버퍼가 차면 서버가 읽을 때까지 기다린다 (고정 속도면 실패로 센다)
+            unsigned long due = total_rate > 0 ? elapsed * total_rate / 1000000000UL : pixels_sent + send_failed + SIM_SEND_BATCH;
+            while (pixels_sent + send_failed < due) {
+                SimConn *c = &conns[next_painter];
+                next_painter = (next_painter + 1) % config.painters;
+                if (c->state != SIM_OPEN || !send_pixel(c)) {
+                    if (total_rate == 0) {
+                        break;
+                    }
+                    send_failed++;
+                }
+            }
+        }
+
+        if (config.churn > 0 && config.connections > config.painters) {
+            unsigned long due = elapsed * config.churn / 1000000000UL;
+            while (churned < due) {
+                SimConn *c = &conns[config.painters + next_random() % (config.connections - config.painters)];
+                sim_leave(c);
+                sim_join(c);
+                churned++;
+            }
+        }
+
+        drain(total_rate > 0 || config.painters == 0 ? 1 : 0);
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+    unsigned long ticks = metrics_total(METRIC_BROADCASTS) - broadcasts_after_join;
+
+    // 3. 마지막 브로드캐스트까지 받는다
+    unsigned long settle = monotonic_ns() + SIM_SETTLE_NS;
+    while (monotonic_ns() < settle) {
+        drain(10);
+    }
+    unsigned long bytes_run = bytes_in - bytes_after_join;
+
+    printf("시뮬레이션: 연결 %d (painter %d, %d px/s), %d초, 초당 재접속 %d, 시드 %u, 송신 스레드 %d\n",
+           config.connections, config.painters, config.rate, config.duration, config.churn, config.seed,
+           fanout_threads());
+    printf("참여: %d/%d, %.3f초 (재접속 포함 등록 %lu, 종료 %lu, 서버가 끊음 %lu)\n",
+           joined, config.connections, join_elapsed, joins, leaves, lost);
+    printf("픽셀: 전송 %lu (%.0f/s), 실패 %lu, 전달 %lu, 서버 반영 %lu\n",
+           pixels_sent, pixels_sent / elapsed, send_failed, deliveries, metrics_total(METRIC_PIXELS_APPLIED));
+    printf("수신: frame %lu, 실행 중 %.1f MB (%.1f MB/s), 전체 %.1f MB\n",
+           frames_in, bytes_run / 1e6, bytes_run / 1e6 / elapsed, bytes_in / 1e6);
+    print_histogram("join (등록->스냅샷)", &join_latency);
+    print_histogram("delivery (전송->수신)", &delivery_latency);
+    static Histogram merged;
+    for (int i = 0; i < HIST_COUNT; i++) {
+        metrics_histogram(i, &merged);
+        print_histogram(metrics_histogram_name(i), &merged);
+    }
+    for (int i = 0; i < metrics_queue_count(); i++) {
+        TaskQueue *queue = metrics_queue(i);
+        printf("queue %-16s pushed=%-10lu dropped=%lu\n", queue->name,
+               atomic_load(&queue->pushed), atomic_load(&queue->dropped));
+        for (int lane = 0; lane < TASK_LANE_COUNT; lane++) {
+            char name[40];
+            snprintf(name, sizeof(name), "wait %s/%s", queue->name, task_lane_name(lane));
+            print_histogram(name, &queue->lanes[lane].wait);
+        }
+    }
+
+    // 틱 점검: 참여 단계 이후 페인트가 이어진 동안의 브로드캐스트 수
+    int status = 0;
+    unsigned long expected = (unsigned long)(elapsed * 1000 / SIM_TICK_MS);
+    printf("틱: 브로드캐스트 %lu, 기대 %lu\n", ticks, expected);
+    if (config.painters > 0 && ticks * 2 < expected) {
+        printf("틱 부족: 브로드캐스트가 기대의 절반에 못 미친다 (스냅샷/재동기화가 틱을 막는지 확인)\n");
+        status = 1;
+    }
+    if (config.batch > 0 && check_batch(config.batch) != 0) {
+        status = 1;
+    }
+
+    log_flush();
+    return status;
+}
@@ -9,6 +9,13 @@
 #include "parsing_json.h"
 #include "cjson/cJSON.h"
 #include "save_canvas.h"
+#include "metrics.h"
+#include "trace.h"
+#include "log.h"
+#include "recorder.h"
+#include "work_pool.h"
+#include "affinity.h"
+#include "handoff.h"
 
 // 두 timeval 구조체 간의 시간 차이를 밀리초 단위로 반환
 double time_diff_ms(struct timeval start, struct timeval end) {
@@ -17,13 +24,168 @@ double time_diff_ms(struct timeval start, struct timeval end) {
     return end_ms - start_ms;
 }
 
-// 캔버스 매니저 스레드 함수 구현
+static void add_pending_join(Canvas *canvas, int client) {
+    if (canvas->pending_join_count == canvas->pending_join_capacity) {
+        int capacity = canvas->pending_join_capacity ? canvas->pending_join_capacity * 2 : 16;
+        int *joins = realloc(canvas->pending_joins, sizeof(int) * capacity);
+        if (joins == NULL) {
+            LOG_ERROR("스냅샷 대기 목록 확장 실패");
+            return;
+        }
+        canvas->pending_joins = joins;
+        canvas->pending_join_capacity = capacity;
+    }
+    canvas->pending_joins[canvas->pending_join_count++] = client;
+}
+
+// 작업 풀에서 실행: 픽셀 복사본을 JSON으로 인코딩해서 참여자마다 CM에 전송 작업을 넣는다
+static void snapshot_job(void *arg) {
+
+    SnapshotJob *job = (SnapshotJob *)arg;
+    unsigned long encode_start = monotonic_ns();
+    unsigned long trace_start_ns = trace_begin();
+
+    // 인코딩에는 크기와 픽셀만 필요하다 (캔버스 구조체의 나머지는 캔버스 스레드가 계속 바꾼다)
+    Canvas view = {0};
+    view.pixels = job->pixels;
+    view.canvas_width = job->canvas->canvas_width;
+    view.canvas_height = job->canvas->canvas_height;
+    char *canvas_data = trans_canvas_as_json(&view);
+    size_t frame_len = 0;
+    uint8_t *canvas_frame = canvas_data ? create_websocket_frame((uint8_t *)canvas_data, strlen(canvas_data), &frame_len) : NULL;
+    free(canvas_data);
+    SharedFrame *frame = canvas_frame ? shared_frame_create(canvas_frame, frame_len, job->count) : NULL;
+    free(canvas_frame);
+
+    metrics_add(METRIC_SNAPSHOTS, 1);
+    metrics_add(METRIC_SNAPSHOT_ENCODE_NS, monotonic_ns() - encode_start);
+    trace_end("snapshot_encode", trace_start_ns, frame_len);
+
+    if (frame == NULL) {
+        LOG_ERROR("초기 스냅샷 인코딩 실패: 참여자 %d명", job->count);
+    }
+    else {
+        for (int i = 0; i < job->count; i++) {
+            Task t = {job->clients[i], TASK_INIT_CANAVAS, frame, frame->len, 0, 0};
+            push_task_wait(job->canvas->cm->queue, t);
+        }
+    }
+
+    // 완료는 캔버스 스레드로 (복사본 해제, 미뤄둔 브로드캐스트)
+    Task done = {0, TASK_SNAPSHOT_DONE, job, 0, 0, 0};
+    push_task_wait(job->canvas->queue, done);
+}
+
+// 지금까지 모인 참여자의 스냅샷 작업 시작 (픽셀 복사는 캔버스 스레드에서, 인코딩은 작업 풀에서)
+static void start_snapshot(Canvas *canvas) {
+
+    SnapshotJob *job = malloc(sizeof(SnapshotJob));
+    size_t pixels_size = sizeof(Pixel) * canvas->canvas_width * canvas->canvas_height;
+    Pixel *pixels = job ? malloc(pixels_size) : NULL;
+    if (pixels == NULL) {
+        LOG_ERROR("스냅샷 작업 할당 실패: 참여자 %d명", canvas->pending_join_count);
+        free(job);
+        return;
+    }
+    memcpy(pixels, canvas->pixels, pixels_size);
+
+    job->canvas = canvas;
+    job->pixels = pixels;
+    job->clients = canvas->pending_joins;
+    job->count = canvas->pending_join_count;
+    canvas->pending_joins = NULL;
+    canvas->pending_join_count = 0;
+    canvas->pending_join_capacity = 0;
+
+    canvas->snapshot_running = true;
+    work_pool_submit(snapshot_job, job);
+}
+
+// 픽셀 배열 할당과 초기화 (캔버스 스레드가 CPU에 고정된 뒤 처음 써서 그 NUMA 노드에 놓이게 한다)
+static void init_pixels(Canvas *canvas) {
+
+    const int width = canvas->canvas_width;
+    const int height = canvas->canvas_height;
+    canvas->pixels = malloc(sizeof(Pixel) * width * height);
+    if (canvas->pixels == NULL) {
+        LOG_ERROR("캔버스 픽셀 메모리 할당 실패");
+        exit(EXIT_FAILURE);
+    }
+
+    // 픽셀 초기화
+    for (int i = 0; i < width * height; i++) {
+        canvas->pixels[i].x = i % width;
+        canvas->pixels[i].y = i / width;
+        strcpy(canvas->pixels[i].color, "#FFFFFF");  // 컬러 흰색으로 초기화 
+    }
+
+    LOG_INFO("캔버스 배열 할당 및 초기화 성공");
+}
+
+// 캔버스를 저장하고 브로드캐스트 전 픽셀을 모아 CM에 넘긴다 (CM이 새 프로세스로 보낸다)
+static void finish_handoff(Canvas *canvas) {
+
+    HandoffJob *job = canvas->handoff;
+    canvas->handoff = NULL;
+
+    unsigned long trace_start_ns = trace_begin();
+    save_canvas_as_json(canvas);
+
+    // 실패하면 이전 프로세스가 계속 서비스하므로 수정된 픽셀은 그대로 둔다
+    job->width = canvas->canvas_width;
+    job->height = canvas->canvas_height;
+    job->dirty_count = 0;
+    job->dirty = (uint32_t *)malloc(sizeof(uint32_t) * (HASH_COUNT(canvas->modified_pixels) + 1));
+    if (job->dirty == NULL) {
+        LOG_ERROR("무중단 재시작: 픽셀 목록 메모리 할당 실패");
+    } else {
+        ModifiedPixel *p, *tmp;
+        HASH_ITER(hh, canvas->modified_pixels, p, tmp) {
+            job->dirty[job->dirty_count++] = p->key;
+        }
+    }
+    trace_end("handoff_save", trace_start_ns, job->dirty_count);
+
+    // 대량 레인: 앞서 넣은 브로드캐스트를 CM이 다 보낸 뒤에 넘긴다
+    job->stage = HANDOFF_STAGE_SEND;
+    Task task = {0, TASK_HANDOFF, job, 0, 0, 0};
+    push_task_wait(canvas->cm->queue, task);
+}
+
+// 마지막 브로드캐스트 후 500밀리초가 지났으면 변경분을 보낸다 (스냅샷 인코딩 중이면 끝난 뒤로)
+static void broadcast_if_due(Canvas *canvas, struct timeval *last_broadcast) {
+
+    struct timeval current_time;
+    gettimeofday(&current_time, NULL);
+    if (time_diff_ms(*last_broadcast, current_time) >= 500.0 && !canvas->snapshot_running) {
+        broadcast_updates(canvas);
+        recorder_flush();
+        *last_broadcast = current_time;
+    }
+}
+
+// 다음 틱까지 남은 밀리초 (스냅샷 인코딩 중이면 끝날 때 보내므로 작업이 올 때까지 기다린다)
+static int broadcast_wait_ms(Canvas *canvas, struct timeval last_broadcast) {
+
+    if (canvas->snapshot_running) {
+        return -1;
+    }
+    struct timeval current_time;
+    gettimeofday(&current_time, NULL);
+    double remaining = 500.0 - time_diff_ms(last_broadcast, current_time);
+    return remaining > 0 ? (int)remaining + 1 : 0;
+}
+
 static void *worker_thread(void *arg) {
 
     pthread_t tid = pthread_self();
-    printf("Canvas Thread : %ld\n", tid);
+    affinity_apply("canvas", -1);
+    LOG_INFO("Canvas Thread : %ld", tid);
+    trace_set_thread_name("canvas");
 
     Canvas *canvas = (Canvas *)arg;
+    init_pixels(canvas);
+    pthread_barrier_wait(&canvas->pixels_ready);   // init_canvas는 픽셀이 준비된 뒤 반환
 
     // 일정 시간마다 브로드캐스트 업데이트 수행
     struct timeval last_broadcast, current_time;
@@ -33,24 +195,94 @@ static void *worker_thread(void *arg) {
     gettimeofday(&last_save, NULL);
 
     while (1) {
-        // 작업 큐에서 작업을 가져옴
-        Task task = pop_task(canvas->queue);
+        // 작업 큐에서 작업을 가져옴 (조용할 때도 틱 시각에는 깨어나 모인 변경분을 보낸다)
+        Task task = {0};
+        if (!pop_task_timeout(canvas->queue, &task, broadcast_wait_ms(canvas, last_broadcast))) {
+            task.type = TASK_TIMER_TICK;
+        }
 
         switch (task.type) {
             case TASK_PIXEL_UPDATE: {
-                process_json(canvas, (char *)task.data, task.data_len);
+                unsigned long apply_start = monotonic_ns();
+                if (task.recv_ns != 0) {
+                    metrics_record(HIST_QUEUE_WAIT, apply_start - task.recv_ns);
+                }
+                unsigned long trace_start_ns = trace_begin();
+                process_json(canvas, task.client, (char *)task.data, task.data_len, task.recv_ns);
+                trace_end("pixel_apply", trace_start_ns, task.data_len);
+                metrics_record(HIST_APPLY, monotonic_ns() - apply_start);
                 free(task.data);
                 break;
             }
 
-            case TASK_NEW_CLIENT: {
-                char *canvas_data = trans_canvas_as_json(canvas);
-                size_t data_len = strlen(canvas_data);
-                size_t frmae_len = 0;
-                uint8_t * canvas_frame = create_websocket_frame(canvas_data, data_len, &frmae_len);
-                free(canvas_data);
-                Task t = {task.client, TASK_INIT_CANAVAS, canvas_frame, frmae_len};
-                push_task(canvas->cm->queue, t);
+            case TASK_NEW_CLIENT:
+            case TASK_RESYNC_CLIENT: {
+                // 새 참여자, 혹은 밀린 변경분을 버린 느린 클라이언트: 둘 다 다음 스냅샷에 넣는다
+                if (task.type == TASK_NEW_CLIENT) {
+                    recorder_join(task.client, monotonic_ns());
+                }
+                add_pending_join(canvas, task.client);
+                if (!canvas->snapshot_running) {
+                    start_snapshot(canvas);
+                }
+                break;
+            }
+
+            case TASK_SNAPSHOT_DONE: {
+                // 참여자들의 스냅샷이 CM 큐에 들어갔으니 미뤄둔 브로드캐스트를 보내도 순서가 맞다
+                SnapshotJob *job = (SnapshotJob *)task.data;
+                free(job->pixels);
+                free(job->clients);
+                free(job);
+                canvas->snapshot_running = false;
+                // 참여가 계속 몰려도 틱이 밀리지 않게: 때가 된 틱을 먼저 보내고 다음 묶음을 시작한다
+                broadcast_if_due(canvas, &last_broadcast);
+                if (canvas->pending_join_count > 0) {
+                    start_snapshot(canvas);
+                }
+                else if (canvas->handoff != NULL) {
+                    finish_handoff(canvas);
+                }
+                break;
+            }
+
+            case TASK_HANDOFF: {
+                // 앞선 픽셀 메세지는 모두 반영했다. 스냅샷을 기다리는 참여자가 있으면 받은 뒤에 넘긴다
+                canvas->handoff = (HandoffJob *)task.data;
+                if (!canvas->snapshot_running) {
+                    finish_handoff(canvas);
+                }
+                break;
+            }
+
+            case TASK_RESTORE_DIRTY: {
+                // 이전 프로세스가 브로드캐스트하지 못한 픽셀 (색은 저장된 캔버스에서 적재했다)
+                uint32_t *dirty = (uint32_t *)task.data;
+                unsigned long applied_ns = monotonic_ns();
+                for (ssize_t i = 0; i < task.data_len; i++) {
+                    if (dirty[i] >= (uint32_t)(canvas->canvas_width * canvas->canvas_height)) {
+                        continue;
+                    }
+                    int key = (int)dirty[i];
+                    ModifiedPixel *p;
+                    HASH_FIND_INT(canvas->modified_pixels, &key, p);
+                    if (p != NULL) {
+                        continue;
+                    }
+                    p = (ModifiedPixel *)malloc(sizeof(ModifiedPixel));
+                    p->key = key;
+                    strcpy(p->color, canvas->pixels[key].color);
+                    p->recv_ns = 0;
+                    p->applied_ns = applied_ns;
+                    HASH_ADD_INT(canvas->modified_pixels, key, p);
+                }
+                free(dirty);
+                break;
+            }
+
+            case TASK_TIMER_TICK: {
+                // 기다리는 동안 작업이 없었다: 아래에서 때가 된 틱을 보낸다
+                break;
             }
 
             // 필요한 다른 작업 유형 처리 추가
@@ -60,17 +292,14 @@ static void *worker_thread(void *arg) {
 
         }
 
-        gettimeofday(&current_time, NULL);
-        double time_gap = time_diff_ms(last_broadcast, current_time);
-        if (time_gap >= 500.0) {                    // 100밀리초
-            broadcast_updates(canvas);
-            last_broadcast = current_time;
-        }
+        broadcast_if_due(canvas, &last_broadcast);
 
         gettimeofday(&current_time, NULL);
         double time_gap_save = time_diff_ms(last_save, current_time);
         if (time_gap_save >= 1000.0  * 5 * 5) {    // 5분 
+            unsigned long trace_start_ns = trace_begin();
             save_canvas_as_json(canvas);
+            trace_end("save", trace_start_ns, 0);
             // 저장 로직 구현
             last_save = current_time;
         }
@@ -85,42 +314,37 @@ void init_canvas(Canvas *canvas, ClientManager *cm, int width, int height, int q
 
     canvas->cm = cm;
 
-    printf("캔버스 초기화 시작\n");
+    LOG_INFO("캔버스 초기화 시작");
 
     canvas->canvas_width = width;
     canvas->canvas_height = height;
-    canvas->pixels = malloc(sizeof(Pixel) * width * height);
-    if (canvas->pixels == NULL) {
-        fprintf(stderr, "캔버스 픽셀 메모리 할당 실패\n");
-        exit(EXIT_FAILURE);
-    }
-
-    // 픽셀 초기화
-    for (int i = 0; i < width * height; i++) {
-        canvas->pixels[i].x = i % width;
-        canvas->pixels[i].y = i / width;
-        strcpy(canvas->pixels[i].color, "#FFFFFF");  // 컬러 흰색으로 초기화 
-    }
-
-    printf("캔버스 배열 할당 및 초기화 성공\n");
-
     // 작업 큐 초기화
     canvas->queue = (TaskQueue *)malloc(sizeof(TaskQueue));
-    init_task_queue(canvas->queue, queue_size);
+    init_task_queue(canvas->queue, queue_size, "canvas");
+    metrics_register_queue(canvas->queue);
 
-    printf("캔버스 Task Queue 초기화\n");
+    LOG_INFO("캔버스 Task Queue 초기화");
 
     canvas->modified_pixels = NULL; // 수정된 픽셀 해시 맵 초기화
+    canvas->pending_joins = NULL;
+    canvas->pending_join_count = 0;
+    canvas->pending_join_capacity = 0;
+    canvas->snapshot_running = false;
+    canvas->handoff = NULL;
 
-    // 캔버스 매니저 스레드 생성
+    recorder_init(width, height);   // FAINTER_RECORD 가 있을 때만
+
+    // 캔버스 매니저 스레드 생성 (픽셀 배열은 스레드가 할당한다)
+    pthread_barrier_init(&canvas->pixels_ready, NULL, 2);
     const int n = pthread_create(&canvas->tid, NULL, worker_thread, (void *)canvas);
     if (n != 0) {
-        fprintf(stderr, "캔버스 스레드 생성 실패: %s\n", strerror(n));
-        free(canvas->pixels);
+        LOG_ERROR("캔버스 스레드 생성 실패: %s", strerror(n));
         exit(EXIT_FAILURE);
     }
+    pthread_barrier_wait(&canvas->pixels_ready);
+    pthread_barrier_destroy(&canvas->pixels_ready);
 
-    printf("캔버스 스레드 생성 성공\n");
+    LOG_INFO("캔버스 스레드 생성 성공");
 } 
 
 // WebSocket 프레임 생성 함수 구현
@@ -144,7 +368,7 @@ uint8_t *create_websocket_frame(uint8_t *payload_data, size_t payload_len, size_
     // 프레임 버퍼 할당
     uint8_t *frame = (uint8_t *)malloc(*frame_len);
     if (frame == NULL) {
-        fprintf(stderr, "WebSocket 프레임 메모리 할당 실패\n");
+        LOG_ERROR("WebSocket 프레임 메모리 할당 실패");
         return NULL;
     }
 
@@ -179,12 +403,27 @@ void broadcast_updates(Canvas *canvas) {
         return;
     }
 
+    unsigned long trace_start_ns = trace_begin();
+    unsigned int dirty_pixels = HASH_COUNT(canvas->modified_pixels);
+    metrics_add(METRIC_TICKS, 1);
+    metrics_add(METRIC_DIRTY_PIXELS, dirty_pixels);
+    metrics_set_gauge(GAUGE_DIRTY_PIXELS_LAST_TICK, dirty_pixels);
+
     // JSON 객체 생성
     cJSON *json_message = cJSON_CreateObject();
     cJSON *json_pixels = cJSON_CreateArray();
 
+    unsigned long tick_ns = monotonic_ns();
+    unsigned long oldest_recv_ns = 0;
+
     ModifiedPixel *p, *tmp;
     HASH_ITER(hh, canvas->modified_pixels, p, tmp) {
+        // 반영된 뒤 틱을 기다린 시간, 가장 먼저 수신된 픽셀 시각
+        metrics_record(HIST_TICK_WAIT, tick_ns - p->applied_ns);
+        if (p->recv_ns != 0 && (oldest_recv_ns == 0 || p->recv_ns < oldest_recv_ns)) {
+            oldest_recv_ns = p->recv_ns;
+        }
+
         // 해시 맵 키를 이용하여 x와 y 좌표 계산
         int y = p->key / canvas->canvas_width;
         int x = p->key % canvas->canvas_width;
@@ -209,9 +448,10 @@ void broadcast_updates(Canvas *canvas) {
     size_t frame_len = 0;
     uint8_t *data = create_websocket_frame((uint8_t*)message_str, message_len, &frame_len);
 
-    // 클라이언트 매니저에게 넘겨준다.
-    Task task = {0, TASK_BROADCAST, data, frame_len};
-    push_task(canvas->cm->queue, task);
+    // 클라이언트 매니저에게 넘겨준다. 버리면 모든 클라이언트가 이 변경분을 놓치므로 자리가 날 때까지 기다린다
+    // (CM은 캔버스 큐를 기다리지 않으므로 서로 기다리는 일은 없다)
+    Task task = {0, TASK_BROADCAST, data, frame_len, oldest_recv_ns, 0};
+    push_task_wait(canvas->cm->queue, task);
 
     // JSON 객체 메모리 해제
     cJSON_Delete(json_message);
@@ -221,6 +461,7 @@ void broadcast_updates(Canvas *canvas) {
         HASH_DEL(canvas->modified_pixels, p);
         free(p);
     }
+    trace_end("tick_broadcast", trace_start_ns, dirty_pixels);
 }
 
 
@@ -16,6 +16,8 @@ typedef struct {
 typedef struct {
     int key;            // x * CANVAS_HEIGHT + y
     char color[8];
+    unsigned long recv_ns;      // 소켓에서 읽은 시각 (0이면 측정하지 않음)
+    unsigned long applied_ns;   // 캔버스에 반영된 시각
     UT_hash_handle hh;  // uthash 핸들
 } ModifiedPixel;
 
@@ -26,10 +28,23 @@ typedef struct {
     int canvas_width;
     int canvas_height;
     pthread_t tid;
+    pthread_barrier_t pixels_ready; // 캔버스 스레드가 픽셀 배열을 할당, 초기화할 때까지 init_canvas 대기
     TaskQueue *queue;
     ModifiedPixel *modified_pixels; // 수정된 픽셀 해시 맵
+    int *pending_joins;             // 스냅샷을 기다리는 클라이언트 (다음 스냅샷 작업에 함께 넣는다)
+    int pending_join_count;
+    int pending_join_capacity;
+    bool snapshot_running;          // 작업 풀에서 스냅샷 인코딩 중 (끝날 때까지 브로드캐스트를 미룬다)
+    struct HandoffJob *handoff;     // 스냅샷이 끝나면 넘겨줄 무중단 재시작 작업
 } Canvas;
 
+// 작업 풀에서 인코딩할 초기 스냅샷 (같은 틱에 들어온 참여자는 한 번의 인코딩을 나눠 쓴다)
+typedef struct {
+    Canvas *canvas;
+    Pixel *pixels;                  // 작업을 만든 시점의 픽셀 복사본
+    int *clients;
+    int count;
+} SnapshotJob;
 
 // 브로드캐스팅용 함수
 uint8_t *create_websocket_frame(uint8_t *payload_data, size_t payload_len, size_t *frame_len);
@@ -1,6 +1,15 @@
+#define _GNU_SOURCE
 #include "client_manager.h"
 
 #include "canvas.h"
+#include "metrics.h"
+#include "trace.h"
+#include "log.h"
+#include "affinity.h"
+#include "handoff.h"
+#include "rate_limit.h"
+#include "conn_input.h"
+#include "fanout.h"
 #include <http_handler.h>
 #include <sys/socket.h>
 #include <stdlib.h>
@@ -12,148 +21,326 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <signal.h>
+#include <time.h>
+#include <stddef.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// 메인 스레드가 WebSocket frame을 나눠 보낸 작업
+static bool is_frame_task(TaskType type) {
+    return type == TASK_FRAME_MESSAGE || type == TASK_MESSAGE_INCOMPLETE_FRAME || type == TASK_WEBSOCKET_PING ||
+           type == TASK_WEBSOCKET_PONG || type == TASK_WEBSOCKET_CLOSE;
+}
 
-static void *worker_thread(void *arg) {
-
-    pthread_t tid = pthread_self();
-    printf("[CM] Thread : %ld\n", tid);
-
-    ClientManager *cm = (ClientManager *)arg;
-    TaskQueue *queue = cm->queue;
+// 업그레이드 요청 뒤에 붙어 온 frame: 101을 보내고 OPEN이 될 때까지 도착 순서대로 모아둔다
+static void hold_frame(ClientManager *cm, Client *client, Task task) {
+    if (client->close_pending) {
+        free(task.data);
+        return;
+    }
+    if (client->held_frames == NULL) {
+        client->held_frames = (Task *)malloc(HELD_FRAMES_MAX * sizeof(Task));
+    }
+    if (client->held_frames == NULL || client->held_count == HELD_FRAMES_MAX) {
+        LOG_WARN("[CM] 업그레이드 전에 받은 frame이 너무 많음 FD %d", client->socket_fd);
+        free(task.data);
+        removeClient(cm, client->socket_fd);
+        return;
+    }
+    client->held_frames[client->held_count++] = task;
+}
 
-    while (1) {
-        Task task = pop_task(queue);
-        Client *client = find_client(cm, task.client);
+static void handle_task(ClientManager *cm, Task task) {
 
-        switch (task.type) {
+    Client *client = find_client(cm, task.client);
+    // 메인 스레드가 이전 연결에서 읽은 작업: 그 사이 fd가 새 연결에 재사용됐으면 새 연결에 적용하지 않는다
+    if (client != NULL && task.gen != 0 && task.gen != client->conn_gen) {
+        client = NULL;
+    }
+    if (client != NULL && client->state == CONNECTION_HANDSHAKE && is_frame_task(task.type)) {
+        hold_frame(cm, client, task);
+        return;
+    }
 
-            case TASK_INIT_CANAVAS: {
-                if(send(client->socket_fd, task.data, task.data_len, 0) == -1){
-                    printf("캔버스 초기화 전송 실패\n");
+    switch (task.type) {
+
+        case TASK_INIT_CANAVAS: {
+            // 같은 스냅샷을 받는 참여자들이 frame 하나를 나눠 쓴다
+            SharedFrame *frame = (SharedFrame *)task.data;
+            if (client != NULL && client->state == CONNECTION_OPEN) {
+                unsigned long trace_start_ns = trace_begin();
+                int result = send_to_client(cm, client, frame->data, frame->len, &frame, true);
+                trace_end("send_snapshot", trace_start_ns, client->socket_fd);
+                if (result == -1) {
+                    LOG_WARN("캔버스 초기화 전송 실패");
+                    removeClient(cm, client->socket_fd);
                 }
-                free(task.data);
-                break;
             }
+            shared_frame_release(frame);
+            break;
+        }
 
-            case TASK_NEW_CLIENT: {
-                addClient(cm);
-                break;
-            }
+        case TASK_NEW_CLIENT: {
+            acceptClients(cm);
+            break;
+        }
 
-            case TASK_BROADCAST: {
-                broadcastClients(cm, task.data, task.data_len);
-                break;
+        case TASK_ADOPT_CLIENT: {
+            adoptClient(cm, task.client, (HandoffClient *)task.data);
+            free(task.data);
+            break;
+        }
+
+        case TASK_HANDOFF: {
+            HandoffJob *job = (HandoffJob *)task.data;
+            if (job->stage == HANDOFF_STAGE_DRAIN) {
+                // main이 읽은 메세지는 모두 처리했다: 캔버스가 그 픽셀까지 반영하고 저장하도록
+                handoff_drain(cm, job);
+            } else if (handoff_claim(job)) {
+                fanout_wait_idle();     // 송신 스레드가 앞선 브로드캐스트를 다 보낸 뒤의 송신 대기열을 넘긴다
+                handoff_send(cm, job);  // 성공하면 반환하지 않는다
             }
+            break;
+        }
 
-            case TASK_FRAME_MESSAGE: {
-                if (client == NULL) continue;
-                //printf("TASK_FRAME_MESSAGE\n");
-                if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0){
+        case TASK_REGISTER_CLIENT: {
+            // 이미 연결된 소켓 (시뮬레이션의 socketpair 서버 쪽 끝)
+            if (registerClient(cm, task.client) == 0) {
+                atomic_fetch_add(&cm->accept_stats.accepted, 1);
+            }
+            break;
+        }
 
-                    // 버퍼 복사해서 캔버스한테 보내줌
-                    char *tmp = (char *)malloc(client->recv_buffer_len * sizeof(char));
-                    memcpy(tmp, client->recv_buffer, client->recv_buffer_len);
+        case TASK_BROADCAST: {
+            broadcastClients(cm, task.data, task.data_len, task.recv_ns);
+            break;
+        }
 
-                    Task pixel_task = {0, TASK_PIXEL_UPDATE, tmp, client->recv_buffer_len};
-                    push_task(cm->canvas_queue, pixel_task);
-                }
-                client->recv_buffer_len = 0;
-                client->incomplete_frame = false;
+        case TASK_FRAME_MESSAGE: {
+            if (client == NULL || client->state != CONNECTION_OPEN) {
                 free(task.data);
                 break;
             }
-
-            case TASK_HTTP_REQUEST: {
-                if (client == NULL) continue;
-                if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0) {
-                    handle_http_request(cm, client); // HTTP 요청 처리
-                }
-                client->recv_buffer_len = 0; // 버퍼 초기화
-                client->incomplete_http = false;
+            client_received(cm, client, true);
+            // 버퍼가 넘쳐 연결을 닫았으면 client는 이미 제거됐다
+            if (process_buffer(cm, client, (char *)task.data, task.data_len) != 0) {
                 free(task.data);
                 break;
             }
 
-            case TASK_MESSAGE_INCOMPLETE_FRAME: {
-                if (client == NULL) continue;
-                if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0) {
-                    client->incomplete_frame = true;
-                    // INCOMPLETE 보낸다음 클라이언트 상태 바꾼다음, 다음 버퍼(UNKNOWN_MESSAGE)를 기다린다
-                }
-                free(task.data);
-                break;
+            // 버퍼 복사해서 캔버스한테 보내줌
+            char *tmp = (char *)malloc(client->recv_buffer_len * sizeof(char));
+            memcpy(tmp, client->recv_buffer, client->recv_buffer_len);
+
+            // 조각난 메세지는 첫 조각을 받은 시각부터 잰다
+            unsigned long recv_ns = client->incomplete_frame ? client->frame_recv_ns : task.recv_ns;
+            // CM은 캔버스 큐를 기다리지 않는다 (캔버스가 브로드캐스트를 넣으려고 CM 큐를 기다릴 수 있다)
+            // 가득 차면 버리고 fainter_queue_dropped_total{queue="canvas"}로 센다
+            Task pixel_task = {0, TASK_PIXEL_UPDATE, tmp, client->recv_buffer_len, recv_ns, 0};
+            if (!push_task(cm->canvas_queue, pixel_task)) {
+                free(tmp);
             }
+            client->recv_buffer_len = 0;
+            client->incomplete_frame = false;
+            free(task.data);
+            break;
+        }
 
-            case TASK_MESSAGE_INCOMPLETE_HTTP: {
-                if (client == NULL) continue;
-                //printf("TASK_MESSAGE_INCOMPLETE_HTTP\n");
-                if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0) {
-                    client->incomplete_http = true;
-                    // INCOMPLETE 보낸다음 클라이언트 상태 바꾼다음, 다음 버퍼(TASK_FRAME_MESSAGE)를 기다린다
-                }
+        case TASK_HTTP_REQUEST:
+        case TASK_MESSAGE_INCOMPLETE_HTTP: {
+            // 조각난 요청은 버퍼에 모아두고, 완성된 요청은 도착 순서대로 응답 (keep-alive, 파이프라이닝)
+            if (client != NULL && client->state == CONNECTION_HANDSHAKE) {
+                handle_http_stream(cm, client, (char *)task.data, task.data_len);
+            }
+            free(task.data);
+            break;
+        }
+
+        case TASK_MESSAGE_INCOMPLETE_FRAME: {
+            if (client == NULL || client->state != CONNECTION_OPEN) {
                 free(task.data);
                 break;
             }
+            client_received(cm, client, true);
+            if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0) {
+                if (!client->incomplete_frame) {
+                    client->frame_recv_ns = task.recv_ns;
+                }
+                client->incomplete_frame = true;
+                // INCOMPLETE 보낸다음 클라이언트 상태 바꾼다음, 다음 버퍼(UNKNOWN_MESSAGE)를 기다린다
+            }
+            free(task.data);
+            break;
+        }
 
-            case TASK_UNKNOWN_MESSAGE: {
-                if (client == NULL) continue;
-                //printf("TASK_UNKNOWN_MESSAGE\n");
-                if (client->incomplete_http == true) {
-                    if (process_buffer(cm, client, (char *)task.data, task.data_len) == 0) {
-                        if (is_http_request(client->recv_buffer, client->recv_buffer_len)) {
-                            handle_http_request(cm, client); // HTTP 요청 처리
-                        }
-                    }
+        case TASK_WEBSOCKET_PING: {
+            if (client != NULL && client->state == CONNECTION_OPEN) {
+                client_received(cm, client, false);
+                // 같은 페이로드로 pong (opcode 0xA), 제어 frame이라 125바이트 이하
+                uint8_t pong[2 + 125];
+                pong[0] = 0x8A;
+                pong[1] = (uint8_t)task.data_len;
+                memcpy(pong + 2, task.data, task.data_len);
+                SharedFrame *shared = NULL;
+                int result = send_to_client(cm, client, pong, 2 + task.data_len, &shared, false);
+                if (shared != NULL) {
+                    shared_frame_release(shared);
                 }
-                client->incomplete_http = false;
-                client->recv_buffer_len = 0;
-                free(task.data);
-                break;
+                if (result == -1) {
+                    removeClient(cm, client->socket_fd);
+                }
+            }
+            free(task.data);
+            break;
+        }
+
+        case TASK_WEBSOCKET_PONG: {
+            if (client != NULL && client->state == CONNECTION_OPEN) {
+                client_received(cm, client, false);
             }
+            break;
+        }
 
-            case TASK_CLIENT_CLOSE :{
-                if (client == NULL) continue;
+        case TASK_SEND_FAILED: {
+            // 그 사이 fd가 새 연결에 재사용됐으면 send_failed가 없다
+            if (client != NULL && client->send_failed) {
+                removeClient(cm, client->socket_fd);
+            }
+            break;
+        }
+
+        case TASK_ZEROCOPY_COMPLETE: {
+            if (client != NULL) {
+                pthread_mutex_lock(&client->send_lock);
+                outbound_zerocopy_complete(&client->outbound, client->socket_fd);
+                pthread_mutex_unlock(&client->send_lock);
+            }
+            break;
+        }
+
+        case TASK_CLIENT_WRITABLE: {
+            if (client != NULL && flush_client(cm, client) == -1) {
                 removeClient(cm, client->socket_fd);
-                break;
             }
+            break;
+        }
+
+        case TASK_HTTP_DONE: {
+            handle_http_done(cm, (HttpJob *)task.data);
+            break;
+        }
 
-            case TASK_WEBSOCKET_CLOSE : {
-                if (client->state == CONNECTION_OPEN) {
+        case TASK_UNKNOWN_MESSAGE: {
+            // 핸드셰이크 전이라면 이전 HTTP 요청의 나머지 조각이다
+            if (client != NULL && client->state == CONNECTION_HANDSHAKE) {
+                handle_http_stream(cm, client, (char *)task.data, task.data_len);
+            }
+            free(task.data);
+            break;
+        }
 
-                    
+        case TASK_TIMER_TICK: {
+            expire_client_timers(cm);
+            sweep_send_state(cm);
+            registry_reclaim(&cm->registry);
+            update_accept_stats(cm);
+            if (cm->handoff_retry != NULL) {
+                handoff_drain(cm, cm->handoff_retry);
+            }
+            break;
+        }
 
-                    // printf("[CM]웹소켓 접속 종료\n");
-                    client->state = CONNECTION_CLOSING;
-                    // 종료 프레임 (Opcode: 0x8)
-                    unsigned char close_frame[4];
-                    close_frame[0] = 0x88;  // FIN bit + Opcode (0x8 for Close)
-                    close_frame[1] = 0x02;  // Payload length (2 bytes for close code)
+        case TASK_STATIC_RELOAD: {
+            handle_static_cache_events(cm->static_cache);
+            break;
+        }
 
-                    // 상태 코드를 네트워크 바이트 순서로 변환
-                    uint16_t close_code = htons(1000);
-                    memcpy(&close_frame[2], &close_code, sizeof(close_code));
+        case TASK_CLIENT_CLOSE :{
+            if (client == NULL) break;
+            removeClient(cm, client->socket_fd);
+            break;
+        }
 
-                    // 종료 프레임 전송
-                    if (send(client->socket_fd, close_frame, sizeof(close_frame), 0) < 0) {
-                        perror("[CM]웹소켓 연결 종료 프레임 전송 실패");
+        case TASK_WEBSOCKET_CLOSE : {
+            if (client != NULL && client->state == CONNECTION_OPEN) {
+
+                
+
+                // printf("[CM]웹소켓 접속 종료\n");
+                pthread_mutex_lock(&client->send_lock);
+                client->state = CONNECTION_CLOSING;
+                // 종료 프레임 (Opcode: 0x8)
+                unsigned char close_frame[4];
+                close_frame[0] = 0x88;  // FIN bit + Opcode (0x8 for Close)
+                close_frame[1] = 0x02;  // Payload length (2 bytes for close code)
+
+                // 상태 코드를 네트워크 바이트 순서로 변환
+                uint16_t close_code = htons(1000);
+                memcpy(&close_frame[2], &close_code, sizeof(close_code));
+
+                // 종료 프레임 전송 (보내던 frame이 대기열에 남아 있으면 중간에 끼워 넣을 수 없어서 생략)
+                if (client->outbound.head == NULL) {
+                    if (send(client->socket_fd, close_frame, sizeof(close_frame), MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+                        LOG_ERROR("[CM]웹소켓 연결 종료 프레임 전송 실패: %s", strerror(errno));
                     } else {
+                        metrics_add(METRIC_BYTES_OUT, sizeof(close_frame));
                         client->state = CONNECTION_CLOSED;
                         // printf("Close frame sent with code: %d\n", close_code);
                     }
-                    removeClient(cm, client->socket_fd);
-                    pthread_spin_lock(&cm->lock);
-                    cm->client_count--;
-                    pthread_spin_unlock(&cm->lock);
                 }
-                free(task.data);
-                break;
+                pthread_mutex_unlock(&client->send_lock);
+                removeClient(cm, client->socket_fd);
+                pthread_spin_lock(&cm->lock);
+                cm->client_count--;
+                pthread_spin_unlock(&cm->lock);
             }
+            free(task.data);
+            break;
+        }
 
-            default: {
-                break;
-            }
+        default: {
+            break;
         }
     }
+}
+
+// 업그레이드가 끝났으면 그동안 모아둔 frame을 처리 (frame 하나가 연결을 닫을 수 있어 매번 다시 찾는다)
+static void replay_held_frames(ClientManager *cm, int client_fd) {
+    Client *client = find_client(cm, client_fd);
+    if (client == NULL || client->state != CONNECTION_OPEN || client->held_frames == NULL) {
+        return;
+    }
+    Task *held = client->held_frames;
+    size_t count = client->held_count;
+    client->held_frames = NULL;
+    client->held_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        handle_task(cm, held[i]);
+    }
+    free(held);
+}
+
+static void *worker_thread(void *arg) {
+
+    pthread_t tid = pthread_self();
+    affinity_apply("cm", -1);
+    LOG_INFO("[CM] Thread : %ld", tid);
+    trace_set_thread_name("cm");
+
+    ClientManager *cm = (ClientManager *)arg;
+    TaskQueue *queue = cm->queue;
+
+    while (1) {
+        Task task = pop_task(queue);
+        handle_task(cm, task);
+        if (task.type == TASK_HTTP_DONE) {
+            replay_held_frames(cm, task.client);
+        }
+        // 이번 작업에서 닫은 브로드캐스트 대상을 스냅샷에서 빼고 회수 대기로 (소켓은 읽는 쪽이 모두 나가면 닫힌다)
+        registry_flush_removed(&cm->registry);
+    }
 
     pthread_exit(NULL);
 }
@@ -168,73 +355,177 @@ int process_buffer(ClientManager *manager, Client *client, char *buffer, size_t
         return 0;
     }
 
-    fprintf(stderr, "클라이언트 버퍼 오버플로우 Client : %d\n", client->socket_fd);
+    LOG_WARN("클라이언트 버퍼 오버플로우 Client : %d", client->socket_fd);
     // 에러 처리 (연결 종료)
     removeClient(manager, client->socket_fd);
     return 1;
 }
 
+time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+// 클라이언트의 다음 마감 (없으면 0)
+static time_t client_deadline(ClientManager *manager, Client *client) {
+
+    if (client->state == CONNECTION_HANDSHAKE) {
+        // 요청 없이 keep-alive 유휴 시간이 지나거나, 접속 후 핸드셰이크 제한 시간이 지나면 닫는다
+        time_t deadline = client->last_active + HTTP_KEEP_ALIVE_TIMEOUT;
+        if (manager->handshake_timeout > 0 && client->connected_at + manager->handshake_timeout < deadline) {
+            deadline = client->connected_at + manager->handshake_timeout;
+        }
+        return deadline;
+    }
+    if (client->state != CONNECTION_OPEN) {
+        return 0;
+    }
+
+    time_t deadline = 0;
+    if (manager->ping_interval > 0) {
+        deadline = client->ping_sent != 0 ? client->ping_sent + manager->pong_timeout
+                                           : client->last_recv + manager->ping_interval;
+    }
+    if (manager->idle_timeout > 0 && (deadline == 0 || client->last_message + manager->idle_timeout < deadline)) {
+        deadline = client->last_message + manager->idle_timeout;
+    }
+    return deadline;
+}
+
+void arm_client_timer(ClientManager *manager, Client *client) {
+
+    time_t deadline = client_deadline(manager, client);
+    if (deadline == 0) {
+        timer_cancel(&manager->timers, &client->timer);
+    } else {
+        timer_schedule(&manager->timers, &client->timer, (unsigned long)deadline);
+    }
+}
+
+// 마감이 된 클라이언트: 받은 것이 있어 마감이 미뤄졌으면 다시 예약하고, 아니면 ping을 보내거나 닫는다
+static void client_timer_expired(TimerNode *node, void *arg) {
+
+    ClientManager *manager = (ClientManager *)arg;
+    Client *client = (Client *)((char *)node - offsetof(Client, timer));
+    time_t now = (time_t)manager->timers.now;
+
+    if (client->state == CONNECTION_HANDSHAKE) {
+        // 워커가 응답을 쓰는 중이면 끝난 뒤에 다시 본다
+        if (client->http_busy) {
+            timer_schedule(&manager->timers, node, (unsigned long)now + 1);
+            return;
+        }
+        if (manager->handshake_timeout > 0 && now - client->connected_at >= manager->handshake_timeout) {
+            LOG_DEBUG("[CM] 핸드셰이크 제한 시간 초과 FD %d", client->socket_fd);
+            metrics_add(METRIC_HANDSHAKE_TIMEOUTS, 1);
+            removeClient(manager, client->socket_fd);
+            return;
+        }
+        if (now - client->last_active >= HTTP_KEEP_ALIVE_TIMEOUT) {
+            metrics_add(METRIC_IDLE_TIMEOUTS, 1);
+            removeClient(manager, client->socket_fd);
+            return;
+        }
+    }
+    else if (client->state == CONNECTION_OPEN) {
+        if (manager->idle_timeout > 0 && now - client->last_message >= manager->idle_timeout) {
+            LOG_DEBUG("[CM] 유휴 WebSocket 연결 종료 FD %d", client->socket_fd);
+            metrics_add(METRIC_IDLE_TIMEOUTS, 1);
+            removeClient(manager, client->socket_fd);
+            return;
+        }
+        if (client->ping_sent != 0 && now - client->ping_sent >= manager->pong_timeout) {
+            LOG_INFO("[CM] ping 응답 없음, 연결 종료 FD %d", client->socket_fd);
+            metrics_add(METRIC_PING_TIMEOUTS, 1);
+            removeClient(manager, client->socket_fd);
+            return;
+        }
+        // 재동기화를 기다리는 클라이언트는 frame을 보내지 않는다 (밀린 데이터가 있으면 TCP가 끊긴 상대를 알아챈다)
+        if (manager->ping_interval > 0 && client->ping_sent == 0 && !client->resync_pending &&
+            now - client->last_recv >= manager->ping_interval) {
+            static const uint8_t ping[2] = {0x89, 0x00};
+            SharedFrame *shared = NULL;
+            int result = send_to_client(manager, client, ping, sizeof(ping), &shared, false);
+            if (shared != NULL) {
+                shared_frame_release(shared);
+            }
+            if (result == -1) {
+                removeClient(manager, client->socket_fd);
+                return;
+            }
+            client->ping_sent = now;
+            metrics_add(METRIC_PINGS_SENT, 1);
+        }
+    }
+    arm_client_timer(manager, client);
+}
+
+void expire_client_timers(ClientManager *manager) {
+    timer_wheel_advance(&manager->timers, (unsigned long)monotonic_seconds(), client_timer_expired, manager);
+}
+
 // 파일 디스크립터를 논블로킹 모드로 설정
 int set_nonblocking(const int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
     if (flags == -1) {
-        perror("fcntl F_GETFL");
+        LOG_ERROR("fcntl F_GETFL: %s", strerror(errno));
         return -1;
     }
     flags |= O_NONBLOCK;
     if (fcntl(fd, F_SETFL, flags) == -1) {
-        perror("fcntl F_SETFL");
+        LOG_ERROR("fcntl F_SETFL: %s", strerror(errno));
         return -1;
     }
     return 0;
 }
 
-//클라이언트 매니저 초기화 함수
-int initClientManager(
-    ClientManager* manager,
-    TaskQueue *canvas_queue,
-    const int port,
-    const int events_size,
-    const int queue_size
-    ) {
-
-    printf("[CM] 초기화 시작\n");
+// 서버 소켓을 epoll에 등록 (실패하면 종료)
+static void watch_listen_socket(ClientManager* manager) {
 
-    manager->port_number = port;
-    manager->canvas_queue = canvas_queue;
-    manager->client_count = 0;
-
-    // linked 리스트 초기화
-    manager->head = NULL;
+    manager->ev.events = EPOLLIN | EPOLLET;         // 읽기 이벤트 + Edge Triggered
+    manager->ev.data.fd = manager->server_socket;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, manager->server_socket, &manager->ev) == -1) {
+        LOG_ERROR("[CM] epoll_ctl failed: %s", strerror(errno));
+        destroy_task_queue(manager->queue);
+        close(manager->server_socket);
+        close(manager->epoll_fd);
+        free(manager);
+        exit(EXIT_FAILURE);
+    }
+    LOG_INFO("[CM] 서버 소켓 Epoll 등록 완료");
+}
 
-    // 이벤트 배열 초기화
-    manager->events = malloc(sizeof(struct epoll_event) * events_size);
-    printf("[CM]Epoll 이벤트 배열 할당 완료\n");
+// 리슨 소켓 생성, 바인딩, epoll 등록 (실패하면 종료)
+static void listen_on_port(ClientManager* manager, const int port) {
 
-    // Task Queue 할당
-    manager->queue = malloc(sizeof(TaskQueue));
-    init_task_queue(manager->queue, queue_size);
-    printf("[CM] Task Queue 초기화 완료\n");
+    // 이전 프로세스가 넘겨준 리슨 소켓이 있으면 그대로 쓴다 (무중단 재시작, 대기 중인 연결도 유지된다)
+    manager->server_socket = handoff_take_listen_socket();
+    if (manager->server_socket != -1) {
+        LOG_INFO("[CM] 이전 프로세스의 리슨 소켓을 넘겨받음");
+        watch_listen_socket(manager);
+        return;
+    }
 
     // 서버 소켓 생성
     manager->server_socket = socket(AF_INET, SOCK_STREAM, 0);
     if (manager->server_socket == -1) {
         destroy_task_queue(manager->queue);
-        perror("[CM]소켓 생성 실패");
+        LOG_ERROR("[CM]소켓 생성 실패: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
 
     // 디버깅용 옵션
     int optvalue=1;
     setsockopt(manager->server_socket, SOL_SOCKET, SO_REUSEADDR, &optvalue, sizeof(optvalue));
-    signal(SIGPIPE, SIG_IGN);
 
-    printf("[CM]서버 소켓 생성 완료\n");
+    LOG_INFO("[CM]서버 소켓 생성 완료");
 
     // 서버 소켓을 논블로킹 모드로 설정
     if (set_nonblocking(manager->server_socket) == -1) {
         destroy_task_queue(manager->queue);
         close(manager->server_socket);
+        close(manager->epoll_fd);
         free(manager);
         exit(EXIT_FAILURE);
     }
@@ -245,54 +536,139 @@ int initClientManager(
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(port);
 
-    printf("[CM]서버 구조체 생성 완료\n");
+    LOG_INFO("[CM]서버 구조체 생성 완료");
 
     // 소켓 바인딩
     if (bind(manager->server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        perror("[CM]bind failed");
+        LOG_ERROR("[CM]bind failed: %s", strerror(errno));
         destroy_task_queue(manager->queue);
         close(manager->server_socket);
+        close(manager->epoll_fd);
         free(manager);
         exit(EXIT_FAILURE);
     }
 
-    printf("[CM]서버 바인딩 완료\n");
+    LOG_INFO("[CM]서버 바인딩 완료");
 
     // 소켓 리슨
     if (listen(manager->server_socket, SOMAXCONN) == -1) {
-        perror("[CM]리슨 실패");
+        LOG_ERROR("[CM]리슨 실패: %s", strerror(errno));
         destroy_task_queue(manager->queue);
         close(manager->server_socket);
+        close(manager->epoll_fd);
         free(manager);
         exit(EXIT_FAILURE);
     }
 
-    printf("[CM]서버 리슨 완료\n");
+    LOG_INFO("[CM]서버 리슨 완료");
+
+    watch_listen_socket(manager);
+}
+
+// 초 단위 설정 (0이면 끄기, 없거나 음수면 기본값)
+static time_t env_seconds(const char *name, time_t fallback) {
+    const char *value = getenv(name);
+    return (value != NULL && atol(value) >= 0) ? (time_t)atol(value) : fallback;
+}
+
+//클라이언트 매니저 초기화 함수
+int initClientManager(
+    ClientManager* manager,
+    TaskQueue *canvas_queue,
+    const int port,
+    const int events_size,
+    const int queue_size
+    ) {
+
+    LOG_INFO("[CM] 초기화 시작");
+
+    manager->port_number = port;
+    manager->canvas_queue = canvas_queue;
+    manager->client_count = 0;
+
+    // linked 리스트 초기화
+    manager->head = NULL;
+    registry_init(&manager->registry);
+    manager->registry_reader = registry_register_reader(&manager->registry);
+    fanout_init(manager);
+
+    // 이벤트 배열 초기화
+    manager->events = malloc(sizeof(struct epoll_event) * events_size);
+    LOG_INFO("[CM]Epoll 이벤트 배열 할당 완료");
+
+    // Task Queue 할당
+    manager->queue = malloc(sizeof(TaskQueue));
+    init_task_queue(manager->queue, queue_size, "cm");
+    metrics_register_queue(manager->queue);
+    LOG_INFO("[CM] Task Queue 초기화 완료");
 
     // epoll 파일 디스크립터 생성
     manager->epoll_fd = epoll_create1(0);
     if (manager->epoll_fd == -1) {
-        perror("[CM]epoll 파일 디스크립터 생성 실패");
+        LOG_ERROR("[CM]epoll 파일 디스크립터 생성 실패: %s", strerror(errno));
         destroy_task_queue(manager->queue);
-        close(manager->server_socket);
         free(manager);
         exit(EXIT_FAILURE);
     }
 
-    printf("[CM]Epoll 파일 디스크립터 생성 완료\n");
+    LOG_INFO("[CM]Epoll 파일 디스크립터 생성 완료");
 
-    // 서버 소켓을 epoll에 등록
-    manager->ev.events = EPOLLIN | EPOLLET;         // 읽기 이벤트 + Edge Triggered
-    manager->ev.data.fd = manager->server_socket;
-    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, manager->server_socket, &manager->ev) == -1) {
-        perror("[CM] epoll_ctl failed");
-        destroy_task_queue(manager->queue);
-        close(manager->server_socket);
-        close(manager->epoll_fd);
-        free(manager);
+    signal(SIGPIPE, SIG_IGN);
+
+    // 리슨 소켓 (port 0이면 만들지 않는다: 시뮬레이션에서 socketpair를 TASK_REGISTER_CLIENT로 등록)
+    manager->server_socket = -1;
+    if (port != 0) {
+        listen_on_port(manager, port);
+    }
+
+    // 정적 파일 캐시 적재, 디렉토리 변경 감시를 epoll에 등록
+    manager->static_cache = malloc(sizeof(StaticCache));
+    init_static_cache(manager->static_cache, STATIC_FILES_DIR);
+    if (manager->static_cache->inotify_fd != -1) {
+        manager->ev.events = EPOLLIN | EPOLLET;
+        manager->ev.data.fd = manager->static_cache->inotify_fd;
+        if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, manager->static_cache->inotify_fd, &manager->ev) == -1) {
+            LOG_ERROR("[CM] inotify epoll 등록 실패: %s", strerror(errno));
+        }
+    }
+
+    // 유휴 연결 정리용 1초 주기 타이머
+    manager->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec interval = {{1, 0}, {1, 0}};
+    if (manager->timer_fd == -1 || timerfd_settime(manager->timer_fd, 0, &interval, NULL) == -1) {
+        LOG_ERROR("[CM] 타이머 생성 실패: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
-    printf("[CM] 서버 소켓 Epoll 등록 완료\n");
+    manager->ev.events = EPOLLIN | EPOLLET;
+    manager->ev.data.fd = manager->timer_fd;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, manager->timer_fd, &manager->ev) == -1) {
+        LOG_ERROR("[CM] 타이머 epoll 등록 실패: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    // 느린 클라이언트 송신 대기열 상한과 처리 방식
+    const char *limit = getenv("FAINTER_OUTBOUND_LIMIT");
+    manager->outbound_limit = (limit != NULL && atol(limit) > 0) ? (size_t)atol(limit) : OUTBOUND_DEFAULT_LIMIT;
+    const char *policy = getenv("FAINTER_SLOW_POLICY");
+    manager->slow_policy = (policy != NULL && strcmp(policy, "drop") == 0) ? SLOW_CONSUMER_DROP : SLOW_CONSUMER_RESYNC;
+    atomic_init(&manager->outbound_bytes, 0);
+    atomic_init(&manager->send_sweep, false);
+    const char *zerocopy = getenv("FAINTER_ZEROCOPY_THRESHOLD");
+    manager->zerocopy_threshold = zerocopy != NULL ? (size_t)atol(zerocopy) : OUTBOUND_ZEROCOPY_THRESHOLD;
+    manager->handoff_fd = -1;
+    manager->handoff_retry = NULL;
+
+    // 클라이언트 타이머 (핸드셰이크 마감, 유휴 연결, ping)
+    timer_wheel_init(&manager->timers, (unsigned long)monotonic_seconds());
+    manager->handshake_timeout = env_seconds("FAINTER_HANDSHAKE_TIMEOUT", HANDSHAKE_TIMEOUT_DEFAULT);
+    manager->idle_timeout = env_seconds("FAINTER_IDLE_TIMEOUT", 0);
+    manager->ping_interval = env_seconds("FAINTER_PING_INTERVAL", PING_INTERVAL_DEFAULT);
+    manager->pong_timeout = env_seconds("FAINTER_PONG_TIMEOUT", PONG_TIMEOUT_DEFAULT);
+
+    // fd 고갈(EMFILE) 대비 예비 fd
+    manager->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    manager->accept_paused = false;
+    memset(&manager->accept_stats, 0, sizeof(manager->accept_stats));
 
     // 스레드 생성 전에 스핀락 초기화
     pthread_spin_init(&manager->lock, PTHREAD_PROCESS_PRIVATE);
@@ -300,79 +676,205 @@ int initClientManager(
     // 스레드 생성
     const int n = pthread_create(&manager->tid, NULL, worker_thread, (void *)manager);
     if (n != 0) {
-        fprintf(stderr, "[CM] 스레드 생성 실패: %s\n", strerror(n));
+        LOG_ERROR("[CM] 스레드 생성 실패: %s", strerror(n));
         destroy_task_queue(manager->queue);
         close(manager->server_socket);
         close(manager->epoll_fd);
         free(manager);
         exit(EXIT_FAILURE);
     }
-    printf("[CM] 스레드 생성 완료\n");
+    LOG_INFO("[CM] 스레드 생성 완료");
 
 
-    printf("[CM] 초기화 완료 "
-           "Port: %d, "
-           "이벤트 버퍼 사이즈: %d, "
-           "Task Queue 사이즈 %d \n"
-           , port, events_size, queue_size);
+    LOG_INFO("[CM] 초기화 완료 "
+             "Port: %d, "
+             "이벤트 버퍼 사이즈: %d, "
+             "Task Queue 사이즈 %d"
+             , port, events_size, queue_size);
 
     return 0;
 }
 
-// 클라이언트 추가
-void addClient(ClientManager* manager) {
+// 소켓을 epoll에 등록하고 클라이언트 리스트에 추가 (mode, input: 메인 스레드가 이어서 나눌 모드와 조각)
+static int add_client(ClientManager* manager, const int client_socket, ConnInputMode mode, const char *input, size_t input_len) {
 
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    const int client_socket = accept(manager->server_socket, (struct sockaddr *)&client_addr, &client_len);
-
-    if (client_socket == -1) {
-        printf("[ERROR] 클라이언트 Accept 오류");
-        return;
-    }
-
-    // 클라이언트 소켓을 논블로킹 모드로 설정
-    if (set_nonblocking(client_socket) == -1) {
-        printf("[ERROR] 클라이언트 non blocking 설정 오류");
+    // 클라이언트 구조체 할당.
+    Client* new_client = (Client*)malloc(sizeof(Client));
+    if (!new_client) {
+        LOG_ERROR("[CM] 클라이언트 메모리 할당 오류");
         close(client_socket);
-        return;
+        return -1;
     }
 
-    // 클라이언트 소켓을 epoll에 등록
-    manager->ev.events = EPOLLIN | EPOLLET; // 읽기 이벤트 + Edge Triggered
-    manager->ev.data.fd = client_socket;
-    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, client_socket, &manager->ev) == -1) {
-        printf("[ERROR] 클라이언트 epoll 등록 오류");
-        close(client_socket);
-        return;
-    }
+    // 메인 스레드가 읽기 전에 속도 제한, 수신 조각 상태를 새 연결로
+    rate_limit_register(client_socket);
+    new_client->conn_gen = conn_input_register(client_socket, mode, input, input_len);
 
-    // 클라이언트 구조체 할당.
-    Client* new_client = (Client*)malloc(sizeof(Client));
-    if (!new_client) {
-        printf("[ERROR] 클라이언트 메모리 할당 오류");
-        epoll_ctl(manager->epoll_fd, EPOLL_CTL_DEL, client_socket, NULL);
+    // 클라이언트 소켓을 epoll에 등록
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET; // 읽기 이벤트 + Edge Triggered
+    ev.data.fd = client_socket;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) == -1) {
+        LOG_ERROR("[CM] 클라이언트 epoll 등록 오류: %s", strerror(errno));
+        free(new_client);
         close(client_socket);
-        return;
+        return -1;
     }
 
     // 클라이언트 구조체 작성
     new_client->socket_fd = client_socket;
     new_client->state = CONNECTION_HANDSHAKE;
     new_client->recv_buffer_len = 0;
-    memset(new_client->recv_buffer, 0, REQUEST_BUFFER_SIZE);
-    new_client->next = NULL;
     new_client->incomplete_frame = false;
-    new_client->incomplete_http = false;
+    new_client->last_active = monotonic_seconds();
+    new_client->connected_at = new_client->last_active;
+    new_client->last_recv = new_client->last_active;
+    new_client->last_message = new_client->last_active;
+    new_client->ping_sent = 0;
+    new_client->http_busy = false;
+    new_client->close_pending = false;
+    new_client->held_frames = NULL;
+    new_client->held_count = 0;
+    outbound_init(&new_client->outbound);
+    outbound_enable_zerocopy(&new_client->outbound, client_socket, manager->zerocopy_threshold);
+    new_client->resync_pending = false;
+    new_client->resync_requested = false;
+    timer_node_init(&new_client->timer);
+    new_client->registry_index = -1;
+    pthread_mutex_init(&new_client->send_lock, NULL);
+    new_client->send_failed = false;
+    arm_client_timer(manager, new_client);
 
     // 리스트의 맨 앞에 추가
     new_client->next = manager->head;
     manager->head = new_client;
+    return 0;
+}
+
+// 이미 accept된 소켓을 epoll에 등록하고 클라이언트 리스트에 추가
+int registerClient(ClientManager* manager, const int client_socket) {
+    return add_client(manager, client_socket, CONN_INPUT_HTTP, NULL, 0);
+}
 
-    // printf("새로운 클라이언트 접속: IP = %s, Port = %d\n", inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+// fd가 고갈되었을 때: 예비 fd를 잠시 반납해서 대기 중인 연결 하나를 받아 바로 닫고, 리슨 소켓 감시를 멈춘다
+static void pause_accepting(ClientManager* manager) {
+
+    if (manager->reserve_fd != -1) {
+        close(manager->reserve_fd);
+        int fd = accept(manager->server_socket, NULL, NULL);
+        if (fd != -1) {
+            close(fd);
+        }
+        manager->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+
+    if (!manager->accept_paused) {
+        epoll_ctl(manager->epoll_fd, EPOLL_CTL_DEL, manager->server_socket, NULL);
+        manager->accept_paused = true;
+        atomic_fetch_add(&manager->accept_stats.pauses, 1);
+        LOG_WARN("[CM] 파일 디스크립터 고갈, 새 연결 수락 일시 중지");
+    }
+}
+
+// fd에 여유가 생기면 리슨 소켓을 다시 epoll에 등록 (등록 시점에 대기 중인 연결이 있으면 바로 이벤트가 온다)
+void resume_accepting(ClientManager* manager) {
+
+    if (!manager->accept_paused) {
+        return;
+    }
+    if (manager->reserve_fd == -1) {
+        manager->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (manager->reserve_fd == -1) {
+            return;
+        }
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = manager->server_socket;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_ADD, manager->server_socket, &ev) == 0) {
+        manager->accept_paused = false;
+        LOG_INFO("[CM] 새 연결 수락 재개");
+    }
+}
+
+// 리슨 소켓 백로그를 EAGAIN이 나올 때까지 비우고, 받은 소켓을 묶음 단위로 등록
+void acceptClients(ClientManager* manager) {
+
+    if (manager->accept_paused) {
+        return;
+    }
+
+    int batch[ACCEPT_BATCH_SIZE];
+    while (1) {
+        int count = 0;
+        int error = 0;
+
+        // 1. 한 묶음만큼 accept (accept4로 논블로킹/CLOEXEC 설정까지 한 번에)
+        while (count < ACCEPT_BATCH_SIZE) {
+            int fd = accept4(manager->server_socket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd == -1) {
+                error = errno;
+                if (error == EINTR || error == ECONNABORTED) {
+                    continue;
+                }
+                break;
+            }
+            batch[count++] = fd;
+        }
+
+        // 2. 받은 소켓 등록
+        for (int i = 0; i < count; i++) {
+            registerClient(manager, batch[i]);
+        }
+        if (count > 0) {
+            atomic_fetch_add(&manager->accept_stats.accepted, count);
+            atomic_fetch_add(&manager->accept_stats.batches, 1);
+        }
+
+        if (count == ACCEPT_BATCH_SIZE) {
+            continue;   // 묶음이 꽉 찼으면 백로그에 더 남아 있을 수 있다
+        }
+        if (error == EMFILE || error == ENFILE) {
+            pause_accepting(manager);
+        }
+        else if (error != EAGAIN && error != EWOULDBLOCK && error != 0) {
+            LOG_WARN("[CM] 클라이언트 Accept 오류: %s", strerror(error));
+        }
+        return;
+    }
+}
+
+// 1초마다 호출: 초당 accept 수와 리슨 백로그 깊이 갱신
+void update_accept_stats(ClientManager* manager) {
+
+    AcceptStats *stats = &manager->accept_stats;
+    unsigned long accepted = atomic_load(&stats->accepted);
+    atomic_store(&stats->accept_rate, accepted - stats->last_accepted);
+    stats->last_accepted = accepted;
+
+    // LISTEN 소켓의 tcpi_unacked는 accept를 기다리는 연결 수, tcpi_sacked는 백로그 최대치
+    struct tcp_info info;
+    socklen_t info_len = sizeof(info);
+    if (getsockopt(manager->server_socket, IPPROTO_TCP, TCP_INFO, &info, &info_len) == 0) {
+        atomic_store(&stats->backlog_depth, info.tcpi_unacked);
+        atomic_store(&stats->backlog_max, info.tcpi_sacked);
+    }
+
+    // 일시 중지 상태라면 fd가 풀렸는지 다시 시도
+    resume_accepting(manager);
 }
 
 // 클라이언트 제거
+// 읽는 쪽이 모두 놓은 종료된 클라이언트 해제 (fd도 이때 닫는다: 먼저 닫으면 재사용된 fd에 보낼 수 있다)
+static void reclaim_client(EbrNode *node) {
+    Client *client = (Client *)((char *)node - offsetof(Client, retired));
+    close(client->socket_fd);
+    outbound_clear(&client->outbound);
+    pthread_mutex_destroy(&client->send_lock);
+    free(client);
+}
+
 int removeClient(ClientManager* manager, const int client_fd) {
 
     if (manager == NULL || client_fd <= 0) {
@@ -384,14 +886,48 @@ int removeClient(ClientManager* manager, const int client_fd) {
 
     while (current != NULL) {
         if (current->socket_fd == client_fd) {
+            // 워커가 응답을 쓰는 중에 fd를 닫으면 재사용된 fd에 쓸 수 있다
+            if (current->http_busy) {
+                current->close_pending = true;
+                return 0;
+            }
+            // 웹소켓 연결이 열린 채로 끊긴 경우 접속자 수 감소
+            if (current->state == CONNECTION_OPEN) {
+                pthread_spin_lock(&manager->lock);
+                manager->client_count--;
+                pthread_spin_unlock(&manager->lock);
+            }
             if (prev == NULL) {
                 manager->head = current->next;
             } else {
                 prev->next = current->next;
             }
+            // 업그레이드를 기다리던 frame
+            for (size_t i = 0; i < current->held_count; i++) {
+                free(current->held_frames[i].data);
+            }
+            free(current->held_frames);
+            current->held_frames = NULL;
+            current->held_count = 0;
+            timer_cancel(&manager->timers, &current->timer);
+            bool member = current->registry_index >= 0;
+            registry_remove(&manager->registry, current);
             epoll_ctl(manager->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
-            close(current->socket_fd);
-            free(current);
+            // 스냅샷으로 이 클라이언트를 보고 있는 쪽(송신 스레드)은 state로 거른다
+            pthread_mutex_lock(&current->send_lock);
+            current->state = CONNECTION_CLOSED;
+            size_t total = atomic_fetch_sub(&manager->outbound_bytes, current->outbound.bytes) - current->outbound.bytes;
+            pthread_mutex_unlock(&current->send_lock);
+            metrics_set_gauge(GAUGE_OUTBOUND_BYTES, total);
+            // 브로드캐스트 대상이었으면 지금 스냅샷에 남아 있다: 빠진 스냅샷을 단 뒤에 회수 (작업이 끝날 때 CM이 단다)
+            if (member) {
+                registry_retire_removed(&manager->registry, &current->retired, reclaim_client);
+            } else {
+                registry_retire(&manager->registry, &current->retired, reclaim_client);
+            }
+
+            // fd가 하나 반납되었으니 멈춰 있던 accept 재개
+            resume_accepting(manager);
             // printf("Client disconnected: FD %d\n", client_fd);
 
             return 0;
@@ -400,27 +936,294 @@ int removeClient(ClientManager* manager, const int client_fd) {
         current = current->next;
     }
 
-    printf("[CM]클라이언트 FD: %d 가 존재하지 않습니다.\n", client_fd);
+    LOG_DEBUG("[CM]클라이언트 FD: %d 가 존재하지 않습니다.", client_fd);
     return -1;
 }
 
-// 모든 클라이언트에게 메시지 보내기
-void broadcastClients(ClientManager* manager, char* message, size_t message_len) {
+// 송신 대기열이 남아 있는 동안만 쓰기 가능 이벤트를 받는다
+static void watch_writable(ClientManager* manager, Client* client, bool on) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET | (on ? EPOLLOUT : 0);
+    ev.data.fd = client->socket_fd;
+    if (epoll_ctl(manager->epoll_fd, EPOLL_CTL_MOD, client->socket_fd, &ev) == -1) {
+        LOG_WARN("[CM] EPOLLOUT 변경 실패 FD %d: %s", client->socket_fd, strerror(errno));
+    }
+}
 
-    if (message == NULL || manager == NULL) {
+// 대기열 크기가 바뀐 만큼 전체 대기 바이트 갱신
+static void account_outbound(ClientManager* manager, size_t before, size_t after) {
+    size_t total = atomic_fetch_add(&manager->outbound_bytes, after - before) + (after - before);
+    metrics_set_gauge(GAUGE_OUTBOUND_BYTES, total);
+}
+
+// 대기열을 다 비운 느린 클라이언트에게 새 스냅샷 요청 (캔버스가 새 참여자처럼 다음 스냅샷에 넣는다)
+// send_lock을 잡은 송신 스레드도 부르므로 기다리지 않는다: 캔버스 큐가 가득 차면 타이머 틱에 다시 요청
+static void request_resync(ClientManager* manager, Client* client) {
+    if (client->resync_requested) {
         return;
     }
+    Task task = {client->socket_fd, TASK_RESYNC_CLIENT, NULL, 0, 0, 0};
+    client->resync_requested = push_task(manager->canvas_queue, task);
+    if (!client->resync_requested) {
+        atomic_store(&manager->send_sweep, true);
+    }
+}
 
+void sweep_send_state(ClientManager* manager) {
+
+    if (!atomic_exchange(&manager->send_sweep, false)) {
+        return;
+    }
     Client* current = manager->head;
-    while (current != NULL && current->state == CONNECTION_OPEN) {
-        // printf("broadcasting Client: %d\n", current->socket_fd);
-        if (send(current->socket_fd, message, message_len, MSG_NOSIGNAL) == -1) {
-            perror("[CM] 브로드캐스팅 오류");
+    while (current != NULL) {
+        Client* next = current->next;
+        if (current->send_failed) {
             removeClient(manager, current->socket_fd);
         }
-        current = current->next;
+        else if (current->resync_pending) {
+            pthread_mutex_lock(&current->send_lock);
+            if (current->outbound.head == NULL) {
+                request_resync(manager, current);
+            }
+            pthread_mutex_unlock(&current->send_lock);
+        }
+        current = next;
+    }
+}
+
+// send_lock을 잡은 상태에서
+static int send_locked(ClientManager* manager, Client* client, const uint8_t* data, size_t len, SharedFrame** shared, bool snapshot) {
+
+    // 스냅샷으로 다시 맞출 클라이언트에게 그 전 변경분은 의미가 없다
+    if (client->resync_pending && !snapshot) {
+        metrics_add(METRIC_FRAMES_DISCARDED, 1);
+        return 0;
+    }
+
+    OutboundQueue *queue = &client->outbound;
+    size_t before = queue->bytes;
+    size_t offset = 0;
+
+    // 스냅샷은 아직 보내지 않은 변경분을 모두 포함한다
+    if (snapshot) {
+        metrics_add(METRIC_FRAMES_DISCARDED, outbound_discard_pending(queue));
+        client->resync_pending = false;
+        client->resync_requested = false;
+    }
+
+    if (queue->head == NULL) {
+        // 대기열이 비어 있으면 바로 보낸다 (대부분의 경우)
+        // 큰 frame은 공유 frame에서 MSG_ZEROCOPY로 (완료 알림이 올 때까지 커널이 frame 페이지를 물고 있다)
+        if (*shared == NULL && queue->zerocopy_threshold != 0 && len >= queue->zerocopy_threshold) {
+            *shared = shared_frame_create(data, len, 1);
+        }
+        ssize_t n = *shared != NULL ? outbound_send(queue, client->socket_fd, *shared, 0)
+                                    : send(client->socket_fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            LOG_WARN("[CM] 전송 오류 FD %d: %s", client->socket_fd, strerror(errno));
+            account_outbound(manager, before, queue->bytes);
+            return -1;
+        }
+        if (n > 0) {
+            metrics_add(METRIC_BYTES_OUT, n);
+            offset = n;
+        }
+        if (offset == len) {
+            account_outbound(manager, before, queue->bytes);
+            return 0;
+        }
+    }
+    else if (!snapshot && queue->bytes + len > manager->outbound_limit) {
+        // 느린 소비자: 상한을 넘기면 끊거나, 쌓인 변경분을 버리고 스냅샷으로 다시 맞춘다
+        if (manager->slow_policy == SLOW_CONSUMER_DROP) {
+            LOG_INFO("[CM] 느린 클라이언트 연결 종료 FD %d: 대기 %zu 바이트", client->socket_fd, queue->bytes);
+            metrics_add(METRIC_SLOW_DISCONNECTS, 1);
+            return -1;
+        }
+        LOG_INFO("[CM] 느린 클라이언트 재동기화 FD %d: 대기 %zu 바이트", client->socket_fd, queue->bytes);
+        metrics_add(METRIC_SLOW_RESYNCS, 1);
+        metrics_add(METRIC_FRAMES_DISCARDED, outbound_discard_pending(queue) + 1);
+        client->resync_pending = true;
+        account_outbound(manager, before, queue->bytes);
+        if (queue->head == NULL) {
+            watch_writable(manager, client, false);
+            request_resync(manager, client);
+        }
+        return 0;
+    }
+
+    // 남은 부분은 대기열로 (frame은 처음 필요할 때 한 번만 복사해서 다른 클라이언트와 나눠 쓴다)
+    if (*shared == NULL) {
+        *shared = shared_frame_create(data, len, 1);
+    }
+    bool was_empty = queue->head == NULL;
+    if (*shared == NULL || !outbound_push(queue, *shared, offset)) {
+        LOG_ERROR("[CM] 송신 대기열 할당 실패 FD %d", client->socket_fd);
+        account_outbound(manager, before, queue->bytes);
+        return -1;
+    }
+    if (was_empty) {
+        watch_writable(manager, client, true);
+    }
+    account_outbound(manager, before, queue->bytes);
+    return 0;
+}
+
+int send_to_client(ClientManager* manager, Client* client, const uint8_t* data, size_t len, SharedFrame** shared, bool snapshot) {
+    pthread_mutex_lock(&client->send_lock);
+    int result = send_locked(manager, client, data, len, shared, snapshot);
+    pthread_mutex_unlock(&client->send_lock);
+    return result;
+}
+
+void fanout_send_to_client(ClientManager* manager, Client* client, SharedFrame* frame) {
+
+    pthread_mutex_lock(&client->send_lock);
+    // 스냅샷 이후 종료 중이거나 제거됐다
+    if (client->state == CONNECTION_OPEN && !client->send_failed &&
+        send_locked(manager, client, frame->data, frame->len, &frame, false) == -1) {
+        // 송신 스레드는 CM 큐를 기다리면 안 된다 (CM이 fanout_submit에서 송신 스레드를 기다릴 수 있다)
+        client->send_failed = true;
+        Task task = {client->socket_fd, TASK_SEND_FAILED, NULL, 0, 0, 0};
+        if (!push_task(manager->queue, task)) {
+            atomic_store(&manager->send_sweep, true);
+        }
+    }
+    pthread_mutex_unlock(&client->send_lock);
+}
+
+static int flush_locked(ClientManager* manager, Client* client) {
+
+    size_t before = client->outbound.bytes;
+    size_t sent = 0;
+    int result = outbound_flush(&client->outbound, client->socket_fd, &sent);
+    metrics_add(METRIC_BYTES_OUT, sent);
+    account_outbound(manager, before, client->outbound.bytes);
+
+    if (result == -1) {
+        LOG_WARN("[CM] 대기열 전송 오류 FD %d: %s", client->socket_fd, strerror(errno));
+        return -1;
+    }
+    if (result == 0) {
+        // 다 보냈다: 변경분을 버린 클라이언트라면 이제 스냅샷을 받을 차례
+        watch_writable(manager, client, false);
+        if (client->resync_pending) {
+            request_resync(manager, client);
+        }
+    }
+    return 0;
+}
+
+int flush_client(ClientManager* manager, Client* client) {
+    pthread_mutex_lock(&client->send_lock);
+    int result = flush_locked(manager, client);
+    pthread_mutex_unlock(&client->send_lock);
+    return result;
+}
+
+// 이전 프로세스에서 넘겨받은 연결 (무중단 재시작)
+int adoptClient(ClientManager* manager, const int client_socket, const HandoffClient* record) {
+
+    ConnInputMode mode = record->input_frames ? CONN_INPUT_FRAMES : CONN_INPUT_HTTP;
+    if (add_client(manager, client_socket, mode, (const char *)record->data + record->recv_len, record->input_len) == -1) {
+        return -1;
+    }
+    Client* client = manager->head;
+
+    client->state = record->state == CONNECTION_OPEN ? CONNECTION_OPEN : CONNECTION_HANDSHAKE;
+    memcpy(client->recv_buffer, record->data, record->recv_len);
+    client->recv_buffer_len = record->recv_len;
+    client->incomplete_frame = record->incomplete_frame;
+    client->frame_recv_ns = monotonic_ns();
+    if (client->state == CONNECTION_OPEN) {
+        pthread_spin_lock(&manager->lock);
+        manager->client_count++;
+        pthread_spin_unlock(&manager->lock);
+        registry_add(&manager->registry, client);
+    }
+    arm_client_timer(manager, client);
+
+    // 이전 프로세스가 보내지 못한 바이트 (frame 중간일 수 있다)
+    if (record->pending_len > 0) {
+        SharedFrame *shared = NULL;
+        const uint8_t *pending = record->data + record->recv_len + record->input_len;
+        int result = send_to_client(manager, client, pending, record->pending_len, &shared, false);
+        if (shared != NULL) {
+            shared_frame_release(shared);
+        }
+        if (result == -1) {
+            removeClient(manager, client_socket);
+            return -1;
+        }
+    }
+
+    // 변경분을 버린 느린 클라이언트는 대기열을 다 보낸 뒤 스냅샷을 받는다
+    if (record->resync && client->state == CONNECTION_OPEN) {
+        client->resync_pending = true;
+        if (client->outbound.head == NULL) {
+            request_resync(manager, client);
+        }
+    }
+    return 0;
+}
+
+// 모든 클라이언트에게 메시지 보내기
+void broadcastClients(ClientManager* manager, char* message, size_t message_len, unsigned long recv_ns) {
+
+    if (message == NULL || manager == NULL) {
+        return;
+    }
+
+    unsigned long start = monotonic_ns();
+
+    // 송신 스레드가 있으면 넘기고 바로 돌아간다 (metrics는 마지막 송신 스레드가 남긴다)
+    if (fanout_threads() > 0) {
+        fanout_submit(message, message_len, start, recv_ns);
+        free(message);
+        return;
+    }
+
+    // 지난 틱 이후 접속/종료가 있었으면 새 스냅샷
+    registry_publish(&manager->registry);
+    const ClientSnapshot *snapshot = registry_acquire(&manager->registry, manager->registry_reader);
+
+    // 느린 클라이언트 대기열에 넣을 때만 공유 frame으로 복사한다 (모두 바로 보내면 복사 없음)
+    SharedFrame *shared = NULL;
+    for (size_t i = 0; i < snapshot->count; i++) {
+        Client* current = snapshot->clients[i];   // 보내다 실패해서 제거해도 release 전까지는 해제되지 않는다
+        if (current->state == CONNECTION_OPEN) {
+            unsigned long trace_start_ns = trace_begin();
+            int result = send_to_client(manager, current, (uint8_t *)message, message_len, &shared, false);
+            trace_end("send", trace_start_ns, current->socket_fd);
+            if (result == -1) {
+                removeClient(manager, current->socket_fd);
+            }
+        }
+    }
+    registry_release(&manager->registry, manager->registry_reader);
+    registry_reclaim(&manager->registry);
+    if (shared != NULL) {
+        shared_frame_release(shared);
     }
     free(message);
+
+    record_broadcast(start, message_len, recv_ns);
+}
+
+// 브로드캐스트 한 번의 팬아웃 시간 (start_ns부터 마지막 send까지)
+void record_broadcast(unsigned long start, size_t message_len, unsigned long recv_ns) {
+
+    unsigned long end = monotonic_ns();
+    metrics_add(METRIC_BROADCASTS, 1);
+    metrics_add(METRIC_BROADCAST_FANOUT_NS, end - start);
+    metrics_record(HIST_FANOUT, end - start);
+    if (trace_on()) {
+        trace_record("fanout", start, end - start, message_len);
+    }
+    // 이번 틱에서 가장 먼저 도착한 픽셀의 수신 시각부터 마지막 send까지
+    if (recv_ns != 0) {
+        metrics_record(HIST_END_TO_END, end - recv_ns);
+    }
 }
 
 // 클라이언트 매니저 정리
@@ -431,16 +1234,24 @@ void destroyClientManger(ClientManager* manager) {
     while (current != NULL) {
         Client* temp = current;
         current = current->next;
+        outbound_clear(&temp->outbound);
         free(temp->recv_buffer);
         close(temp->socket_fd);
         free(temp);
     }
     manager->head = NULL;
+    registry_reclaim(&manager->registry);
+    registry_destroy(&manager->registry);
 
     destroy_task_queue(manager->queue);
+    destroy_static_cache(manager->static_cache);
     pthread_spin_destroy(&manager->lock);
     close(manager->server_socket);
     close(manager->epoll_fd);
+    close(manager->timer_fd);
+    if (manager->reserve_fd != -1) {
+        close(manager->reserve_fd);
+    }
     free(manager->events);
     free(manager);
     
@@ -5,9 +5,20 @@
 #include <task_queue.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include "static_cache.h"
+#include "outbound.h"
+#include "timer_wheel.h"
+#include "client_registry.h"
 
 #define REQUEST_BUFFER_SIZE 1024 * 4 // 4KB
 #define STATIC_FILES_DIR "./static"
+#define ACCEPT_BATCH_SIZE 64          // 한 번에 accept해서 등록하는 소켓 수
+#define HELD_FRAMES_MAX 64            // 업그레이드(101)를 마치기 전에 받아 모아두는 frame 수, 넘으면 연결 종료
+#define HANDSHAKE_TIMEOUT_DEFAULT 10  // 접속 후 WebSocket 업그레이드까지 (초), FAINTER_HANDSHAKE_TIMEOUT 로 변경 (0이면 없음)
+#define PING_INTERVAL_DEFAULT 30      // 아무것도 받지 못한 채 이만큼 지나면 ping (초), FAINTER_PING_INTERVAL 로 변경 (0이면 없음)
+#define PONG_TIMEOUT_DEFAULT 10       // ping 후 이만큼 아무것도 받지 못하면 종료 (초), FAINTER_PONG_TIMEOUT 로 변경
+                                      // FAINTER_IDLE_TIMEOUT: 메세지 없이 유지하는 WebSocket 연결 (초, 기본 0: 없음)
 
 
 typedef enum {
@@ -20,20 +31,51 @@ typedef enum {
 // 클라이언트 정보를 담는 구조체
 typedef struct Client {
     int socket_fd;              // 클라이언트 소켓 파일 디스크립터
+    unsigned int conn_gen;      // 등록할 때 받은 연결 세대 (conn_input, 메인 스레드가 읽은 작업의 세대와 맞춰 본다)
     struct Client* next;        // 다음 클라이언트를 가리키는 포인터
 
     // websocket을 위해 추가한 것
     ConnectionState state;                      // 연결 상태
     char recv_buffer[REQUEST_BUFFER_SIZE];      // 수신 버퍼
     size_t recv_buffer_len;                     // 수신 버퍼에 저장된 데이터 길이
-    bool incomplete_http;                       // http 요청 조각 상태
     bool incomplete_frame;                      // frame 요청 조각 상태
-    
+    unsigned long frame_recv_ns;                // 조각난 frame의 첫 조각 수신 시각
+    time_t last_active;                         // 마지막으로 HTTP 요청을 받은 시각 (keep-alive 유휴 검사)
+    bool http_busy;                             // 작업 풀 워커가 이 소켓에 HTTP 응답을 쓰는 중
+    bool close_pending;                         // 응답 중에 닫기로 해서 완료 후 닫는다
+    Task *held_frames;                          // 업그레이드 요청 뒤에 붙어 와서 101을 보낼 때까지 모아둔 frame (없으면 NULL)
+    size_t held_count;
+    OutboundQueue outbound;                     // 소켓이 받지 못해 남은 frame (EPOLLOUT에서 이어서 보낸다)
+    bool resync_pending;                        // 변경분을 버렸다: 스냅샷을 받을 때까지 브로드캐스트 생략
+    bool resync_requested;                      // 캔버스에 새 스냅샷을 요청했다
+    TimerNode timer;                            // 다음 마감: 핸드셰이크, 유휴, ping (ClientManager.timers)
+    time_t connected_at;                        // 접속 시각 (핸드셰이크 마감)
+    time_t last_recv;                           // 마지막으로 frame을 받은 시각 (ping, pong 포함)
+    time_t last_message;                        // 마지막으로 메세지를 받은 시각 (WebSocket 유휴 검사)
+    time_t ping_sent;                           // 답을 기다리는 ping을 보낸 시각 (0이면 없음)
+    int registry_index;                         // 브로드캐스트 대상 목록의 자리 (-1: 대상 아님)
+    EbrNode retired;                            // 종료 후 읽는 쪽이 모두 놓으면 해제
+    pthread_mutex_t send_lock;                  // 송신 상태(state, outbound, resync)를 송신 스레드와 나눠 쓴다
+    bool send_failed;                           // 송신 스레드가 보내다 실패했다 (CM이 제거, 알림이 버려지면 타이머 틱에)
+
 } Client;
 
+// accept 통계 (CM 스레드가 갱신, 다른 스레드는 읽기만)
+typedef struct {
+    atomic_ulong accepted;               // 누적 accept 수
+    atomic_ulong batches;                // 누적 accept 묶음 수
+    atomic_ulong pauses;                 // fd 고갈로 accept를 멈춘 횟수
+    atomic_ulong accept_rate;            // 최근 1초 동안의 accept 수
+    atomic_ulong backlog_depth;          // 리슨 소켓에서 accept를 기다리는 연결 수
+    atomic_ulong backlog_max;            // 리슨 백로그 최대치
+    unsigned long last_accepted;         // accept_rate 계산용
+} AcceptStats;
+
 // 클라이언트 매니저 구조체
 typedef struct {
-    Client* head;                        // 연결 리스트의 시작점
+    Client* head;                        // 연결 리스트의 시작점 (CM만)
+    ClientRegistry registry;             // 브로드캐스트 대상 (읽는 쪽은 락 없이 스냅샷을 본다)
+    int registry_reader;                 // CM이 브로드캐스트할 때 쓰는 읽는 쪽 자리
     TaskQueue* canvas_queue;             // 캔버스 Task Queue
     int server_socket;                   // 서버 소켓 파일 디스크립터
     int port_number;                     // 서버 포트 번호
@@ -44,23 +86,90 @@ typedef struct {
     TaskQueue *queue;                    // Task Queue
     int client_count;                    // 접속한 클라이언트 수
     pthread_spinlock_t lock;
+    StaticCache *static_cache;           // 정적 파일 캐시
+    int timer_fd;                        // 주기 작업(클라이언트 타이머, accept 통계)용 1초 timerfd
+    TimerWheel timers;                   // 클라이언트 타이머 (tick: 단조 시계 초)
+    time_t handshake_timeout;            // 0이면 없음
+    time_t idle_timeout;                 // 0이면 없음
+    time_t ping_interval;                // 0이면 ping 없음
+    time_t pong_timeout;
+    int reserve_fd;                      // EMFILE 대응용 예비 fd
+    bool accept_paused;                  // fd 고갈로 리슨 소켓 감시를 멈춘 상태
+    AcceptStats accept_stats;            // accept 통계
+    size_t outbound_limit;               // 클라이언트당 송신 대기 바이트 상한
+    SlowConsumerPolicy slow_policy;      // 상한을 넘긴 클라이언트 처리 방식
+    atomic_size_t outbound_bytes;        // 모든 송신 대기열에 남은 바이트
+    size_t zerocopy_threshold;           // 이 크기 이상인 frame은 MSG_ZEROCOPY (0이면 끔)
+    atomic_bool send_sweep;              // 큐가 가득 차서 넘기지 못한 제거/재동기화 요청이 있다 (타이머 틱에 훑는다)
+    int handoff_fd;                      // 다음 프로세스를 기다리는 유닉스 소켓 (무중단 재시작, 없으면 -1)
+    struct HandoffJob *handoff_retry;    // 캔버스 큐가 가득 차서 넘기지 못한 넘겨주기 (타이머 틱에 다시)
 } ClientManager;
 
+struct HandoffClient;
+
+// 단조 증가 시계 (초)
+time_t monotonic_seconds(void);
+
+// 만료된 클라이언트 타이머 처리: 핸드셰이크 마감, 유휴 연결 정리, ping 보내기, pong 없는 연결 정리 (1초 주기)
+void expire_client_timers(ClientManager *manager);
+
+// 큐가 가득 차서 넘기지 못한 송신 실패 제거, 재동기화 요청을 다시 처리 (1초 주기)
+void sweep_send_state(ClientManager *manager);
+
+// 클라이언트 상태에 맞는 다음 마감으로 타이머 예약 (상태가 바뀔 때)
+void arm_client_timer(ClientManager *manager, Client *client);
+
+// 클라이언트에게서 frame을 받았다 (message: 데이터 frame), 타이머는 만료될 때 다시 계산한다
+static inline void client_received(ClientManager *manager, Client *client, bool message) {
+    client->last_recv = (time_t)manager->timers.now;
+    client->ping_sent = 0;
+    if (message) {
+        client->last_message = client->last_recv;
+    }
+}
+
 int process_buffer(ClientManager *manager, Client *client, char *buffer, size_t len);
 
 int set_nonblocking(const int fd);
 
-// 클라이언트 매니저 초기화
+// 클라이언트 매니저 초기화 (port가 0이면 리슨 소켓 없이 시작, 소켓은 TASK_REGISTER_CLIENT로 등록)
 int initClientManager(ClientManager* manager, TaskQueue *canvas_queue, const int port, const int events_size, const int queue_size);
 
-// 클라이언트 추가
-void addClient(ClientManager* manager);
+// 리슨 백로그를 비울 때까지 accept 해서 클라이언트 추가
+void acceptClients(ClientManager* manager);
 
-// 클라이언트 제거
+// accept된 소켓을 클라이언트로 등록
+int registerClient(ClientManager* manager, const int client_socket);
+
+// 이전 프로세스에서 넘겨받은 소켓을 프로토콜 상태와 함께 등록 (무중단 재시작)
+int adoptClient(ClientManager* manager, const int client_socket, const struct HandoffClient* record);
+
+// fd 고갈로 멈춘 accept 재개
+void resume_accepting(ClientManager* manager);
+
+// accept 속도, 백로그 깊이 갱신 (1초 주기)
+void update_accept_stats(ClientManager* manager);
+
+// 클라이언트 제거 (워커가 HTTP 응답을 쓰는 중이면 완료 후로 미룬다)
+// 목록에서 바로 빼고, 소켓을 닫고 해제하는 것은 브로드캐스트 스냅샷을 보는 쪽이 모두 놓은 뒤에 한다
 int removeClient(ClientManager* manager, const int client_fd);
 
-// 모든 클라이언트에게 메시지 보내기
-void broadcastClients(ClientManager* manager, char* message, size_t message_len);
+// 클라이언트에게 frame 보내기 (다 못 보낸 부분은 송신 대기열에 넣고 EPOLLOUT을 기다린다)
+// shared가 가리키는 frame이 없으면 대기열에 넣거나 MSG_ZEROCOPY로 보낼 때 만든다 (호출자가 해제). 연결을 끊어야 하면 -1
+int send_to_client(ClientManager* manager, Client* client, const uint8_t* data, size_t len, SharedFrame** shared, bool snapshot);
+
+// 송신 대기열을 소켓에 쓸 수 있는 만큼 보내기 (EPOLLOUT), 연결을 끊어야 하면 -1
+int flush_client(ClientManager* manager, Client* client);
+
+// 모든 클라이언트에게 메시지 보내기 (송신 스레드가 있으면 넘기고 바로 반환)
+void broadcastClients(ClientManager* manager, char* message, size_t message_len, unsigned long recv_ns);
+
+// 송신 스레드: 스냅샷에 있던 클라이언트에게 브로드캐스트 frame 보내기
+// 그 사이 종료됐으면 건너뛰고, 보내다 실패하면 CM이 제거하도록 TASK_SEND_FAILED를 넣는다
+void fanout_send_to_client(ClientManager* manager, Client* client, SharedFrame* frame);
+
+// 브로드캐스트 한 번 끝 (팬아웃 시간, 수신 -> 마지막 send 지연 기록)
+void record_broadcast(unsigned long start_ns, size_t message_len, unsigned long recv_ns);
 
 // 클라이언트 매니저 정리 (모든 클라이언트 제거 및 메모리 해제)
 void destroyClientManger(ClientManager* manager);
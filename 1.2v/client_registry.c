@@ -0,0 +1,125 @@
+#include "client_registry.h"
+#include <stdlib.h>
+#include <string.h>
+#include "client_manager.h"
+#include "log.h"
+
+#define REGISTRY_INITIAL_CAPACITY 64
+
+static ClientSnapshot *create_snapshot(struct Client **clients, size_t count) {
+
+    ClientSnapshot *snapshot = (ClientSnapshot *)malloc(sizeof(ClientSnapshot) + count * sizeof(struct Client *));
+    if (snapshot == NULL) {
+        return NULL;
+    }
+    snapshot->count = count;
+    if (count > 0) {
+        memcpy(snapshot->clients, clients, count * sizeof(struct Client *));
+    }
+    return snapshot;
+}
+
+static void free_snapshot(EbrNode *node) {
+    free((ClientSnapshot *)((char *)node - offsetof(ClientSnapshot, retired)));
+}
+
+void registry_init(ClientRegistry *registry) {
+
+    ebr_init(&registry->ebr);
+    registry->capacity = REGISTRY_INITIAL_CAPACITY;
+    registry->members = (struct Client **)malloc(registry->capacity * sizeof(struct Client *));
+    registry->count = 0;
+    registry->dirty = false;
+    registry->removed = NULL;
+    ClientSnapshot *empty = create_snapshot(NULL, 0);
+    if (registry->members == NULL || empty == NULL) {
+        LOG_ERROR("[CM] 클라이언트 목록 할당 실패");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&registry->current, empty);
+}
+
+void registry_destroy(ClientRegistry *registry) {
+    // 읽는 쪽은 모두 끝났다
+    while (registry->removed != NULL) {
+        EbrNode *node = registry->removed;
+        registry->removed = node->next;
+        node->reclaim(node);
+    }
+    free(atomic_load(&registry->current));
+    free(registry->members);
+    registry->members = NULL;
+}
+
+void registry_add(ClientRegistry *registry, Client *client) {
+
+    if (registry->count == registry->capacity) {
+        size_t capacity = registry->capacity * 2;
+        Client **members = (Client **)realloc(registry->members, capacity * sizeof(Client *));
+        if (members == NULL) {
+            LOG_ERROR("[CM] 클라이언트 목록 확장 실패 FD %d", client->socket_fd);
+            return;
+        }
+        registry->members = members;
+        registry->capacity = capacity;
+    }
+    client->registry_index = (int)registry->count;
+    registry->members[registry->count++] = client;
+    registry->dirty = true;
+}
+
+void registry_remove(ClientRegistry *registry, Client *client) {
+
+    int index = client->registry_index;
+    if (index < 0) {
+        return;
+    }
+    // 마지막 항목을 빈자리로 옮긴다 (브로드캐스트 순서는 상관없다)
+    Client *last = registry->members[--registry->count];
+    registry->members[index] = last;
+    last->registry_index = index;
+    client->registry_index = -1;
+    registry->dirty = true;
+}
+
+void registry_publish(ClientRegistry *registry) {
+
+    if (!registry->dirty) {
+        return;
+    }
+    ClientSnapshot *snapshot = create_snapshot(registry->members, registry->count);
+    if (snapshot == NULL) {
+        LOG_ERROR("[CM] 클라이언트 스냅샷 할당 실패, 이전 목록으로 보낸다");
+        return;
+    }
+    ClientSnapshot *previous = atomic_exchange(&registry->current, snapshot);
+    registry->dirty = false;
+    ebr_retire(&registry->ebr, &previous->retired, free_snapshot);
+
+    // 이제 새로 들어오는 읽는 쪽은 빠진 Client를 볼 수 없다
+    while (registry->removed != NULL) {
+        EbrNode *node = registry->removed;
+        registry->removed = node->next;
+        ebr_retire(&registry->ebr, node, node->reclaim);
+    }
+    ebr_reclaim(&registry->ebr);
+}
+
+void registry_retire_removed(ClientRegistry *registry, EbrNode *node, void (*reclaim)(EbrNode *node)) {
+    node->reclaim = reclaim;
+    node->next = registry->removed;
+    registry->removed = node;
+}
+
+void registry_retire(ClientRegistry *registry, EbrNode *node, void (*reclaim)(EbrNode *node)) {
+    ebr_retire(&registry->ebr, node, reclaim);
+    ebr_reclaim(&registry->ebr);
+}
+
+void registry_reclaim(ClientRegistry *registry) {
+    ebr_reclaim(&registry->ebr);
+}
+
+int registry_register_reader(ClientRegistry *registry) {
+    return ebr_register(&registry->ebr);
+}
@@ -0,0 +1,73 @@
+#ifndef CLIENT_REGISTRY_H
+#define CLIENT_REGISTRY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ebr.h"
+
+// 브로드캐스트 대상(WebSocket 연결) 목록
+// CM이 접속/종료할 때 작업용 배열을 고치고, 바뀐 게 있으면 브로드캐스트 전에 바꿀 수 없는 스냅샷으로 복사해서
+// 포인터를 바꿔 단다 (틱마다 최대 한 번 복사). 읽는 쪽은 락 없이 스냅샷을 훑고,
+// 이전 스냅샷과 목록에서 빠진 Client는 EBR로 읽는 쪽이 모두 나간 뒤에 해제한다.
+// 목록에서 빠진 Client는 지금 스냅샷에 아직 들어 있으므로, 그 Client가 없는 스냅샷을 단 뒤에야 회수 대기로 넘긴다
+// (먼저 넘기면 그 뒤에 들어온 읽는 쪽이 지금 스냅샷에서 해제된 Client를 볼 수 있다).
+
+struct Client;
+
+// 바꿀 수 없는 스냅샷
+typedef struct {
+    EbrNode retired;
+    size_t count;
+    struct Client *clients[];
+} ClientSnapshot;
+
+typedef struct {
+    _Atomic(ClientSnapshot *) current;  // 읽는 쪽이 보는 스냅샷
+    EbrDomain ebr;
+    // 여기부터는 CM만
+    struct Client **members;            // 작업용 배열 (Client.registry_index 자리)
+    size_t count;
+    size_t capacity;
+    bool dirty;                         // 마지막 스냅샷 이후 바뀌었다
+    EbrNode *removed;                   // 목록에서 빠졌지만 지금 스냅샷에 남아 있는 Client (다음 스냅샷을 달면 회수 대기로)
+} ClientRegistry;
+
+void registry_init(ClientRegistry *registry);
+void registry_destroy(ClientRegistry *registry);
+
+// CM: 작업용 배열에 추가/제거 (O(1), 스냅샷은 registry_publish 에서)
+void registry_add(ClientRegistry *registry, struct Client *client);
+void registry_remove(ClientRegistry *registry, struct Client *client);
+
+// CM: 바뀐 게 있으면 새 스냅샷을 달고 이전 스냅샷과 목록에서 빠진 Client를 회수 대기로
+void registry_publish(ClientRegistry *registry);
+
+// CM: registry_remove로 뺀 Client 회수 (지금 스냅샷에서 빠질 때까지 미룬다)
+void registry_retire_removed(ClientRegistry *registry, EbrNode *node, void (*reclaim)(EbrNode *node));
+
+// CM: 미뤄둔 Client가 있으면 새 스냅샷을 단다 (작업 하나가 끝날 때마다, 여러 종료를 스냅샷 한 번으로)
+static inline void registry_flush_removed(ClientRegistry *registry) {
+    if (registry->removed != NULL) {
+        registry_publish(registry);
+    }
+}
+
+// CM: 읽는 쪽이 볼 수 있던 객체 회수 (읽는 쪽이 모두 나갔으면 바로)
+void registry_retire(ClientRegistry *registry, EbrNode *node, void (*reclaim)(EbrNode *node));
+void registry_reclaim(ClientRegistry *registry);
+
+// 읽는 스레드: 자리 번호 받기 (스레드마다 한 번)
+int registry_register_reader(ClientRegistry *registry);
+
+// 읽는 스레드: release 전까지 스냅샷과 그 안의 Client는 해제되지 않는다 (종료된 Client는 state로 거른다)
+static inline const ClientSnapshot *registry_acquire(ClientRegistry *registry, int reader) {
+    ebr_enter(&registry->ebr, reader);
+    return atomic_load_explicit(&registry->current, memory_order_acquire);
+}
+
+static inline void registry_release(ClientRegistry *registry, int reader) {
+    ebr_exit(&registry->ebr, reader);
+}
+
+#endif // CLIENT_REGISTRY_H
@@ -0,0 +1,124 @@
+#include "conn_input.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include "log.h"
+
+#define CONN_INPUT_MAX_FDS (1 << 20)      // 이보다 큰 fd는 다루지 않는다
+
+// 넘겨받은 연결이 이전 프로세스에서 나누지 못한 조각 (메인 스레드가 가져간다)
+typedef struct {
+    size_t len;
+    char data[];
+} ConnInputSeed;
+
+// CM이 쓰고 메인 스레드가 읽는 연결 등록 정보
+typedef struct {
+    atomic_uint gen;            // 등록할 때마다 증가 (fd 재사용 구분)
+    atomic_int mode;
+    _Atomic(ConnInputSeed *) seed;
+} ConnInputRegistration;
+
+static int max_fds = 0;
+static ConnInputRegistration *registrations = NULL;
+static ConnInput *inputs = NULL;
+
+void conn_input_init(void) {
+
+    if (registrations != NULL) {
+        return;
+    }
+
+    // fd로 바로 찾는다 (calloc이라 쓰지 않은 fd의 페이지는 실제로 할당되지 않는다)
+    struct rlimit limit;
+    max_fds = (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < CONN_INPUT_MAX_FDS)
+              ? (int)limit.rlim_cur : CONN_INPUT_MAX_FDS;
+    registrations = (ConnInputRegistration *)calloc(max_fds, sizeof(ConnInputRegistration));
+    inputs = (ConnInput *)calloc(max_fds, sizeof(ConnInput));
+    if (registrations == NULL || inputs == NULL) {
+        LOG_ERROR("연결별 수신 버퍼 메모리 할당 실패");
+        exit(EXIT_FAILURE);
+    }
+}
+
+unsigned int conn_input_register(int fd, ConnInputMode mode, const char *data, size_t len) {
+
+    if (registrations == NULL || fd < 0 || fd >= max_fds) {
+        return 0;
+    }
+
+    ConnInputSeed *seed = NULL;
+    if (len > 0) {
+        seed = (ConnInputSeed *)malloc(sizeof(ConnInputSeed) + len);
+        if (seed == NULL) {
+            LOG_ERROR("넘겨받은 수신 조각 메모리 할당 실패: FD %d", fd);
+        } else {
+            seed->len = len;
+            memcpy(seed->data, data, len);
+        }
+    }
+
+    ConnInputRegistration *registration = &registrations[fd];
+    atomic_store_explicit(&registration->mode, mode, memory_order_relaxed);
+    // 메인 스레드가 가져가기 전에 닫힌 이전 연결의 조각
+    free(atomic_exchange_explicit(&registration->seed, seed, memory_order_relaxed));
+    return atomic_fetch_add_explicit(&registration->gen, 1, memory_order_release) + 1;
+}
+
+ConnInput *conn_input_get(int fd) {
+
+    if (inputs == NULL || fd < 0 || fd >= max_fds) {
+        return NULL;
+    }
+
+    // CM이 다시 등록했으면 새 연결
+    ConnInput *input = &inputs[fd];
+    ConnInputRegistration *registration = &registrations[fd];
+    unsigned int gen = atomic_load_explicit(&registration->gen, memory_order_acquire);
+    if (input->gen != gen) {
+        input->gen = gen;
+        input->mode = (ConnInputMode)atomic_load_explicit(&registration->mode, memory_order_relaxed);
+        input->closing = false;
+        conn_input_consume(input, input->len);
+
+        ConnInputSeed *seed = atomic_exchange_explicit(&registration->seed, NULL, memory_order_acquire);
+        if (seed != NULL) {
+            if (!conn_input_append(input, seed->data, seed->len)) {
+                LOG_ERROR("넘겨받은 수신 조각 메모리 할당 실패: FD %d", fd);
+            }
+            free(seed);
+        }
+    }
+    return input;
+}
+
+bool conn_input_append(ConnInput *input, const char *data, size_t len) {
+
+    if (input->len + len > input->cap) {
+        size_t cap = input->cap * 2 > input->len + len ? input->cap * 2 : input->len + len;
+        char *grown = (char *)realloc(input->data, cap);
+        if (grown == NULL) {
+            return false;
+        }
+        input->data = grown;
+        input->cap = cap;
+    }
+    memcpy(input->data + input->len, data, len);
+    input->len += len;
+    return true;
+}
+
+void conn_input_consume(ConnInput *input, size_t len) {
+
+    // 조각이 없는 연결은 버퍼를 들고 있지 않는다 (대부분의 연결은 recv가 frame 경계에서 끝난다)
+    if (len >= input->len) {
+        free(input->data);
+        input->data = NULL;
+        input->len = 0;
+        input->cap = 0;
+        return;
+    }
+    memmove(input->data, input->data + len, input->len - len);
+    input->len -= len;
+}
@@ -0,0 +1,45 @@
+#ifndef CONN_INPUT_H
+#define CONN_INPUT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// 메인 스레드의 연결별 수신 조각
+// recv 한 번에 요청/frame 여러 개가 붙어 오거나 하나가 두 recv에 걸쳐 올 수 있으므로, 메인 스레드는 읽은 바이트를
+// 완성된 HTTP 요청과 WebSocket frame 단위로 나누고, 끝에 남은 조각은 연결별로 들고 있다가 다음 recv 앞에 붙인다.
+// 업그레이드 요청 뒤의 바이트는 WebSocket frame으로 나눈다 (업그레이드가 실패하면 CM이 연결을 닫는다).
+// 연결 상태는 fd로 찾는다 (rate_limit.h와 같은 방식): CM이 등록할 때 세대 번호를 올리면 메인 스레드가 다음 recv에서 새 연결로 초기화한다.
+
+typedef enum {
+    CONN_INPUT_HTTP,            // HTTP 요청 (업그레이드 전)
+    CONN_INPUT_FRAMES,          // WebSocket frame (업그레이드 요청 뒤)
+} ConnInputMode;
+
+// 메인 스레드만 쓰는 연결 상태
+typedef struct {
+    unsigned int gen;
+    ConnInputMode mode;
+    char *data;                 // 아직 나누지 못한 조각 (없으면 NULL)
+    size_t len;
+    size_t cap;
+    bool closing;               // CM에 종료를 알렸다 (더 읽은 바이트는 버린다)
+} ConnInput;
+
+// 메인 스레드가 읽기 전에 (CM 초기화 전에)
+void conn_input_init(void);
+
+// CM: 새 연결 등록 (epoll 등록 전에), 새 세대 번호를 반환 (다룰 수 없는 fd면 0)
+// 넘겨받은 연결은 이전 프로세스의 모드와 나누지 못한 조각을 같이 준다 (복사한다)
+unsigned int conn_input_register(int fd, ConnInputMode mode, const char *data, size_t len);
+
+// 메인 스레드: fd의 상태 (다시 등록됐으면 새 연결로 초기화, 다룰 수 없는 fd면 NULL)
+// 무중단 재시작으로 넘겨줄 때는 메인 스레드가 멈춰 있으므로 CM이 읽는다.
+ConnInput *conn_input_get(int fd);
+
+// 읽은 바이트를 남은 조각 뒤에 붙인다 (메모리가 부족하면 false)
+bool conn_input_append(ConnInput *input, const char *data, size_t len);
+
+// 앞에서 len바이트를 처리했다 (남은 조각은 앞으로 당기고, 다 비면 버퍼를 놓는다)
+void conn_input_consume(ConnInput *input, size_t len);
+
+#endif // CONN_INPUT_H
@@ -1,14 +1,44 @@
 #include "context.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include "log.h"
+#include "stats.h"
+#include "work_pool.h"
+#include "handoff.h"
+#include "rate_limit.h"
+#include "conn_input.h"
 
 void init_context(Context *ctx) {
     ctx->cm = (ClientManager *)malloc(sizeof(ClientManager)); // ClientManager 동적 할당
     ctx->canvas = (Canvas *)malloc(sizeof(Canvas)); // Canvas 동적 할당
 
+    // 무중단 재시작: 이전 프로세스가 있으면 리슨 소켓을 넘겨받는다
+    Handoff *handoff = handoff_connect();
+
+    work_pool_init();
+    rate_limit_init();
+    conn_input_init();
     init_canvas(ctx->canvas, ctx->cm, CANVAS_WIDTH, CANVAS_HEIGHT, TASK_QUEUE_SIZE);
     initClientManager(ctx->cm, ctx->canvas->queue, PORT_NUMBER, EVENTS_SIZE, TASK_QUEUE_SIZE);
+    if (handoff != NULL) {
+        handoff_adopt(handoff, ctx);
+    }
+    handoff_listen(ctx->cm);
+    stats_start(ctx->cm);
+
+    LOG_INFO("Context 초기화 완료");
+
+}
 
-    printf("Context 초기화 완료\n");
+void init_sim_context(Context *ctx) {
+    ctx->cm = (ClientManager *)malloc(sizeof(ClientManager));
+    ctx->canvas = (Canvas *)malloc(sizeof(Canvas));
+
+    work_pool_init();
+    rate_limit_init();
+    conn_input_init();
+    init_canvas(ctx->canvas, ctx->cm, CANVAS_WIDTH, CANVAS_HEIGHT, TASK_QUEUE_SIZE);
+    initClientManager(ctx->cm, ctx->canvas->queue, 0, EVENTS_SIZE, TASK_QUEUE_SIZE);
 
-}
\ No newline at end of file
+    LOG_INFO("시뮬레이션 Context 초기화 완료");
+}
@@ -17,4 +17,7 @@ typedef struct {
 
 void init_context(Context *ctx);
 
+// 리슨 소켓과 통계 샘플러 없이 초기화 (시뮬레이션 벤치: 소켓은 socketpair로 직접 등록)
+void init_sim_context(Context *ctx);
+
 #endif // CONTEXT_H
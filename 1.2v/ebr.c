@@ -0,0 +1,64 @@
+#include "ebr.h"
+#include <stddef.h>
+
+void ebr_init(EbrDomain *domain) {
+
+    atomic_init(&domain->epoch, 1);
+    atomic_init(&domain->reader_count, 0);
+    for (int i = 0; i < EBR_MAX_READERS; i++) {
+        atomic_init(&domain->readers[i].epoch, 0);
+    }
+    domain->limbo_head = NULL;
+    domain->pending = 0;
+}
+
+int ebr_register(EbrDomain *domain) {
+    int reader = atomic_fetch_add(&domain->reader_count, 1);
+    return reader < EBR_MAX_READERS ? reader : -1;
+}
+
+void ebr_retire(EbrDomain *domain, EbrNode *node, void (*reclaim)(EbrNode *node)) {
+
+    // 이 에포크나 그 전에 들어온 스레드만 이전 객체를 보고 있을 수 있다.
+    // 에포크를 올려서 이후에 들어오는 스레드와 구분한다
+    node->epoch = atomic_fetch_add(&domain->epoch, 1);
+    node->reclaim = reclaim;
+    node->next = domain->limbo_head;
+    domain->limbo_head = node;
+    domain->pending++;
+}
+
+unsigned long ebr_reclaim(EbrDomain *domain) {
+
+    if (domain->limbo_head == NULL) {
+        return 0;
+    }
+
+    // 안에 있는 스레드 중 가장 오래된 에포크 (아무도 없으면 모두 회수)
+    unsigned long oldest = atomic_load(&domain->epoch);
+    int readers = atomic_load(&domain->reader_count);
+    for (int i = 0; i < readers && i < EBR_MAX_READERS; i++) {
+        unsigned long epoch = atomic_load(&domain->readers[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    // 목록은 새것부터 쌓이므로 처음으로 회수할 수 있는 객체부터 끝까지 회수한다
+    EbrNode **link = &domain->limbo_head;
+    while (*link != NULL && (*link)->epoch >= oldest) {
+        link = &(*link)->next;
+    }
+    EbrNode *node = *link;
+    *link = NULL;
+
+    unsigned long reclaimed = 0;
+    while (node != NULL) {
+        EbrNode *next = node->next;
+        node->reclaim(node);
+        reclaimed++;
+        node = next;
+    }
+    domain->pending -= reclaimed;
+    return reclaimed;
+}
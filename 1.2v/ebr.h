@@ -0,0 +1,54 @@
+#ifndef EBR_H
+#define EBR_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// 에포크 기반 메모리 회수 (EBR)
+// 읽는 스레드는 공유 포인터를 읽기 전에 들어가고(ebr_enter) 다 쓰면 나온다(ebr_exit). 락은 없다.
+// 쓰는 스레드 하나가 더 이상 새로 읽을 수 없게 된 객체(포인터를 바꿔 단 이전 값)를 넘기면(ebr_retire),
+// 그때 안에 있던 읽는 스레드가 모두 나간 뒤에 회수 함수를 부른다 (ebr_reclaim).
+// 객체는 EbrNode를 품고 있으므로 넘길 때 할당이 없다.
+
+#define EBR_MAX_READERS 64
+
+// 읽는 스레드 하나 (캐시 라인을 나눠 쓰지 않도록 떨어뜨린다)
+typedef struct {
+    _Alignas(64) atomic_ulong epoch;    // 들어올 때 본 전역 에포크 (0: 밖에 있음)
+} EbrReader;
+
+typedef struct EbrNode {
+    struct EbrNode *next;
+    unsigned long epoch;                // 넘길 때의 전역 에포크
+    void (*reclaim)(struct EbrNode *node);
+} EbrNode;
+
+typedef struct {
+    atomic_ulong epoch;                 // 전역 에포크 (1부터)
+    atomic_int reader_count;
+    EbrReader readers[EBR_MAX_READERS];
+    EbrNode *limbo_head;                // 회수를 기다리는 객체 (쓰는 스레드만, 오래된 것이 뒤)
+    unsigned long pending;              // 회수를 기다리는 객체 수
+} EbrDomain;
+
+void ebr_init(EbrDomain *domain);
+
+// 읽는 스레드 등록 (스레드마다 한 번, 자리 번호를 반환, 자리가 없으면 -1)
+int ebr_register(EbrDomain *domain);
+
+static inline void ebr_enter(EbrDomain *domain, int reader) {
+    // 에포크를 먼저 알린 뒤에 공유 포인터를 읽는다 (seq_cst: 포인터 교체와 순서가 정해진다)
+    atomic_store(&domain->readers[reader].epoch, atomic_load(&domain->epoch));
+}
+
+static inline void ebr_exit(EbrDomain *domain, int reader) {
+    atomic_store_explicit(&domain->readers[reader].epoch, 0, memory_order_release);
+}
+
+// 쓰는 스레드: 공유 포인터를 바꾼 뒤 이전 객체를 넘긴다 (reclaim은 나중에 쓰는 스레드에서 불린다)
+void ebr_retire(EbrDomain *domain, EbrNode *node, void (*reclaim)(EbrNode *node));
+
+// 쓰는 스레드: 읽는 스레드가 더 이상 볼 수 없는 객체를 회수하고 회수한 수를 반환
+unsigned long ebr_reclaim(EbrDomain *domain);
+
+#endif // EBR_H
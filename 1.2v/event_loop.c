@@ -0,0 +1,217 @@
+#include "event_loop.h"
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "client_manager.h"
+#include "task_queue.h"
+#include "http_handler.h"
+#include "metrics.h"
+#include "websocket_frame.h"
+#include "trace.h"
+#include "log.h"
+#include "handoff.h"
+#include "rate_limit.h"
+#include "conn_input.h"
+
+// 연결을 닫기로 했다: CM에 알리고 이후 읽는 바이트는 버린다
+// 종료는 버릴 수 없으므로 대량 레인이 차 있으면 기다린다 (CM은 메인 스레드를 기다리지 않는다)
+static void close_input(Context *ctx, int fd, ConnInput *input) {
+    input->closing = true;
+    conn_input_consume(input, input->len);
+    Task task = {fd, TASK_CLIENT_CLOSE, "", 0, 0, input->gen};
+    push_task_wait(ctx->cm->queue, task);
+}
+
+// HTTP 요청 하나를 복사해서 CM에 넘긴다 (응답과 파이프라이닝 순서는 CM이 맡는다)
+static void forward_http(Context *ctx, int fd, ConnInput *input, const char *data, size_t len, TaskType type) {
+    char *request = malloc(len + 1);
+    memcpy(request, data, len);
+    request[len] = '\0';
+    Task task = {fd, type, request, len, 0, input->gen};
+    if (!push_task(ctx->cm->queue, task)) {
+        free(request);
+    }
+}
+
+// 읽은 바이트를 완성된 요청/frame 단위로 처리하고 처리한 길이를 반환 (끝에 걸친 조각은 다음 recv까지 남긴다)
+static size_t split_input(Context *ctx, int fd, ConnInput *input, char *data, size_t len, unsigned long recv_ns) {
+
+    size_t offset = 0;
+    while (offset < len) {
+        char *p = data + offset;
+        size_t available = len - offset;
+
+        if (input->mode == CONN_INPUT_HTTP) {
+            bool upgrade = false;
+            size_t request_len = http_request_length(p, available, &upgrade);
+            if (request_len == 0 || request_len > available) {
+                // 수신 버퍼보다 큰 요청은 기다리지 않고 넘긴다 (CM이 431/413으로 응답하고 닫는다)
+                if (available >= REQUEST_BUFFER_SIZE || request_len >= REQUEST_BUFFER_SIZE) {
+                    forward_http(ctx, fd, input, p, available, TASK_MESSAGE_INCOMPLETE_HTTP);
+                    input->closing = true;
+                    return len;
+                }
+                break;
+            }
+            forward_http(ctx, fd, input, p, request_len, TASK_HTTP_REQUEST);
+            offset += request_len;
+            // 업그레이드 요청 뒤에 붙어 온 바이트부터는 frame
+            if (upgrade) {
+                input->mode = CONN_INPUT_FRAMES;
+            }
+            continue;
+        }
+
+        if (available < 2) {
+            break;
+        }
+        // 클라이언트가 보내는 frame은 항상 마스킹한다, 메세지 버퍼보다 큰 frame은 받을 수 없다
+        size_t frame_len = websocket_frame_length((uint8_t *)p, available);
+        if (((uint8_t)p[1] & 0x80) == 0 || frame_len > WEBSOCKET_MAX_PAYLOAD + WEBSOCKET_MAX_HEADER) {
+            LOG_WARN("잘못된 WebSocket frame (마스킹 없음 또는 %zu바이트), 연결 종료 FD %d", frame_len, fd);
+            close_input(ctx, fd, input);
+            return len;
+        }
+        if (frame_len == 0 || frame_len > available) {
+            break;
+        }
+
+        // 페인트 메세지 속도 제한 (종료, ping, pong 같은 제어 frame 제외): 디마스킹, 파싱, 큐에 넣기 전에 버린다
+        RateVerdict verdict = ((uint8_t)p[0] & 0x08) ? RATE_ALLOW : rate_limit_check(fd, recv_ns);
+        if (verdict == RATE_ALLOW) {
+            unsigned long decode_start = trace_begin();
+            process_websocket_frame(ctx->cm, fd, input->gen, p, frame_len, recv_ns);
+            trace_end("frame_decode", decode_start, frame_len);
+        }
+        else if (verdict == RATE_DISCONNECT) {
+            LOG_WARN("메세지 속도 제한을 계속 넘겨서 연결 종료 FD %d", fd);
+            close_input(ctx, fd, input);
+            return len;
+        }
+        offset += frame_len;
+    }
+    return offset;
+}
+
+// 클라이언트 소켓 하나를 EAGAIN까지 읽어서 작업으로 나눈다
+static void read_client(Context *ctx, int fd) {
+
+    static char buffer[REQUEST_BUFFER_SIZE];    // 메인 스레드만 쓴다 (남길 조각은 연결별 버퍼로 복사)
+    ConnInput *input = conn_input_get(fd);
+
+    // edge triggered 이므로 소켓에 쌓인 데이터를 EAGAIN까지 모두 읽는다
+    // (MSG_DONTWAIT: 시뮬레이션의 socketpair 서버 쪽 끝은 send가 나눠지지 않도록 블로킹으로 둔다)
+    while (1) {
+        ssize_t len = recv(fd, buffer, REQUEST_BUFFER_SIZE, MSG_DONTWAIT);
+
+        if (len == -1 && errno == EINTR) {
+            continue;
+        }
+        if (len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (len <= 0 || input == NULL) {
+            // 클라이언트 접속 종료
+            Task task = {fd, TASK_CLIENT_CLOSE, "", len, 0, input != NULL ? input->gen : 0};
+            push_task_wait(ctx->cm->queue, task);
+            if (input != NULL) {
+                conn_input_consume(input, input->len);
+            }
+            break;
+        }
+        metrics_add(METRIC_BYTES_IN, len);
+
+        // 닫기로 한 연결은 CM이 닫을 때까지 읽어서 버린다
+        if (!input->closing) {
+            unsigned long recv_ns = monotonic_ns();
+            if (input->len == 0) {
+                // 남은 조각이 없으면 recv 버퍼에서 바로 나누고, 끝에 걸친 조각만 연결별 버퍼에 남긴다
+                size_t used = split_input(ctx, fd, input, buffer, len, recv_ns);
+                if (used < (size_t)len && !conn_input_append(input, buffer + used, len - used)) {
+                    LOG_ERROR("수신 조각 메모리 할당 실패, 연결 종료 FD %d", fd);
+                    close_input(ctx, fd, input);
+                }
+            }
+            else if (conn_input_append(input, buffer, len)) {
+                conn_input_consume(input, split_input(ctx, fd, input, input->data, input->len, recv_ns));
+            }
+            else {
+                LOG_ERROR("수신 조각 메모리 할당 실패, 연결 종료 FD %d", fd);
+                close_input(ctx, fd, input);
+            }
+        }
+
+        // 버퍼를 다 채우지 못했다면 더 읽을 데이터가 없다
+        if (len < REQUEST_BUFFER_SIZE) {
+            break;
+        }
+    }
+}
+
+int event_loop_once(Context *ctx, int timeout_ms) {
+
+    unsigned long wait_start = trace_begin();
+    int num_events = epoll_wait(ctx->cm->epoll_fd, ctx->cm->events, EVENTS_SIZE, timeout_ms);
+    trace_end("epoll_wait", wait_start, num_events);
+    if (num_events == -1) {
+        if (errno != EINTR) {
+            LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+        }
+        return 0;
+    }
+    if (num_events == 0) {
+        return 0;
+    }
+
+    metrics_add(METRIC_EPOLL_WAKEUPS, 1);
+    metrics_add(METRIC_EPOLL_EVENTS, num_events);
+    unsigned long dispatch_start = trace_begin();
+
+    for (int i = 0; i < num_events; i++) {
+        int fd = ctx->cm->events[i].data.fd;
+        if (fd == ctx->cm->server_socket) { // 새로운 클라이언트 연결 처리
+            Task task = {0, TASK_NEW_CLIENT, NULL, 0, 0, 0};
+            push_task(ctx->cm->queue, task);
+        }
+        else if (fd == ctx->cm->static_cache->inotify_fd) { // 정적 파일 변경
+            Task task = {0, TASK_STATIC_RELOAD, NULL, 0, 0, 0};
+            push_task(ctx->cm->queue, task);
+        }
+        else if (fd == ctx->cm->handoff_fd) { // 새 프로세스가 넘겨받으러 왔다 (넘겨주면 반환하지 않는다)
+            handoff_serve(ctx);
+        }
+        else if (fd == ctx->cm->timer_fd) { // 1초 주기 타이머
+            uint64_t expirations;
+            while (read(fd, &expirations, sizeof(expirations)) > 0);
+            Task task = {0, TASK_TIMER_TICK, NULL, 0, 0, 0};
+            push_task(ctx->cm->queue, task);
+        }
+        else {
+            // 송신 대기열이 남은 소켓만 EPOLLOUT을 감시한다 (CM이 이어서 보낸다)
+            uint32_t events = ctx->cm->events[i].events;
+            if (events & EPOLLOUT) {
+                Task task = {fd, TASK_CLIENT_WRITABLE, NULL, 0, 0, 0};
+                push_task(ctx->cm->queue, task);
+            }
+            // MSG_ZEROCOPY 완료 알림도 EPOLLERR로 온다 (소켓 오류면 아래 recv가 종료로 처리한다)
+            if (events & EPOLLERR) {
+                Task task = {fd, TASK_ZEROCOPY_COMPLETE, NULL, 0, 0, 0};
+                push_task(ctx->cm->queue, task);
+            }
+            if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                read_client(ctx, fd);
+            }
+        }
+    }
+    trace_end("epoll_dispatch", dispatch_start, num_events);
+    return num_events;
+}
+
+void event_loop_run(Context *ctx) {
+    while (1) {
+        event_loop_once(ctx, -1);
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "context.h"
+
+// 메인 스레드 이벤트 루프
+// 리슨 소켓/타이머/inotify 이벤트는 CM 작업으로 넘기고,
+// 클라이언트 소켓은 EAGAIN까지 읽어서 HTTP 요청/WebSocket frame으로 나눈다.
+// 서버(main.c)와 시뮬레이션 벤치(bench/sim_bench.c)가 같은 루프를 쓴다.
+
+// epoll_wait 한 번과 준비된 fd 처리 (timeout_ms: -1이면 무한 대기), 처리한 이벤트 수 반환
+int event_loop_once(Context *ctx, int timeout_ms);
+
+// 이벤트 루프 (반환하지 않는다)
+void event_loop_run(Context *ctx);
+
+#endif // EVENT_LOOP_H
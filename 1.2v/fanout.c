@@ -0,0 +1,187 @@
+#include "fanout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "outbound.h"
+#include "client_registry.h"
+#include "metrics.h"
+#include "affinity.h"
+#include "trace.h"
+#include "log.h"
+
+// 팬아웃 한 번 (앞 작업이 모두 끝나야 시작한다)
+typedef struct FanoutJob {
+    struct FanoutJob *next;
+    SharedFrame *frame;                 // 모든 송신 스레드가 나눠 쓰는 frame (작업이 참조 하나)
+    const ClientSnapshot *snapshot;     // 시작할 때의 브로드캐스트 대상 (작업이 끝날 때까지 EBR로 붙잡는다)
+    unsigned long seq;
+    unsigned long start_ns;
+    unsigned long recv_ns;
+    atomic_int remaining;               // 아직 자기 구간을 끝내지 않은 스레드 수
+} FanoutJob;
+
+typedef struct {
+    pthread_t tid;
+    int index;
+} FanoutThread;
+
+static ClientManager *cm = NULL;
+static int thread_count = 0;
+static FanoutThread *threads = NULL;
+static int reader = -1;                 // 진행 중인 작업의 스냅샷을 붙잡는 EBR 자리 (작업마다 들어가고 나온다)
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t all_done = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t slot_free = PTHREAD_COND_INITIALIZER;
+static FanoutJob *head = NULL;          // 진행 중인 작업
+static FanoutJob *tail = NULL;
+static int pending = 0;                 // 진행 중인 작업 포함, FANOUT_MAX_PENDING 이하
+static unsigned long next_seq = 0;
+
+// lock을 잡은 상태에서: head 작업 시작 (지금 스냅샷을 EBR 안에서 읽는다)
+// 작업 사이에는 아무것도 붙잡지 않으므로 팬아웃이 틱보다 길어져도 CM이 회수할 수 있다
+static void start_job(FanoutJob *job) {
+    job->snapshot = registry_acquire(&cm->registry, reader);
+    pthread_cond_broadcast(&job_ready);
+}
+
+// 마지막으로 구간을 끝낸 스레드가 작업을 마무리하고 다음 작업을 시작시킨다
+static void finish_job(FanoutJob *job) {
+
+    record_broadcast(job->start_ns, job->frame->len, job->recv_ns);
+
+    pthread_mutex_lock(&lock);
+    registry_release(&cm->registry, reader);
+    head = job->next;
+    pending--;
+    if (head == NULL) {
+        tail = NULL;
+        pthread_cond_broadcast(&all_done);
+    } else {
+        start_job(head);
+    }
+    pthread_cond_signal(&slot_free);
+    pthread_mutex_unlock(&lock);
+
+    shared_frame_release(job->frame);
+    free(job);
+}
+
+static void *sender_thread(void *arg) {
+
+    FanoutThread *self = (FanoutThread *)arg;
+    affinity_apply("sender", self->index);
+    char name[16];
+    snprintf(name, sizeof(name), "sender %d", self->index);
+    trace_set_thread_name(name);
+
+    unsigned long done_seq = 0;
+    while (1) {
+        pthread_mutex_lock(&lock);
+        while (head == NULL || head->seq <= done_seq) {
+            pthread_cond_wait(&job_ready, &lock);
+        }
+        FanoutJob *job = head;
+        pthread_mutex_unlock(&lock);
+
+        // 내 구간 (스냅샷 순서는 접속/종료에 따라 바뀌므로 구간은 작업마다 다시 나눈다)
+        const ClientSnapshot *snapshot = job->snapshot;
+        size_t begin = snapshot->count * self->index / thread_count;
+        size_t end = snapshot->count * (self->index + 1) / thread_count;
+        for (size_t i = begin; i < end; i++) {
+            unsigned long trace_start_ns = trace_begin();
+            fanout_send_to_client(cm, snapshot->clients[i], job->frame);
+            trace_end("send", trace_start_ns, snapshot->clients[i]->socket_fd);
+        }
+
+        done_seq = job->seq;
+        if (atomic_fetch_sub(&job->remaining, 1) == 1) {
+            finish_job(job);
+        }
+    }
+    return NULL;
+}
+
+void fanout_init(ClientManager *manager) {
+
+    const char *value = getenv("FAINTER_FANOUT_THREADS");
+    int count = value != NULL ? atoi(value) : 0;
+    if (count <= 0) {
+        return;
+    }
+    if (count > FANOUT_MAX_THREADS) {
+        count = FANOUT_MAX_THREADS;
+    }
+
+    cm = manager;
+    reader = registry_register_reader(&manager->registry);
+    threads = (FanoutThread *)calloc(count, sizeof(FanoutThread));
+    if (reader == -1 || threads == NULL) {
+        LOG_ERROR("[CM] 송신 스레드 준비 실패, CM이 직접 보낸다");
+        return;
+    }
+    thread_count = count;
+    for (int i = 0; i < count; i++) {
+        threads[i].index = i;
+        int n = pthread_create(&threads[i].tid, NULL, sender_thread, &threads[i]);
+        if (n != 0) {
+            LOG_ERROR("[CM] 송신 스레드 생성 실패: %s", strerror(n));
+            exit(EXIT_FAILURE);
+        }
+    }
+    LOG_INFO("[CM] 브로드캐스트 송신 스레드 %d개", count);
+}
+
+int fanout_threads(void) {
+    return thread_count;
+}
+
+void fanout_submit(char *message, size_t message_len, unsigned long start_ns, unsigned long recv_ns) {
+
+    FanoutJob *job = (FanoutJob *)malloc(sizeof(FanoutJob));
+    SharedFrame *frame = shared_frame_create((uint8_t *)message, message_len, 1);
+    if (job == NULL || frame == NULL) {
+        LOG_ERROR("[CM] 브로드캐스트 작업 할당 실패, 이번 틱은 보내지 않음");
+        free(job);
+        free(frame);
+        return;
+    }
+    job->next = NULL;
+    job->frame = frame;
+    job->start_ns = start_ns;
+    job->recv_ns = recv_ns;
+    atomic_init(&job->remaining, thread_count);
+
+    job->snapshot = NULL;
+
+    // 지난 틱 이후 접속/종료가 있었으면 새 스냅샷
+    registry_publish(&cm->registry);
+
+    pthread_mutex_lock(&lock);
+    // 송신 스레드가 틱을 따라가지 못하면 CM이 기다린다 (CM이 직접 보낼 때와 같은 역압, 변경분은 버릴 수 없다)
+    while (pending >= FANOUT_MAX_PENDING) {
+        pthread_cond_wait(&slot_free, &lock);
+    }
+    job->seq = ++next_seq;
+    pending++;
+    if (head == NULL) {
+        head = job;
+        start_job(job);
+    } else {
+        tail->next = job;
+    }
+    tail = job;
+    pthread_mutex_unlock(&lock);
+}
+
+void fanout_wait_idle(void) {
+
+    pthread_mutex_lock(&lock);
+    while (head != NULL) {
+        pthread_cond_wait(&all_done, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,33 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "client_manager.h"
+
+// 브로드캐스트 송신 스레드
+// 틱마다 frame 하나를 모든 WebSocket 연결에 보내는 일을 여러 스레드가 나눠 한다.
+// CM은 frame을 작업으로 넘기고 바로 다음 작업으로 간다. 작업이 시작될 때 브로드캐스트 대상 스냅샷(client_registry.h)을
+// 읽고, 끝나면 놓는다 (작업 사이에는 종료된 클라이언트와 이전 스냅샷을 회수할 수 있다).
+// 송신 스레드 i는 스냅샷의 i번째 구간을 맡고, 모두 같은 SharedFrame을 보낸다 (느린 클라이언트 대기열도 복사 없이 공유).
+// 작업은 순서대로 하나씩 진행한다 (모든 스레드가 앞 작업을 끝내야 다음 작업): 스냅샷이 바뀌어 클라이언트가
+// 다른 구간으로 옮겨도 같은 클라이언트에게 틱 순서가 뒤바뀌지 않는다.
+// 클라이언트 송신 상태는 Client.send_lock으로 CM(스냅샷, ping, EPOLLOUT)과 나눠 쓴다.
+
+#define FANOUT_MAX_THREADS 64        // FAINTER_FANOUT_THREADS (기본 0: CM이 직접 보낸다)
+#define FANOUT_MAX_PENDING 2         // 진행 중인 작업을 포함해서 밀려 있을 수 있는 작업 수 (넘으면 CM이 기다린다)
+
+// 송신 스레드 시작 (FAINTER_FANOUT_THREADS가 없거나 0이면 시작하지 않는다)
+void fanout_init(ClientManager *manager);
+
+// 송신 스레드 수 (0이면 CM이 직접 보낸다)
+int fanout_threads(void);
+
+// CM: 이번 틱 frame 팬아웃을 넘긴다 (message는 복사한다, 시각은 metrics 용)
+// FANOUT_MAX_PENDING개가 밀려 있으면 하나가 끝날 때까지 기다린다
+void fanout_submit(char *message, size_t message_len, unsigned long start_ns, unsigned long recv_ns);
+
+// CM: 넘긴 팬아웃이 모두 끝날 때까지 기다린다 (무중단 재시작 전에 송신 대기열을 넘기기 위해)
+void fanout_wait_idle(void);
+
+#endif // FANOUT_H
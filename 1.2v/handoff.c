@@ -0,0 +1,422 @@
+#define _GNU_SOURCE
+#include "handoff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <time.h>
+#include "client_manager.h"
+#include "canvas.h"
+#include "save_canvas.h"
+#include "task_queue.h"
+#include "trace.h"
+#include "log.h"
+#include "conn_input.h"
+
+#define HANDOFF_TIMEOUT_SEC 10        // 이전 프로세스가 새 프로세스를 기다리는 최대 시간 (넘으면 계속 서비스)
+                                      // main이 CM/캔버스가 보낼 준비를 마치기를 기다리는 시간도 같다
+
+static int inherited_listen_fd = -1;
+
+// 끝난 넘겨주기 작업 정리 (실패하거나 main이 포기한 뒤, 마지막으로 받은 스레드가)
+static void release_job(HandoffJob *job) {
+    close(job->conn);
+    free(job->dirty);
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->cond);
+    free(job);
+}
+
+// 모두 보낼 때까지 반복 (fd가 있으면 첫 조각에 붙인다)
+static int send_all(int conn, const void *data, size_t len, int fd) {
+
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        struct iovec iov = {(void *)p, len};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        union {
+            char buf[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        if (fd != -1) {
+            memset(&control, 0, sizeof(control));
+            msg.msg_control = control.buf;
+            msg.msg_controllen = sizeof(control.buf);
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        }
+
+        ssize_t n = sendmsg(conn, &msg, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+        fd = -1;
+    }
+    return 0;
+}
+
+// len 바이트를 모두 받을 때까지 반복 (붙어 온 fd는 *fd에, fd가 NULL이면 닫는다)
+// 보내는 쪽이 fd를 메세지 첫 조각에 붙이고 받는 쪽이 메세지 경계까지만 읽으므로 fd가 다른 메세지에 섞이지 않는다
+static int recv_all(int conn, void *data, size_t len, int *fd) {
+
+    uint8_t *p = (uint8_t *)data;
+    if (fd != NULL) {
+        *fd = -1;
+    }
+    while (len > 0) {
+        struct iovec iov = {p, len};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        union {
+            char buf[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        ssize_t n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                int received;
+                memcpy(&received, CMSG_DATA(cmsg), sizeof(int));
+                if (fd != NULL && *fd == -1) {
+                    *fd = received;
+                } else {
+                    close(received);
+                }
+            }
+        }
+        if (msg.msg_flags & MSG_CTRUNC) {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+Handoff *handoff_connect(void) {
+
+    const char *path = getenv("FAINTER_HANDOFF");
+    if (path == NULL) {
+        return NULL;
+    }
+
+    int conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (conn == -1 || connect(conn, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        LOG_INFO("넘겨줄 이전 프로세스 없음 (%s), 새로 시작", path);
+        if (conn != -1) {
+            close(conn);
+        }
+        return NULL;
+    }
+
+    // 버전이 맞는지 이전 프로세스가 먼저 확인한다
+    LOG_INFO("이전 프로세스에 접속: %s, 넘겨받기 대기", path);
+    uint32_t version = HANDOFF_VERSION;
+    Handoff *handoff = (Handoff *)malloc(sizeof(Handoff));
+    int listen_fd = -1;
+    if (handoff == NULL || send_all(conn, &version, sizeof(version), -1) == -1 ||
+        recv_all(conn, &handoff->header, sizeof(handoff->header), &listen_fd) == -1 ||
+        handoff->header.magic != HANDOFF_MAGIC || handoff->header.version != HANDOFF_VERSION || listen_fd == -1) {
+        LOG_ERROR("넘겨받기 실패: 이전 프로세스가 거절했거나 응답이 잘못됨");
+        exit(EXIT_FAILURE);
+    }
+
+    handoff->conn = conn;
+    inherited_listen_fd = listen_fd;
+    return handoff;
+}
+
+int handoff_take_listen_socket(void) {
+    int fd = inherited_listen_fd;
+    inherited_listen_fd = -1;
+    return fd;
+}
+
+void handoff_adopt(Handoff *handoff, Context *ctx) {
+
+    HandoffHeader *header = &handoff->header;
+    Canvas *canvas = ctx->canvas;
+
+    // 이벤트 루프 전이라 캔버스 스레드는 작업을 기다리는 중 (적재 후 넣는 작업이 순서를 보장한다)
+    bool restored = header->width == canvas->canvas_width && header->height == canvas->canvas_height &&
+                    load_canvas_from_json(canvas, SAVE_CANVAS_PATH) == 0;
+
+    uint32_t *dirty = (uint32_t *)malloc(sizeof(uint32_t) * (header->dirty_count + 1));
+    if (dirty == NULL || recv_all(handoff->conn, dirty, sizeof(uint32_t) * header->dirty_count, NULL) == -1) {
+        LOG_ERROR("넘겨받기 실패: 픽셀 목록");
+        exit(EXIT_FAILURE);
+    }
+    if (restored) {
+        Task task = {0, TASK_RESTORE_DIRTY, dirty, header->dirty_count, 0, 0};
+        push_task_wait(canvas->queue, task);
+    } else {
+        LOG_WARN("이전 캔버스를 적재하지 못함: 넘겨받은 클라이언트는 모두 스냅샷을 다시 받는다");
+        free(dirty);
+    }
+
+    for (uint32_t i = 0; i < header->client_count; i++) {
+        HandoffClient record;
+        int fd = -1;
+        if (recv_all(handoff->conn, &record, sizeof(record), &fd) == -1 || fd == -1 ||
+            record.recv_len > REQUEST_BUFFER_SIZE || record.input_len > REQUEST_BUFFER_SIZE * 2) {
+            LOG_ERROR("넘겨받기 실패: 클라이언트 %u", i);
+            exit(EXIT_FAILURE);
+        }
+        size_t data_len = (size_t)record.recv_len + record.input_len + record.pending_len;
+        HandoffClient *adopted = (HandoffClient *)malloc(sizeof(HandoffClient) + data_len);
+        if (adopted == NULL || recv_all(handoff->conn, adopted->data, data_len, NULL) == -1) {
+            LOG_ERROR("넘겨받기 실패: 클라이언트 %u 상태", i);
+            exit(EXIT_FAILURE);
+        }
+        memcpy(adopted, &record, sizeof(record));
+        if (!restored) {
+            adopted->resync = 1;
+        }
+        Task task = {fd, TASK_ADOPT_CLIENT, adopted, 0, 0, 0};
+        push_task_wait(ctx->cm->queue, task);
+    }
+
+    // 다 받았다고 알려야 이전 프로세스가 종료한다 (그 전에 끊기면 이전 프로세스가 계속 서비스한다)
+    uint8_t ack = 1;
+    if (send_all(handoff->conn, &ack, sizeof(ack), -1) == -1) {
+        LOG_ERROR("넘겨받기 실패: 이전 프로세스가 먼저 끊음");
+        exit(EXIT_FAILURE);
+    }
+    LOG_INFO("넘겨받기 완료: 클라이언트 %u개, 브로드캐스트 전 픽셀 %u개", header->client_count, header->dirty_count);
+
+    close(handoff->conn);
+    free(handoff);
+}
+
+void handoff_listen(ClientManager *cm) {
+
+    cm->handoff_fd = -1;
+    const char *path = getenv("FAINTER_HANDOFF");
+    if (path == NULL) {
+        return;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    // 남아 있는 경로는 이미 넘겨준 이전 프로세스나 비정상 종료한 프로세스의 것
+    unlink(path);
+    if (fd == -1 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, 1) == -1) {
+        LOG_ERROR("무중단 재시작 소켓 생성 실패: %s (%s)", path, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = fd;
+    if (epoll_ctl(cm->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        LOG_ERROR("무중단 재시작 소켓 epoll 등록 실패: %s", strerror(errno));
+        close(fd);
+        return;
+    }
+    cm->handoff_fd = fd;
+    LOG_INFO("무중단 재시작 대기: %s", path);
+}
+
+void handoff_serve(Context *ctx) {
+
+    while (1) {
+        int conn = accept4(ctx->cm->handoff_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (conn == -1) {
+            return;
+        }
+
+        // 새 프로세스가 멈추면 무한정 서비스를 멈추지 않도록
+        struct timeval timeout = {HANDOFF_TIMEOUT_SEC, 0};
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        uint32_t version = 0;
+        if (recv_all(conn, &version, sizeof(version), NULL) == -1 || version != HANDOFF_VERSION) {
+            LOG_WARN("무중단 재시작 거절: 새 프로세스 버전 %u, 이 프로세스 %u", version, HANDOFF_VERSION);
+            close(conn);
+            continue;
+        }
+
+        LOG_INFO("무중단 재시작: 새 프로세스에 넘겨주는 중");
+        HandoffJob *job = (HandoffJob *)calloc(1, sizeof(HandoffJob));
+        if (job == NULL) {
+            LOG_ERROR("무중단 재시작 메모리 할당 실패");
+            close(conn);
+            continue;
+        }
+        job->conn = conn;
+        job->stage = HANDOFF_STAGE_DRAIN;
+        pthread_mutex_init(&job->lock, NULL);
+        pthread_condattr_t cond_attr;
+        pthread_condattr_init(&cond_attr);
+        pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&job->cond, &cond_attr);
+        pthread_condattr_destroy(&cond_attr);
+
+        // 이 스레드가 더 읽지 않으므로 대량 레인에서 이 작업 앞에 있는 메세지가 마지막이다
+        Task task = {0, TASK_HANDOFF, job, 0, 0, 0};
+        push_task_wait(ctx->cm->queue, task);
+
+        // 넘겨주면 CM이 프로세스를 끝낸다. 여기서는 실패만 기다린다
+        // CM이 보내기 시작하기 전에 시간이 지나면 포기하고 계속 서비스한다 (작업은 다음에 받은 스레드가 버린다)
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += HANDOFF_TIMEOUT_SEC;
+        pthread_mutex_lock(&job->lock);
+        while (!job->failed) {
+            if (pthread_cond_timedwait(&job->cond, &job->lock, &deadline) == ETIMEDOUT && !job->sending) {
+                job->abandoned = true;
+                break;
+            }
+        }
+        bool abandoned = job->abandoned;
+        pthread_mutex_unlock(&job->lock);
+
+        if (abandoned) {
+            LOG_WARN("무중단 재시작 시간 초과: 넘겨줄 준비가 끝나지 않아 계속 서비스");
+            continue;
+        }
+        LOG_WARN("무중단 재시작 실패, 계속 서비스");
+        release_job(job);
+    }
+}
+
+void handoff_drain(ClientManager *cm, HandoffJob *job) {
+
+    cm->handoff_retry = NULL;
+    pthread_mutex_lock(&job->lock);
+    bool abandoned = job->abandoned;
+    pthread_mutex_unlock(&job->lock);
+    if (abandoned) {
+        release_job(job);
+        return;
+    }
+
+    // 캔버스가 CM 큐를 기다리는 중일 수 있으므로 기다리지 않는다 (앞선 픽셀 메세지는 이미 캔버스 큐에 있다)
+    Task task = {0, TASK_HANDOFF, job, 0, 0, 0};
+    if (!push_task(cm->canvas_queue, task)) {
+        cm->handoff_retry = job;
+    }
+}
+
+bool handoff_claim(HandoffJob *job) {
+
+    pthread_mutex_lock(&job->lock);
+    bool abandoned = job->abandoned;
+    job->sending = !abandoned;
+    pthread_mutex_unlock(&job->lock);
+    if (abandoned) {
+        release_job(job);
+    }
+    return !abandoned;
+}
+
+// 넘길 클라이언트: 웹소켓 연결과 응답 중이 아닌 HTTP 연결 (나머지는 이 프로세스가 끝날 때 닫힌다)
+// 업그레이드를 기다리며 모아둔 frame이 있는 연결도 넘기지 않는다 (이미 나눠 읽은 frame이라 다시 보낼 수 없다)
+static bool can_hand_off(Client *client) {
+    return client->state == CONNECTION_OPEN ||
+           (client->state == CONNECTION_HANDSHAKE && !client->http_busy && client->held_count == 0);
+}
+
+void handoff_send(ClientManager *cm, HandoffJob *job) {
+
+    unsigned long trace_start_ns = trace_begin();
+    HandoffHeader header = {HANDOFF_MAGIC, HANDOFF_VERSION, job->width, job->height, job->dirty_count, 0};
+    for (Client *client = cm->head; client != NULL; client = client->next) {
+        header.client_count += can_hand_off(client);
+    }
+
+    if (send_all(job->conn, &header, sizeof(header), cm->server_socket) == -1 ||
+        send_all(job->conn, job->dirty, sizeof(uint32_t) * job->dirty_count, -1) == -1) {
+        goto fail;
+    }
+
+    for (Client *client = cm->head; client != NULL; client = client->next) {
+        if (!can_hand_off(client)) {
+            continue;
+        }
+        HandoffClient record;
+        memset(&record, 0, sizeof(record));
+        record.state = client->state;
+        record.recv_len = client->recv_buffer_len;
+        record.pending_len = client->outbound.bytes;
+        record.incomplete_frame = client->incomplete_frame;
+        record.resync = client->resync_pending;
+        // 메인 스레드는 handoff_serve에서 멈춰 있으므로 수신 조각을 읽어도 된다
+        ConnInput *input = conn_input_get(client->socket_fd);
+        if (input != NULL && !input->closing) {
+            record.input_len = input->len;
+            record.input_frames = input->mode == CONN_INPUT_FRAMES;
+        }
+        if (send_all(job->conn, &record, sizeof(record), client->socket_fd) == -1 ||
+            send_all(job->conn, client->recv_buffer, client->recv_buffer_len, -1) == -1 ||
+            send_all(job->conn, record.input_len > 0 ? input->data : NULL, record.input_len, -1) == -1) {
+            goto fail;
+        }
+
+        // 보내던 frame의 나머지부터 대기열 전체 (클라이언트는 frame 중간에서 이어 받는다)
+        size_t offset = client->outbound.offset;
+        for (OutboundFrame *frame = client->outbound.head; frame != NULL; frame = frame->next) {
+            if (send_all(job->conn, frame->frame->data + offset, frame->frame->len - offset, -1) == -1) {
+                goto fail;
+            }
+            offset = 0;
+        }
+    }
+
+    uint8_t ack = 0;
+    if (recv_all(job->conn, &ack, sizeof(ack), NULL) == -1 || ack != 1) {
+        goto fail;
+    }
+
+    trace_end("handoff_send", trace_start_ns, header.client_count);
+    LOG_INFO("무중단 재시작: 클라이언트 %u개를 넘겨주고 종료", header.client_count);
+    log_flush();
+    exit(EXIT_SUCCESS);
+
+fail:
+    LOG_ERROR("무중단 재시작: 새 프로세스로 보내기 실패: %s", strerror(errno));
+    pthread_mutex_lock(&job->lock);
+    job->failed = true;
+    pthread_cond_signal(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
@@ -0,0 +1,97 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "context.h"
+
+// 무중단 재시작
+// FAINTER_HANDOFF=<유닉스 소켓 경로> 로 띄운 서버는 그 경로에서 다음 프로세스를 기다린다.
+// 같은 설정으로 새 빌드를 띄우면 새 프로세스가 그 경로에 접속하고, 이전 프로세스는
+//  1. main: 소켓 읽기를 멈추고 TASK_HANDOFF를 CM에 넣는다 (대량 레인: 이미 읽은 메세지 뒤)
+//  2. CM -> 캔버스: 앞선 픽셀 메세지를 모두 반영하고 진행 중인 스냅샷이 끝나면 캔버스를 저장하고,
+//     아직 브로드캐스트하지 않은 픽셀을 모은다
+//  3. 캔버스 -> CM: 앞선 브로드캐스트를 다 보낸 뒤 리슨 소켓과 클라이언트 소켓(SCM_RIGHTS),
+//     프로토콜 상태(수신 버퍼, 메인 스레드가 나누지 못한 조각, 보내지 못한 송신 대기열)를 넘기고 종료한다
+// 새 프로세스는 저장된 캔버스를 적재하고 받은 클라이언트를 그대로 등록한 뒤 이벤트 루프를 시작한다.
+// 클라이언트는 연결이 유지되므로 다시 접속하거나 스냅샷을 받지 않는다.
+// 기다리는 이전 프로세스가 없으면 평소처럼 시작한다.
+
+#define HANDOFF_MAGIC 0x464e4448      // "HDNF"
+#define HANDOFF_VERSION 2             // 아래 메세지 구조가 바뀌면 올린다 (버전이 다르면 넘겨받지 않는다)
+
+// 넘겨주기 첫 메세지 (리슨 소켓이 붙어 온다), 브로드캐스트 전 픽셀 인덱스(uint32_t)와 클라이언트가 뒤따른다
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t width;                    // 캔버스 크기 (다르면 저장된 캔버스 대신 모두 스냅샷을 다시 받는다)
+    int32_t height;
+    uint32_t dirty_count;
+    uint32_t client_count;
+} HandoffHeader;
+
+// 클라이언트 하나 (소켓이 붙어 오고, 수신 버퍼와 송신 대기열 내용이 차례로 뒤따른다)
+typedef struct HandoffClient {
+    int32_t state;                    // ConnectionState
+    uint32_t recv_len;
+    uint32_t pending_len;
+    uint32_t input_len;               // 메인 스레드가 아직 나누지 못한 조각 (요청/frame 중간에서 끊긴 바이트)
+    uint8_t incomplete_frame;
+    uint8_t resync;                   // 변경분을 버린 느린 클라이언트: 새 스냅샷이 필요하다
+    uint8_t input_frames;             // 메인 스레드가 WebSocket frame으로 나누는 중 (업그레이드 요청 뒤)
+    uint8_t reserved[1];
+    uint8_t data[];                   // 새 프로세스 안에서만: 수신 버퍼 + 나누지 못한 조각 + 송신 대기열 (TASK_ADOPT_CLIENT)
+} HandoffClient;
+
+typedef enum {
+    HANDOFF_STAGE_DRAIN,              // CM: main이 읽은 메세지를 다 처리했다, 캔버스로
+    HANDOFF_STAGE_SEND,               // 캔버스가 저장했다, CM이 새 프로세스로 보내고 종료
+} HandoffStage;
+
+// 이전 프로세스의 스레드 사이를 오가는 넘겨주기 작업 (TASK_HANDOFF)
+typedef struct HandoffJob {
+    int conn;                         // 새 프로세스와 연결된 소켓
+    HandoffStage stage;
+    uint32_t *dirty;                  // 캔버스가 채운다
+    uint32_t dirty_count;
+    int32_t width;
+    int32_t height;
+    bool failed;                      // 보내기 실패: main이 이벤트 루프로 돌아간다
+    bool sending;                     // CM이 새 프로세스로 보내기 시작했다 (main은 결과를 기다린다)
+    bool abandoned;                   // 보내기 전에 main이 기다리다 포기했다: 다음에 받은 스레드가 버린다
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} HandoffJob;
+
+// 새 프로세스가 받은 넘겨주기 (헤더까지 읽은 상태)
+typedef struct {
+    int conn;
+    HandoffHeader header;
+} Handoff;
+
+// 새 프로세스: 기다리는 이전 프로세스에 접속해서 리슨 소켓을 받는다 (없으면 NULL, 평소처럼 시작)
+Handoff *handoff_connect(void);
+
+// 넘겨받은 리슨 소켓 (없으면 -1), 한 번만 돌려준다
+int handoff_take_listen_socket(void);
+
+// 새 프로세스: 캔버스 적재와 클라이언트 등록을 작업으로 넣고 연결을 닫는다 (이벤트 루프 전에, 실패하면 종료)
+void handoff_adopt(Handoff *handoff, Context *ctx);
+
+// CM: main이 읽은 메세지를 다 처리했다, 캔버스로 넘긴다 (캔버스 큐는 기다리지 않는다: 가득 차면 타이머 틱에 다시)
+void handoff_drain(ClientManager *cm, HandoffJob *job);
+
+// CM: 캔버스가 저장을 마친 작업을 보내기 시작한다 (main이 이미 포기했으면 버리고 false)
+bool handoff_claim(HandoffJob *job);
+
+// 다음 프로세스를 기다리는 유닉스 소켓을 만들어 epoll에 등록 (FAINTER_HANDOFF가 없으면 cm->handoff_fd = -1)
+void handoff_listen(ClientManager *cm);
+
+// main: 다음 프로세스가 접속했다 (넘겨주면 프로세스가 끝나고, 실패하면 반환해서 계속 서비스한다)
+void handoff_serve(Context *ctx);
+
+// CM: 리슨 소켓과 클라이언트를 보낸다 (성공하면 반환하지 않는다)
+void handoff_send(ClientManager *cm, HandoffJob *job);
+
+#endif // HANDOFF_H
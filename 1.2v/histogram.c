@@ -0,0 +1,108 @@
+#include "histogram.h"
+
+// 값 -> 버킷 번호
+static int bucket_index(unsigned long value) {
+
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+
+    int magnitude = 63 - __builtin_clzl(value);                 // 최상위 비트 위치
+    int shift = magnitude - HISTOGRAM_SUB_BITS;
+    int index = (shift + 1) * HISTOGRAM_SUB_BUCKETS + (int)((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+    return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+// 버킷 번호 -> 버킷에 들어가는 가장 큰 값
+static unsigned long bucket_upper_bound(int index) {
+
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return (unsigned long)index;
+    }
+
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long sub = (unsigned long)(index % HISTOGRAM_SUB_BUCKETS) + HISTOGRAM_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void histogram_init(Histogram *histogram) {
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        atomic_init(&histogram->counts[i], 0);
+    }
+    atomic_init(&histogram->total, 0);
+    atomic_init(&histogram->sum, 0);
+    atomic_init(&histogram->max, 0);
+}
+
+void histogram_record(Histogram *histogram, unsigned long value) {
+
+    atomic_fetch_add_explicit(&histogram->counts[bucket_index(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total, 1, memory_order_relaxed);
+
+    unsigned long max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (value > max &&
+           !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void histogram_record_owned(Histogram *histogram, unsigned long value) {
+
+    atomic_ulong *count = &histogram->counts[bucket_index(value)];
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&histogram->sum, atomic_load_explicit(&histogram->sum, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+    atomic_store_explicit(&histogram->total, atomic_load_explicit(&histogram->total, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    if (value > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+    }
+}
+
+void histogram_merge(Histogram *dst, Histogram *src) {
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        unsigned long count = atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+        if (count != 0) {
+            atomic_fetch_add_explicit(&dst->counts[i], count, memory_order_relaxed);
+        }
+    }
+    atomic_fetch_add_explicit(&dst->sum, atomic_load_explicit(&src->sum, memory_order_relaxed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&dst->total, atomic_load_explicit(&src->total, memory_order_relaxed), memory_order_relaxed);
+
+    unsigned long value = atomic_load_explicit(&src->max, memory_order_relaxed);
+    unsigned long max = atomic_load_explicit(&dst->max, memory_order_relaxed);
+    while (value > max &&
+           !atomic_compare_exchange_weak_explicit(&dst->max, &max, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+unsigned long histogram_percentile(Histogram *histogram, double quantile) {
+
+    unsigned long total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // quantile 위치에 해당하는 값이 들어 있는 버킷 찾기
+    unsigned long rank = (unsigned long)(quantile * total);
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    unsigned long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+        if (seen > rank) {
+            unsigned long upper = bucket_upper_bound(i);
+            unsigned long max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+            return upper < max ? upper : max;
+        }
+    }
+    return atomic_load_explicit(&histogram->max, memory_order_relaxed);
+}
@@ -0,0 +1,34 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdatomic.h>
+
+// HDR 방식의 로그 버킷 히스토그램
+// 2의 거듭제곱 구간마다 HISTOGRAM_SUB_BUCKETS개로 나눠서 상대 오차가 약 6% 이내
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAGNITUDES 44         // 2^44 ns (약 4.9시간) 이상은 마지막 버킷에 기록
+#define HISTOGRAM_BUCKETS (HISTOGRAM_MAGNITUDES * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    atomic_ulong counts[HISTOGRAM_BUCKETS];
+    atomic_ulong total;         // 기록된 값 개수
+    atomic_ulong sum;           // 기록된 값 합계
+    atomic_ulong max;           // 최대값
+} Histogram;
+
+void histogram_init(Histogram *histogram);
+
+// 값 하나 기록 (락 없음, 여러 스레드에서 호출 가능)
+void histogram_record(Histogram *histogram, unsigned long value);
+
+// 한 스레드만 기록하는 히스토그램에 값 하나 기록 (원자적 덧셈 없음, 읽기는 다른 스레드에서 해도 된다)
+void histogram_record_owned(Histogram *histogram, unsigned long value);
+
+// src의 기록을 dst에 더한다 (스레드별 히스토그램 합산용)
+void histogram_merge(Histogram *dst, Histogram *src);
+
+// 백분위 값 (0.0 ~ 1.0), 해당 버킷의 상한을 반환
+unsigned long histogram_percentile(Histogram *histogram, double quantile);
+
+#endif // HISTOGRAM_H
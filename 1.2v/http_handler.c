@@ -1,223 +1,642 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include "http_handler.h"
 #include "http_parser.h"
 #include "websocket_handshake.h"
+#include "static_cache.h"
+#include "metrics.h"
+#include "trace.h"
+#include "stats.h"
 #include <pthread.h>
 #include "client_manager.h"
+#include "work_pool.h"
+
+// 논블로킹 소켓에 버퍼를 끝까지 전송 (송신 버퍼가 가득 차면 잠시 기다린다)
+static int send_all(int client_fd, const char *buf, size_t len) {
+
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(client_fd, buf + sent, len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            metrics_add(METRIC_BYTES_OUT, n);
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {client_fd, POLLOUT, 0};
+            if (poll(&pfd, 1, HTTP_SEND_TIMEOUT_MS) > 0) {
+                continue;
+            }
+        }
+        return -1;
+    }
+    return 0;
+}
 
-// MIME 타입 결정 함수
-const char *get_mime_type(const char *path) {
-    const char *ext = strrchr(path, '.');
-    if (!ext) return "text/plain";
+// 파일 본문을 sendfile로 끝까지 전송
+static int sendfile_all(int client_fd, int file_fd, size_t len) {
 
-    if (strcmp(ext, ".html") == 0) return "text/html";
-    if (strcmp(ext, ".css") == 0) return "text/css";
-    if (strcmp(ext, ".js") == 0) return "application/javascript";
-    if (strcmp(ext, ".png") == 0) return "image/png";
-    if (strcmp(ext, ".jpg") == 0) return "image/jpeg";
-    // 필요에 따라 추가 MIME 타입을 정의
+    off_t offset = 0;
+    while ((size_t)offset < len) {
+        ssize_t n = sendfile(client_fd, file_fd, &offset, len - offset);
+        if (n > 0) {
+            metrics_add(METRIC_BYTES_OUT, n);
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {client_fd, POLLOUT, 0};
+            if (poll(&pfd, 1, HTTP_SEND_TIMEOUT_MS) > 0) {
+                continue;
+            }
+        }
+        return -1;
+    }
+    return 0;
+}
+
+// 헤더와 본문을 writev 한 번으로 끝까지 전송
+static int writev_all(int client_fd, const char *header, size_t header_len, const char *body, size_t body_len) {
+
+    struct iovec iov[2] = {
+        {(void *)header, header_len},
+        {(void *)body, body_len}
+    };
+    int iov_index = 0;
+    int iov_count = (body && body_len > 0) ? 2 : 1;
+
+    while (iov_index < iov_count) {
+        ssize_t n = writev(client_fd, iov + iov_index, iov_count - iov_index);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = {client_fd, POLLOUT, 0};
+                if (poll(&pfd, 1, HTTP_SEND_TIMEOUT_MS) > 0) {
+                    continue;
+                }
+            }
+            return -1;
+        }
+        metrics_add(METRIC_BYTES_OUT, n);
 
-    return "application/octet-stream";
+        // 보낸 만큼 iovec 앞으로 이동
+        while (iov_index < iov_count && (size_t)n >= iov[iov_index].iov_len) {
+            n -= iov[iov_index].iov_len;
+            iov_index++;
+        }
+        if (iov_index < iov_count) {
+            iov[iov_index].iov_base = (char *)iov[iov_index].iov_base + n;
+            iov[iov_index].iov_len -= n;
+        }
+    }
+    return 0;
 }
 
 // HTTP 응답 전송 함수
-void send_http_response(int client_fd, const char *status, const char *headers, const char *body, int body_length) {
-    char response[1024 * 1024];
+void send_http_response(int client_fd, const char *status, const char *headers, const char *body, int body_length, HttpConnectionMode mode) {
+    char response[512];
     int length = snprintf(response, sizeof(response),
                           "HTTP/1.1 %s\r\n"
                           "%s"
+                          "Content-Length: %d\r\n"
+                          "%s"
                           "\r\n",
-                          status, headers);
+                          status, headers, body ? body_length : 0, http_connection_header(mode));
+    if (length < 0 || (size_t)length >= sizeof(response)) {
+        return;
+    }
 
-    // 헤더 전송
-    send(client_fd, response, length, 0);
+    writev_all(client_fd, response, length, body, body ? body_length : 0);
+}
 
-    // 본문 전송
-    if (body && body_length > 0) {
-        send(client_fd, body, body_length, 0);
+// 요청 헤더 값 검색 (대소문자 무시)
+static const char *find_header(HttpRequest *http_request, const char *name) {
+    for (int i = 0; i < http_request->header_count; i++) {
+        if (strcasecmp(http_request->headers[i][0], name) == 0) {
+            return http_request->headers[i][1];
+        }
     }
+    return NULL;
 }
 
-// 파일 경로 보안 검증 함수
-int is_valid_path(const char *path) {
-    // 경로에 ".."이 포함되어 있는지 검사하여 디렉토리 트래버설 방지
-    if (strstr(path, "..")) {
-        return 0;
+// 쉼표로 구분된 헤더 값에 token이 있는지 확인 (예: "Connection: keep-alive, Upgrade")
+static bool header_has_token(const char *value, const char *token) {
+    size_t token_len = strlen(token);
+    while (value && *value) {
+        while (*value == ' ' || *value == '\t' || *value == ',') {
+            value++;
+        }
+        size_t len = strcspn(value, ",");
+        while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) {
+            len--;
+        }
+        if (len == token_len && strncasecmp(value, token, token_len) == 0) {
+            return true;
+        }
+        value = strchr(value, ',');
+    }
+    return false;
+}
+
+// 요청 버전과 Connection 헤더로 응답 후 연결 유지 여부 결정
+static HttpConnectionMode get_connection_mode(HttpRequest *http_request) {
+    const char *connection = find_header(http_request, "Connection");
+
+    // HTTP/1.0은 명시적으로 keep-alive를 요청해야 유지, HTTP/1.1은 close가 없으면 유지
+    if (strcmp(http_request->version, "HTTP/1.0") == 0) {
+        return header_has_token(connection, "keep-alive") ? HTTP_KEEP_ALIVE : HTTP_CLOSE;
     }
-    return 1;
+    return header_has_token(connection, "close") ? HTTP_CLOSE : HTTP_KEEP_ALIVE;
 }
 
-// 정적 파일 요청 처리 함수
-void handle_static_file_request(int client_fd, const char *path) {
+// 조건부 요청(If-None-Match / If-Modified-Since)이 캐시된 파일과 일치하는지 확인
+static bool is_not_modified(HttpRequest *http_request, StaticFile *file, StaticVariant *variant) {
 
-    char file_path[512];
-    snprintf(file_path, sizeof(file_path), "%s%s", STATIC_FILES_DIR, path);
+    // If-None-Match가 있으면 If-Modified-Since보다 우선한다 (ETag는 인코딩별로 다르다)
+    const char *if_none_match = find_header(http_request, "If-None-Match");
+    if (if_none_match) {
+        return strcmp(if_none_match, "*") == 0 || strstr(if_none_match, variant->etag) != NULL;
+    }
 
-    // 파일 경로 검증
-    if (!is_valid_path(file_path)) {
-        const char *error_body = "<h1>403 Forbidden</h1>";
-        send_http_response(client_fd, "403 Forbidden", "Content-Type: text/html\r\n", error_body, strlen(error_body));
-        return;
+    // 브라우저는 받은 Last-Modified 값을 그대로 돌려주므로 문자열 비교로 충분하다
+    const char *if_modified_since = find_header(http_request, "If-Modified-Since");
+    if (if_modified_since) {
+        return strcmp(if_modified_since, file->last_modified) == 0;
     }
 
-    FILE *file = fopen(file_path, "rb");
+    return false;
+}
+
+// 정적 파일 요청 처리 함수 (메모리 캐시에서 미리 만든 응답을 전송)
+// 응답하는 동안 캐시가 재적재되어도 이 요청이 잡은 파일 묶음은 해제되지 않는다
+static int handle_static_file_request(ClientManager *manager, int client_fd, HttpRequest *http_request, HttpConnectionMode mode) {
+
+    StaticTable *table = static_cache_acquire(manager->static_cache);
+    StaticFile *file = find_static_file(table, http_request->path);
+    int result = 0;
     if (!file) {
         const char *error_body = "<h1>404 Not Found</h1>";
-        send_http_response(client_fd, "404 Not Found", "Content-Type: text/html\r\n", error_body, strlen(error_body));
-        return;
+        send_http_response(client_fd, "404 Not Found", "Content-Type: text/html\r\n", error_body, strlen(error_body), mode);
+        static_cache_release(table);
+        return 0;
     }
 
-    // 파일 크기 계산
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    rewind(file);
+    // Accept-Encoding에 맞춰 미리 압축해 둔 변형 선택
+    StaticVariant *variant = select_static_variant(file, find_header(http_request, "Accept-Encoding"));
 
-    // 파일 내용 읽기
-    char *file_content = malloc(file_size);
-    fread(file_content, 1, file_size, file);
-    fclose(file);
+    if (is_not_modified(http_request, file, variant)) {
+        result = writev_all(client_fd, variant->not_modified[mode], variant->not_modified_len[mode], NULL, 0);
+    }
+    // 작은 파일은 헤더 + 본문을 writev 한 번으로, 큰 파일은 헤더 전송 후 sendfile
+    else if (writev_all(client_fd, variant->header[mode], variant->header_len[mode], variant->body, variant->body ? variant->body_len : 0) == -1) {
+        result = -1;
+    }
+    else if (variant->body == NULL && file->fd != -1) {
+        result = sendfile_all(client_fd, file->fd, variant->body_len);
+    }
+    static_cache_release(table);
+    return result;
+}
 
-    // MIME 타입 결정
-    const char *mime_type = get_mime_type(file_path);
+// GET /metrics: Prometheus 텍스트 형식으로 서버 상태 노출
+static int handle_metrics_request(ClientManager *manager, int client_fd, HttpConnectionMode mode) {
 
-    // 헤더 생성
-    char headers[256];
-    snprintf(headers, sizeof(headers), "Content-Type: %s\r\nContent-Length: %ld\r\n", mime_type, file_size);
+    char *body = (char *)malloc(METRICS_BUFFER_SIZE);
+    if (body == NULL) {
+        return -1;
+    }
 
-    // 응답 전송
-    send_http_response(client_fd, "200 OK", headers, file_content, file_size);
+    size_t length = metrics_render(body, METRICS_BUFFER_SIZE);
+
+    // ClientManager가 가진 상태 (접속자 수, accept 통계)
+    AcceptStats *stats = &manager->accept_stats;
+    length = metrics_append(body, METRICS_BUFFER_SIZE, length,
+                            "# HELP fainter_connected_clients Open WebSocket clients\n"
+                            "# TYPE fainter_connected_clients gauge\n"
+                            "fainter_connected_clients %d\n"
+                            "# HELP fainter_accepted_total Accepted TCP connections\n"
+                            "# TYPE fainter_accepted_total counter\n"
+                            "fainter_accepted_total %lu\n"
+                            "# HELP fainter_accept_batches_total accept4 drain rounds that accepted at least one socket\n"
+                            "# TYPE fainter_accept_batches_total counter\n"
+                            "fainter_accept_batches_total %lu\n"
+                            "# HELP fainter_accept_pauses_total Times accepting was paused on EMFILE/ENFILE\n"
+                            "# TYPE fainter_accept_pauses_total counter\n"
+                            "fainter_accept_pauses_total %lu\n"
+                            "# HELP fainter_accept_rate Connections accepted during the last second\n"
+                            "# TYPE fainter_accept_rate gauge\n"
+                            "fainter_accept_rate %lu\n"
+                            "# HELP fainter_listen_backlog_depth Connections waiting in the listen backlog\n"
+                            "# TYPE fainter_listen_backlog_depth gauge\n"
+                            "fainter_listen_backlog_depth %lu\n"
+                            "# HELP fainter_listen_backlog_limit Listen backlog size\n"
+                            "# TYPE fainter_listen_backlog_limit gauge\n"
+                            "fainter_listen_backlog_limit %lu\n"
+                            "# HELP fainter_work_pool_workers Work-stealing pool threads\n"
+                            "# TYPE fainter_work_pool_workers gauge\n"
+                            "fainter_work_pool_workers %d\n"
+                            "# HELP fainter_work_pool_jobs_total Jobs run by the work pool\n"
+                            "# TYPE fainter_work_pool_jobs_total counter\n"
+                            "fainter_work_pool_jobs_total %lu\n"
+                            "# HELP fainter_work_pool_steals_total Jobs taken from another worker's deque\n"
+                            "# TYPE fainter_work_pool_steals_total counter\n"
+                            "fainter_work_pool_steals_total %lu\n"
+                            "# HELP fainter_work_pool_pending Jobs waiting in the work pool\n"
+                            "# TYPE fainter_work_pool_pending gauge\n"
+                            "fainter_work_pool_pending %lu\n",
+                            get_client_count(manager),
+                            atomic_load(&stats->accepted), atomic_load(&stats->batches), atomic_load(&stats->pauses),
+                            atomic_load(&stats->accept_rate), atomic_load(&stats->backlog_depth),
+                            atomic_load(&stats->backlog_max),
+                            work_pool_size(), work_pool_executed(), work_pool_stolen(), work_pool_pending());
+    if (length >= METRICS_BUFFER_SIZE) {
+        length = METRICS_BUFFER_SIZE - 1;
+    }
 
-    free(file_content);
+    send_http_response(client_fd, "200 OK", "Content-Type: text/plain; version=0.0.4\r\n", body, (int)length, mode);
+    free(body);
+    return 0;
 }
 
-// WebSocket 업그레이드 요청 처리 함수
-void handle_websocket_upgrade(ClientManager *manager, Client *client, HttpRequest *http_request) {
+// 운영 엔드포인트(/metrics, /stats, /trace/*)를 요청한 연결이 이 호스트에서 왔는지
+// 공개 포트에서 트레이스를 켜고 끄거나 내부 지표를 읽지 못하도록 루프백과 유닉스 소켓만 허용한다
+// 다른 호스트에서 수집해야 하면 FAINTER_ADMIN_HTTP=1 로 모두 허용
+static bool admin_allowed(int client_fd) {
 
-    char accept_key[256];
-    const char *client_key = NULL;
+    const char *value = getenv("FAINTER_ADMIN_HTTP");
+    if (value != NULL && strcmp(value, "1") == 0) {
+        return true;
+    }
 
-    // Sec-WebSocket-Key 헤더 검색
-    for (int i = 0; i < http_request->header_count; i++) {
-        if (strcasecmp(http_request->headers[i][0], "Sec-WebSocket-Key") == 0) {
-            client_key = http_request->headers[i][1];
-            break;
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(client_fd, (struct sockaddr *)&addr, &addr_len) == -1) {
+        return false;
+    }
+    if (addr.ss_family == AF_UNIX) {
+        return true;
+    }
+    if (addr.ss_family == AF_INET) {
+        const struct sockaddr_in *in = (const struct sockaddr_in *)&addr;
+        return (ntohl(in->sin_addr.s_addr) >> 24) == 127;
+    }
+    if (addr.ss_family == AF_INET6) {
+        const struct in6_addr *in6 = &((const struct sockaddr_in6 *)&addr)->sin6_addr;
+        return IN6_IS_ADDR_LOOPBACK(in6) || (IN6_IS_ADDR_V4MAPPED(in6) && in6->s6_addr[12] == 127);
+    }
+    return false;
+}
+
+// GET /trace/start, /trace/stop, /trace/dump: 이벤트 트레이스 제어
+// dump는 Chrome trace JSON (chrome://tracing, ui.perfetto.dev 에서 열기)
+static int handle_trace_request(int client_fd, const char *path, HttpConnectionMode mode) {
+
+    const char *text_headers = "Content-Type: text/plain\r\n";
+
+    if (strcmp(path, "/trace/start") == 0) {
+        trace_start();
+        send_http_response(client_fd, "200 OK", text_headers, "tracing on\n", 11, mode);
+    } else if (strcmp(path, "/trace/stop") == 0) {
+        trace_stop();
+        send_http_response(client_fd, "200 OK", text_headers, "tracing off\n", 12, mode);
+    } else if (strcmp(path, "/trace/dump") == 0) {
+        size_t length = 0;
+        char *body = trace_dump(&length);
+        if (body == NULL) {
+            const char *error_body = "trace dump failed\n";
+            send_http_response(client_fd, "500 Internal Server Error", text_headers, error_body, strlen(error_body), mode);
+            return 0;
         }
+        send_http_response(client_fd, "200 OK", "Content-Type: application/json\r\n", body, (int)length, mode);
+        free(body);
+    } else {
+        const char *error_body = "<h1>404 Not Found</h1>";
+        send_http_response(client_fd, "404 Not Found", "Content-Type: text/html\r\n", error_body, strlen(error_body), mode);
     }
+    return 0;
+}
 
-    if (!client_key) {
-        // 키가 없으면 에러 응답
-        const char *error_body = "<h1>400 Bad Request</h1>";
-        send_http_response(client->socket_fd, "400 Bad Request", "Content-Type: text/html\r\n", error_body, strlen(error_body));
-        return;
+// 쿼리 문자열에서 name=값 을 찾아 숫자로 (없으면 기본값)
+static unsigned long query_param(const char *path, const char *name, unsigned long default_value) {
+
+    const char *query = strchr(path, '?');
+    size_t name_len = strlen(name);
+    while (query != NULL) {
+        query++;
+        if (strncmp(query, name, name_len) == 0 && query[name_len] == '=') {
+            return strtoul(query + name_len + 1, NULL, 10);
+        }
+        query = strchr(query, '&');
     }
+    return default_value;
+}
 
-    // Accept 키 생성
-    generate_websocket_accept_key(client_key, accept_key);
+// GET /stats[?last=N][&since=unix_ms]: 통계 샘플러의 시계열을 CSV로
+static int handle_stats_request(int client_fd, const char *path, HttpConnectionMode mode) {
 
-    // 응답 헤더 생성
-    char response[512];
-    int length = snprintf(response, sizeof(response),
-                          "HTTP/1.1 101 Switching Protocols\r\n"
-                          "Upgrade: websocket\r\n"
-                          "Connection: Upgrade\r\n"
-                          "Sec-WebSocket-Accept: %s\r\n"
-                          "\r\n",
-                          accept_key);
+    const StatsFileHeader *ring = stats_ring();
+    size_t length = 0;
+    char *body = ring ? stats_render_csv(ring, query_param(path, "since", 0), query_param(path, "last", 0), &length) : NULL;
+    if (body == NULL) {
+        const char *error_body = "stats unavailable\n";
+        send_http_response(client_fd, "503 Service Unavailable", "Content-Type: text/plain\r\n", error_body, strlen(error_body), mode);
+        return 0;
+    }
+    send_http_response(client_fd, "200 OK", "Content-Type: text/csv\r\n", body, (int)length, mode);
+    free(body);
+    return 0;
+}
 
-    // printf("Websocket Connected :%d\n", client->socket_fd);
+// WebSocket 업그레이드 요청 처리 함수 (101을 보냈으면 HTTP_RESULT_UPGRADE, 상태 변경은 완료 처리에서)
+static int handle_websocket_upgrade(int client_fd, HttpRequest *http_request) {
 
-    // 응답 전송
-    send(client->socket_fd, response, length, 0);
+    const char *client_key = find_header(http_request, "Sec-WebSocket-Key");
 
-    // 클라이언트 상태 업데이트
-    client->state = CONNECTION_OPEN;
-    // 현재 접속한 클라이언트 수 증가
-    pthread_spin_lock(&manager->lock);
-    manager->client_count++;
-    pthread_spin_unlock(&manager->lock);
+    // 101 응답 생성 (Accept 키 계산 포함, 할당 없음)
+    char response[WEBSOCKET_ACCEPT_RESPONSE_SIZE];
+    int length = client_key ? build_websocket_accept_response(client_key, response, sizeof(response)) : -1;
 
-    Task task = {client->socket_fd, TASK_NEW_CLIENT, NULL, 0};
-    push_task(manager->canvas_queue, task);
+    if (length == -1) {
+        // 키가 없거나 잘못되었으면 에러 응답 후 연결 종료
+        const char *error_body = "<h1>400 Bad Request</h1>";
+        send_http_response(client_fd, "400 Bad Request", "Content-Type: text/html\r\n", error_body, strlen(error_body), HTTP_CLOSE);
+        return HTTP_RESULT_CLOSE;
+    }
+
+    // 응답 전송
+    if (send_all(client_fd, response, length) == -1) {
+        return HTTP_RESULT_CLOSE;
+    }
+    return HTTP_RESULT_UPGRADE;
 }
 
-// HTTP 요청 처리 함수
-void handle_http_request(ClientManager *manager, Client *client) {
+// 완성된 HTTP 요청 하나를 처리 (작업 풀 워커에서 실행, 클라이언트 구조체는 건드리지 않고 fd로만 응답)
+static HttpResult handle_http_request(ClientManager *manager, int client_fd, char *request) {
 
     HttpRequest http_request;
     memset(&http_request, 0, sizeof(HttpRequest));
 
     // HTTP 요청 파싱
-    http_parsing(client->recv_buffer, &http_request);
+    http_parsing(request, &http_request);
 
-    // 메서드와 경로 출력 (디버그용)
-    // printf("Received HTTP Request: %s %s\n", http_request.method, http_request.path);
+    HttpConnectionMode mode = get_connection_mode(&http_request);
+    int result;
+    metrics_add(METRIC_HTTP_REQUESTS, 1);
 
     // GET 메서드인지 확인
     if (strcasecmp(http_request.method, "GET") != 0) {
         const char *error_body = "<h1>405 Method Not Allowed</h1>";
-        send_http_response(client->socket_fd, "405 Method Not Allowed", "Content-Type: text/html\r\n", error_body, strlen(error_body));
-        return;
+        send_http_response(client_fd, "405 Method Not Allowed", "Content-Type: text/html\r\n", error_body, strlen(error_body), mode);
+        result = 0;
     }
-
-    // Upgrade 헤더 확인
-    int is_upgrade = 0;
-    for (int i = 0; i < http_request.header_count; i++) {
-        // "Upgrade: websocket" 헤더가 있는 경우 weboscket 업그레이드 요청으로 판단.
-        if (strcasecmp(http_request.headers[i][0], "Upgrade") == 0 &&
-            strcasecmp(http_request.headers[i][1], "websocket") == 0) {
-            is_upgrade = 1;
-            break;
+    // "Upgrade: websocket" 헤더가 있는 경우 weboscket 업그레이드 요청으로 판단.
+    else if (header_has_token(find_header(&http_request, "Upgrade"), "websocket")) {
+        // WebSocket 업그레이드 요청 처리
+        if (http_request.body) {
+            free(http_request.body);
         }
+        return handle_websocket_upgrade(client_fd, &http_request);
     }
-
-    if (is_upgrade) {
-        // WebSocket 업그레이드 요청 처리
-        handle_websocket_upgrade(manager, client, &http_request);
+    // 운영 엔드포인트: 다른 호스트에서 온 요청은 정적 파일 요청으로 처리한다 (404)
+    else if (strcmp(http_request.path, "/metrics") == 0 && admin_allowed(client_fd)) {
+        // 메트릭 요청 처리
+        result = handle_metrics_request(manager, client_fd, mode);
+    } else if ((strcmp(http_request.path, "/stats") == 0 || strncmp(http_request.path, "/stats?", 7) == 0) &&
+               admin_allowed(client_fd)) {
+        // 통계 시계열 요청 처리
+        result = handle_stats_request(client_fd, http_request.path, mode);
+    } else if (strncmp(http_request.path, "/trace/", 7) == 0 && admin_allowed(client_fd)) {
+        // 트레이스 제어 요청 처리
+        result = handle_trace_request(client_fd, http_request.path, mode);
     } else {
         // 정적 파일 요청 처리
-        handle_static_file_request(client->socket_fd, http_request.path);
+        result = handle_static_file_request(manager, client_fd, &http_request, mode);
     }
 
     // 메모리 해제
     if (http_request.body) {
         free(http_request.body);
     }
+
+    return (result == -1 || mode == HTTP_CLOSE) ? HTTP_RESULT_CLOSE : HTTP_RESULT_KEEP;
 }
 
-// HTTP 요청 완전성 확인
-bool is_complete_http_request(const char *buffer) {
-    // HTTP 헤더 끝은 항상 \r\n\r\n으로 끝남
-    const char *end_of_header = strstr(buffer, "\r\n\r\n");
-    return end_of_header != NULL;
+// 작업 풀에서 실행: 요청 하나에 응답하고 CM에 완료 작업을 넣는다
+static void http_job(void *arg) {
+
+    HttpJob *job = (HttpJob *)arg;
+    if (job->error_status != NULL) {
+        char error_body[64];
+        int length = snprintf(error_body, sizeof(error_body), "<h1>%s</h1>", job->error_status);
+        send_http_response(job->client_fd, job->error_status, "Content-Type: text/html\r\n", error_body, length, HTTP_CLOSE);
+        job->result = HTTP_RESULT_CLOSE;
+    } else {
+        job->result = handle_http_request(job->manager, job->client_fd, job->request);
+    }
+    Task task = {job->client_fd, TASK_HTTP_DONE, job, 0, 0, 0};
+    push_task_wait(job->manager->queue, task);
 }
 
-// HTTP 요청인지 확인하는 함수
-bool is_http_request(const char *data, size_t length) {
+// 작업 풀에 요청 하나를 넘긴다 (완료될 때까지 이 클라이언트는 닫지 않는다, removeClient가 미룬다)
+static void submit_http_job(ClientManager *manager, Client *client, HttpJob *job, const char *error_status) {
+    job->manager = manager;
+    job->client_fd = client->socket_fd;
+    job->error_status = error_status;
+    client->http_busy = true;
+    work_pool_submit(http_job, job);
+}
 
-    if (length < 4) {
-        return false; // 최소한 HTTP 메소드 길이를 확인해야 함
+// 받을 수 없는 요청: 에러 응답도 작업 풀에서 보내고 완료 후 닫는다 (CM 스레드는 송신 버퍼를 기다리지 않는다)
+static int submit_http_error(ClientManager *manager, Client *client, HttpJob *job, const char *error_status) {
+    if (job == NULL) {
+        job = malloc(sizeof(HttpJob));
+        if (job == NULL) {
+            return -1;
+        }
     }
+    job->request[0] = '\0';
+    submit_http_job(manager, client, job, error_status);
+    return 0;
+}
 
-    // HTTP 메소드 확인
-    const char *http_methods[] = {"GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "TRACE"};
-    size_t num_methods = sizeof(http_methods) / sizeof(http_methods[0]);
+// 수신 버퍼에 쌓인 완성된 요청 중 첫 번째를 작업 풀에 넘긴다 (파이프라이닝)
+// 응답은 한 번에 하나씩: 나머지 요청은 완료(handle_http_done) 후에 이어서 처리한다.
+static int handle_buffered_requests(ClientManager *manager, Client *client) {
 
-    for (size_t i = 0; i < num_methods; i++) {
-        size_t method_len = strlen(http_methods[i]);
-        if (length >= method_len && strncmp(data, http_methods[i], method_len) == 0) {
-            return true;
+    while (client->state == CONNECTION_HANDSHAKE && !client->http_busy) {
+        char *buffer = client->recv_buffer;
+        size_t buffer_len = client->recv_buffer_len;
+
+        // 헤더 끝(\r\n\r\n)을 찾아 요청 하나의 길이를 결정
+        char *end_of_header = memmem(buffer, buffer_len, "\r\n\r\n", 4);
+        if (end_of_header == NULL) {
+            break;
+        }
+        size_t header_len = end_of_header - buffer + 4;
+
+        // 파싱이 버퍼를 변경하므로 요청 헤더만 따로 복사해서 워커에 넘긴다
+        HttpJob *job = malloc(sizeof(HttpJob));
+        if (job == NULL) {
+            return -1;
+        }
+        memcpy(job->request, buffer, header_len);
+        job->request[header_len] = '\0';
+
+        // 본문이 있는 요청은 본문까지 도착해야 처리 (Content-Length 프레이밍)
+        size_t request_len = header_len;
+        char *content_length = strcasestr(job->request, "\r\nContent-Length:");
+        if (content_length) {
+            request_len += strtoul(content_length + 17, NULL, 10);
+        }
+        if (request_len >= REQUEST_BUFFER_SIZE) {
+            return submit_http_error(manager, client, job, "413 Payload Too Large");
+        }
+        if (request_len > buffer_len) {
+            free(job);
+            break;
         }
+
+        // 처리한 요청은 버퍼에서 제거
+        memmove(buffer, buffer + request_len, buffer_len - request_len);
+        client->recv_buffer_len = buffer_len - request_len;
+
+        submit_http_job(manager, client, job, NULL);
     }
+    return 0;
+}
 
-    // "HTTP/1.1" 또는 "HTTP/1.0" 존재 여부 확인
-    if (strstr(data, "HTTP/1.1") || strstr(data, "HTTP/1.0")) {
-        return true;
+void handle_http_done(ClientManager *manager, HttpJob *job) {
+
+    Client *client = find_client(manager, job->client_fd);
+    HttpResult result = job->result;
+    free(job);
+    if (client == NULL) {
+        return;
     }
+    client->http_busy = false;
 
-    return false;
-}
\ No newline at end of file
+    // 응답하는 동안 끊겼거나, 응답 후 닫아야 하는 요청
+    if (client->close_pending || result == HTTP_RESULT_CLOSE) {
+        removeClient(manager, client->socket_fd);
+        return;
+    }
+
+    if (result == HTTP_RESULT_UPGRADE) {
+        // 클라이언트 상태 업데이트
+        client->state = CONNECTION_OPEN;
+        registry_add(&manager->registry, client);
+        client->last_recv = monotonic_seconds();
+        client->last_message = client->last_recv;
+        arm_client_timer(manager, client);
+        // 현재 접속한 클라이언트 수 증가
+        pthread_spin_lock(&manager->lock);
+        manager->client_count++;
+        pthread_spin_unlock(&manager->lock);
+
+        // CM은 캔버스 큐를 기다리지 않는다: 가득 차면 재동기화 요청으로 돌려 타이머 틱에 다시 넣는다
+        // (스냅샷을 받기 전의 브로드캐스트는 보내지 않는다)
+        Task task = {client->socket_fd, TASK_NEW_CLIENT, NULL, 0, 0, 0};
+        if (!push_task(manager->canvas_queue, task)) {
+            pthread_mutex_lock(&client->send_lock);
+            client->resync_pending = true;
+            client->resync_requested = false;
+            pthread_mutex_unlock(&client->send_lock);
+            atomic_store(&manager->send_sweep, true);
+        }
+
+        // 메인 스레드는 업그레이드 요청 뒤의 바이트를 frame으로 나눠 보내므로 (CM이 모아뒀다가 이어서 처리)
+        // 버퍼에 남은 HTTP 바이트는 없다. 이제부터 버퍼는 조각난 frame 메세지를 모으는 데 쓴다
+        client->recv_buffer_len = 0;
+        return;
+    }
+
+    // 파이프라이닝으로 이미 도착해 있던 다음 요청
+    client->last_active = monotonic_seconds();
+    if (handle_buffered_requests(manager, client) == -1) {
+        removeClient(manager, client->socket_fd);
+    }
+}
+
+// HTTP 연결로 들어온 데이터를 처리 (조각난 요청은 모아두고, 여러 요청은 순서대로 응답)
+int handle_http_stream(ClientManager *manager, Client *client, const char *data, size_t len) {
+
+    client->last_active = monotonic_seconds();
+
+    while (len > 0) {
+        size_t room = REQUEST_BUFFER_SIZE - 1 - client->recv_buffer_len;
+        if (room == 0 && client->http_busy) {
+            // 응답하는 동안 버퍼가 찰 만큼 요청을 밀어 넣었다 (워커가 같은 소켓에 쓰는 중이라 에러 응답은 생략)
+            removeClient(manager, client->socket_fd);
+            return -1;
+        }
+        if (room == 0) {
+            // 헤더가 버퍼보다 큰 요청 (응답 후 닫는다, 남은 바이트는 읽지 않는다)
+            if (submit_http_error(manager, client, NULL, "431 Request Header Fields Too Large") == -1) {
+                removeClient(manager, client->socket_fd);
+                return -1;
+            }
+            return 0;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(client->recv_buffer + client->recv_buffer_len, data, n);
+        client->recv_buffer_len += n;
+        data += n;
+        len -= n;
+
+        if (handle_buffered_requests(manager, client) == -1) {
+            removeClient(manager, client->socket_fd);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 버퍼 앞에 있는 요청 하나의 길이 (헤더 + Content-Length 본문), 헤더 끝이 아직 오지 않았으면 0
+// 파싱은 워커가 하므로 여기서는 요청 경계와 업그레이드 여부만 본다 (워커와 같은 조건: GET + Upgrade: websocket)
+size_t http_request_length(const char *buffer, size_t len, bool *upgrade) {
+
+    *upgrade = false;
+    const char *end_of_header = memmem(buffer, len, "\r\n\r\n", 4);
+    if (end_of_header == NULL) {
+        return 0;
+    }
+    size_t header_len = end_of_header - buffer + 4;
+    size_t body_len = 0;
+    bool get = header_len > 4 && strncasecmp(buffer, "GET ", 4) == 0;
+
+    // 요청 줄 다음 줄부터 헤더 끝까지
+    const char *line = (const char *)memmem(buffer, header_len, "\r\n", 2) + 2;
+    while (line < end_of_header) {
+        const char *line_end = memmem(line, end_of_header + 2 - line, "\r\n", 2);
+        size_t line_len = line_end - line;
+        if (line_len > 15 && strncasecmp(line, "Content-Length:", 15) == 0) {
+            body_len = strtoul(line + 15, NULL, 10);    // 줄 끝의 \r에서 멈춘다
+        }
+        else if (get && line_len > 8 && strncasecmp(line, "Upgrade:", 8) == 0) {
+            char value[256];
+            size_t value_len = line_len - 8 < sizeof(value) - 1 ? line_len - 8 : sizeof(value) - 1;
+            memcpy(value, line + 8, value_len);
+            value[value_len] = '\0';
+            *upgrade = header_has_token(value, "websocket");
+        }
+        line = line_end + 2;
+    }
+    return header_len + body_len;
+}
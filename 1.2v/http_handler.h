@@ -4,8 +4,35 @@
 
 #include "client_manager.h"
 
-void handle_http_request(ClientManager *manager, Client *client);
-bool is_complete_http_request(const char *buffer);
-bool is_http_request(const char *data, size_t length);
+#define HTTP_SEND_TIMEOUT_MS 1000 // 송신 버퍼가 가득 찼을 때 기다리는 최대 시간
+
+// 요청 하나를 처리한 결과
+typedef enum {
+    HTTP_RESULT_KEEP,               // 연결 유지 (다음 요청 대기)
+    HTTP_RESULT_CLOSE,              // 응답 후 연결 종료
+    HTTP_RESULT_UPGRADE             // 101을 보냈다 (WebSocket으로 전환)
+} HttpResult;
+
+// 작업 풀 워커에 넘기는 요청 하나 (완료되면 TASK_HTTP_DONE으로 CM에 돌아온다)
+typedef struct {
+    ClientManager *manager;
+    int client_fd;
+    HttpResult result;
+    const char *error_status;       // NULL이 아니면 요청 대신 이 상태로 에러 응답을 보내고 닫는다 (413, 431)
+    char request[REQUEST_BUFFER_SIZE + 1];
+} HttpJob;
+
+// HTTP 연결로 들어온 데이터를 처리, 연결을 닫았으면 -1
+// 완성된 요청은 작업 풀에서 응답하고, 연결당 한 번에 하나씩만 처리한다 (파이프라이닝 순서 유지)
+int handle_http_stream(ClientManager *manager, Client *client, const char *data, size_t len);
+
+// TASK_HTTP_DONE: 워커의 응답이 끝난 뒤 CM 스레드에서 클라이언트 상태 반영, 다음 요청 처리
+void handle_http_done(ClientManager *manager, HttpJob *job);
+
+void send_http_response(int client_fd, const char *status, const char *headers, const char *body, int body_length, HttpConnectionMode mode);
+
+// 버퍼 앞에 있는 HTTP 요청 하나의 길이 (헤더 + 본문), 헤더 끝이 아직 오지 않았으면 0
+// upgrade: WebSocket 업그레이드 요청이면 true (101을 보내거나 연결을 닫으므로 뒤따르는 바이트는 frame이다)
+size_t http_request_length(const char *buffer, size_t len, bool *upgrade);
 
 #endif // HTTP_HANDLER_H
@@ -5,15 +5,16 @@
 
 void http_parsing(char *request, HttpRequest *http_request) {
             
-    // 요청 라인 파싱
-    char *line = strtok(request, "\r\n");
+    // 요청 라인 파싱 (작업 풀 워커 여럿이 동시에 파싱하므로 strtok_r)
+    char *saveptr = NULL;
+    char *line = strtok_r(request, "\r\n", &saveptr);
     if (line) {
         sscanf(line, "%s %s %s", http_request->method, http_request->path, http_request->version);
     }
 
     // 헤더 파싱
     http_request->header_count = 0;
-    while ((line = strtok(NULL, "\r\n")) && strcmp(line, "") != 0) {
+    while ((line = strtok_r(NULL, "\r\n", &saveptr)) && strcmp(line, "") != 0) {
         char header_name[128], header_value[256];
         sscanf(line, "%[^:]: %[^\r\n]", header_name, header_value);
 
@@ -38,7 +39,7 @@ void http_parsing(char *request, HttpRequest *http_request) {
 
     // 본문이 있으면 메모리를 할당하고 복사
     if (content_length > 0) {
-        line = strtok(NULL, ""); // 나머지 문자열 읽기 (본문)
+        line = strtok_r(NULL, "", &saveptr); // 나머지 문자열 읽기 (본문)
         if (line) {
             http_request->body = malloc(content_length + 1);
             strncpy(http_request->body, line, content_length);
@@ -0,0 +1,381 @@
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include "affinity.h"
+
+atomic_int log_level = LOG_LEVEL_INFO;
+
+#define LOG_OUTPUT_SIZE (64 * 1024)     // 로그 스레드 출력 버퍼
+#define LOG_IDLE_SLEEP_MS 10            // 비어 있을 때 로그 스레드 대기 시간
+#define LOG_RATE_SLOTS 64               // 호출 위치별 제한 테이블 크기 (스레드별)
+
+typedef union {
+    long i;
+    unsigned long u;
+    double d;
+    const void *p;
+    unsigned int text_offset;           // 문자열 인자: text 안의 위치
+} LogValue;
+
+typedef struct {
+    unsigned long time_ns;              // CLOCK_REALTIME
+    const char *fmt;
+    unsigned char level;
+    unsigned char nargs;
+    unsigned char types[LOG_MAX_ARGS];
+    LogValue values[LOG_MAX_ARGS];
+    char text[LOG_TEXT_SIZE];
+} LogEntry;
+
+// 스레드별 링 (쓰는 스레드 하나, 읽는 쪽은 rings_lock을 잡은 스레드 하나)
+typedef struct LogRing {
+    LogEntry entries[LOG_RING_SIZE];
+    atomic_ulong head;                  // 기록한 수
+    atomic_ulong tail;                  // 출력한 수
+    atomic_ulong dropped;               // 링이 가득 차서 버린 수
+    unsigned long dropped_reported;
+    unsigned long drain_tail;           // 출력 중인 위치 (읽는 쪽만 사용)
+    unsigned long drain_head;
+    struct LogRing *next;
+} LogRing;
+
+// 호출 위치(포맷 문자열)별 초당 메시지 수 제한
+typedef struct {
+    const char *fmt;
+    time_t window;                      // 초 단위 구간
+    unsigned int count;
+    unsigned long suppressed;
+} LogRateSlot;
+
+static __thread LogRing *local_ring = NULL;
+static __thread LogRateSlot rate_slots[LOG_RATE_SLOTS];
+static LogRing *rings = NULL;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *level_names[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+
+// 현재 스레드의 링 (처음 로그를 남길 때 한 번 할당)
+static LogRing *thread_ring(void) {
+
+    LogRing *ring = (LogRing *)calloc(1, sizeof(LogRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&rings_lock);
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&rings_lock);
+
+    local_ring = ring;
+    return ring;
+}
+
+static void push_entry(LogLevel level, const char *fmt, const LogArg *args, int nargs, unsigned long time_ns) {
+
+    LogRing *ring = local_ring;
+    if (ring == NULL && (ring = thread_ring()) == NULL) {
+        return;
+    }
+
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    LogEntry *entry = &ring->entries[head & (LOG_RING_SIZE - 1)];
+    entry->time_ns = time_ns;
+    entry->fmt = fmt;
+    entry->level = level;
+    entry->nargs = nargs < LOG_MAX_ARGS ? nargs : LOG_MAX_ARGS;
+
+    size_t text_used = 0;
+    for (int i = 0; i < entry->nargs; i++) {
+        entry->types[i] = args[i].type;
+        if (args[i].type == LOG_ARG_STRING) {
+            // 문자열은 값이 바뀌거나 해제될 수 있으므로 지금 복사 (공간이 모자라면 자른다)
+            const char *s = args[i].s ? args[i].s : "(null)";
+            size_t room = LOG_TEXT_SIZE - text_used - 1;
+            size_t len = strnlen(s, room);
+            memcpy(entry->text + text_used, s, len);
+            entry->text[text_used + len] = '\0';
+            entry->values[i].text_offset = text_used;
+            text_used += len + 1;
+            if (text_used > LOG_TEXT_SIZE - 1) {
+                text_used = LOG_TEXT_SIZE - 1;
+            }
+        } else {
+            entry->values[i].u = args[i].u;
+        }
+    }
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void log_write(LogLevel level, const char *fmt, const LogArg *args, int nargs) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    unsigned long time_ns = now.tv_sec * 1000000000UL + now.tv_nsec;
+
+    // 같은 위치에서 초당 LOG_RATE_LIMIT개를 넘는 메시지는 세기만 하고 버린다
+    LogRateSlot *slot = &rate_slots[((unsigned long)fmt >> 3) & (LOG_RATE_SLOTS - 1)];
+    if (slot->fmt != fmt || slot->window != now.tv_sec) {
+        if (slot->fmt == fmt && slot->suppressed > 0) {
+            LogArg summary[] = {log_arg_uint(slot->suppressed), log_arg_string(fmt)};
+            push_entry(LOG_LEVEL_WARN, "같은 위치의 로그 %lu개 생략됨: %s", summary, 2, time_ns);
+        }
+        slot->fmt = fmt;
+        slot->window = now.tv_sec;
+        slot->count = 0;
+        slot->suppressed = 0;
+    }
+    if (++slot->count > LOG_RATE_LIMIT) {
+        slot->suppressed++;
+        return;
+    }
+
+    push_entry(level, fmt, args, nargs, time_ns);
+}
+
+// 포맷 문자열의 변환 지정자 하나씩 저장된 인자로 출력
+static size_t format_entry(const LogEntry *entry, char *out, size_t size) {
+
+    size_t used = 0;
+    int arg = 0;
+    const char *p = entry->fmt;
+
+    while (*p != '\0' && used + 1 < size) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion
+        char spec[32];
+        size_t spec_len = 0;
+        spec[spec_len++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL && spec_len < sizeof(spec) - 4) {
+            spec[spec_len++] = *p++;
+        }
+        bool has_length = false;
+        while (*p != '\0' && strchr("hljztL", *p) != NULL) {
+            has_length = true;
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0') {
+            break;
+        }
+        p++;
+
+        if (arg >= entry->nargs) {
+            continue;
+        }
+        unsigned char type = entry->types[arg];
+        const LogValue *value = &entry->values[arg];
+        arg++;
+
+        size_t room = size - used;
+        int n = 0;
+        switch (conversion) {
+            case 'd': case 'i': case 'c':
+                if (conversion == 'c') {
+                    spec[spec_len++] = 'c';
+                    spec[spec_len] = '\0';
+                    n = snprintf(out + used, room, spec, (int)value->i);
+                } else {
+                    spec[spec_len++] = 'l';
+                    spec[spec_len++] = 'd';
+                    spec[spec_len] = '\0';
+                    n = snprintf(out + used, room, spec, type == LOG_ARG_DOUBLE ? (long)value->d : value->i);
+                }
+                break;
+            case 'u': case 'x': case 'X': case 'o': {
+                unsigned long v = type == LOG_ARG_DOUBLE ? (unsigned long)value->d : value->u;
+                // 길이 지정자가 없으면 int 크기 (음수 int가 64비트로 보이지 않게)
+                if (!has_length) {
+                    v = (unsigned int)v;
+                }
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                n = snprintf(out + used, room, spec, v);
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec[spec_len++] = conversion;
+                spec[spec_len] = '\0';
+                n = snprintf(out + used, room, spec, type == LOG_ARG_DOUBLE ? value->d : (double)value->i);
+                break;
+            case 's':
+                spec[spec_len++] = 's';
+                spec[spec_len] = '\0';
+                n = snprintf(out + used, room, spec,
+                             type == LOG_ARG_STRING ? entry->text + value->text_offset : "?");
+                break;
+            case 'p':
+                n = snprintf(out + used, room, "%p", value->p);
+                break;
+            default:
+                break;
+        }
+        if (n > 0) {
+            used += (size_t)n < room ? (size_t)n : room - 1;
+        }
+    }
+    return used;
+}
+
+// 한 번에 write하기 위한 출력 버퍼 (WARN 이상은 stderr)
+typedef struct {
+    int fd;
+    size_t length;
+    char data[LOG_OUTPUT_SIZE];
+} LogOutput;
+
+static LogOutput output_stdout = {STDOUT_FILENO, 0, {0}};
+static LogOutput output_stderr = {STDERR_FILENO, 0, {0}};
+
+static void output_flush(LogOutput *output) {
+
+    size_t written = 0;
+    while (written < output->length) {
+        ssize_t n = write(output->fd, output->data + written, output->length - written);
+        if (n <= 0) {
+            break;
+        }
+        written += n;
+    }
+    output->length = 0;
+}
+
+#define LOG_LINE_MAX 1024
+
+static void output_entry(const LogEntry *entry) {
+
+    LogOutput *output = entry->level >= LOG_LEVEL_WARN ? &output_stderr : &output_stdout;
+    if (output->length + LOG_LINE_MAX > LOG_OUTPUT_SIZE) {
+        output_flush(output);
+    }
+
+    time_t seconds = entry->time_ns / 1000000000UL;
+    struct tm tm;
+    localtime_r(&seconds, &tm);
+    char *line = output->data + output->length;
+    size_t used = strftime(line, LOG_LINE_MAX, "%H:%M:%S", &tm);
+    used += snprintf(line + used, LOG_LINE_MAX - used, ".%03lu %s ",
+                     (entry->time_ns / 1000000UL) % 1000, level_names[entry->level]);
+    used += format_entry(entry, line + used, LOG_LINE_MAX - used - 1);
+    // 기존 printf 메시지의 줄바꿈은 한 번만
+    while (used > 0 && line[used - 1] == '\n') {
+        used--;
+    }
+    line[used++] = '\n';
+    output->length += used;
+}
+
+// 모든 링을 비운다, 출력한 엔트리 수 반환
+// 스레드별 링을 시각 순으로 합쳐서 출력한다.
+static unsigned long drain_rings(void) {
+
+    unsigned long drained = 0;
+
+    pthread_mutex_lock(&rings_lock);
+    for (LogRing *ring = rings; ring != NULL; ring = ring->next) {
+        ring->drain_tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        ring->drain_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+    while (1) {
+        LogRing *oldest = NULL;
+        for (LogRing *ring = rings; ring != NULL; ring = ring->next) {
+            if (ring->drain_tail != ring->drain_head &&
+                (oldest == NULL ||
+                 ring->entries[ring->drain_tail & (LOG_RING_SIZE - 1)].time_ns <
+                 oldest->entries[oldest->drain_tail & (LOG_RING_SIZE - 1)].time_ns)) {
+                oldest = ring;
+            }
+        }
+        if (oldest == NULL) {
+            break;
+        }
+        output_entry(&oldest->entries[oldest->drain_tail & (LOG_RING_SIZE - 1)]);
+        oldest->drain_tail++;
+        drained++;
+    }
+
+    for (LogRing *ring = rings; ring != NULL; ring = ring->next) {
+        atomic_store_explicit(&ring->tail, ring->drain_tail, memory_order_release);
+
+        unsigned long dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+        if (dropped != ring->dropped_reported) {
+            char message[96];
+            int n = snprintf(message, sizeof(message), "로그 %lu개 유실 (링 버퍼 가득 참)\n",
+                             dropped - ring->dropped_reported);
+            if (output_stderr.length + n > LOG_OUTPUT_SIZE) {
+                output_flush(&output_stderr);
+            }
+            memcpy(output_stderr.data + output_stderr.length, message, n);
+            output_stderr.length += n;
+            ring->dropped_reported = dropped;
+        }
+    }
+    output_flush(&output_stderr);
+    output_flush(&output_stdout);
+    pthread_mutex_unlock(&rings_lock);
+
+    return drained;
+}
+
+static void *log_thread(void *arg) {
+
+    (void)arg;
+    affinity_apply("log", -1);
+    const struct timespec idle = {0, LOG_IDLE_SLEEP_MS * 1000000L};
+
+    while (1) {
+        if (drain_rings() == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+void log_flush(void) {
+    drain_rings();
+}
+
+void log_init(void) {
+
+    const char *env = getenv("FAINTER_LOG_LEVEL");
+    if (env != NULL) {
+        static const char *names[] = {"debug", "info", "warn", "error", "off"};
+        for (int i = 0; i <= LOG_LEVEL_OFF; i++) {
+            if (strcasecmp(env, names[i]) == 0) {
+                atomic_store(&log_level, i);
+            }
+        }
+    }
+
+    atexit(log_flush);
+
+    pthread_t tid;
+    const int n = pthread_create(&tid, NULL, log_thread, NULL);
+    if (n != 0) {
+        fprintf(stderr, "로그 스레드 생성 실패: %s\n", strerror(n));
+        return;
+    }
+    pthread_detach(tid);
+}
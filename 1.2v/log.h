@@ -0,0 +1,108 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdatomic.h>
+
+// 비동기 로거
+// 호출 스레드는 포맷 문자열 포인터와 인자 값만 스레드별 링에 복사하고,
+// 문자열 포맷팅과 write는 백그라운드 로그 스레드가 한다.
+// 사용법: LOG_INFO("[CM] 정적 파일 캐시 적재 완료: %u개 파일", count);
+//  - 포맷 문자열은 문자열 리터럴이어야 한다 (포인터만 저장, 호출 위치별 제한의 키)
+//  - 인자는 최대 LOG_MAX_ARGS개, '*' 너비/정밀도는 지원하지 않는다
+//  - 문자열 인자는 호출 시점에 복사된다 (LOG_TEXT_SIZE를 넘으면 잘린다)
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+} LogLevel;
+
+// 컴파일 시점 최소 레벨 (make LOG_LEVEL=LOG_LEVEL_INFO 이면 DEBUG 호출은 코드에서 사라진다)
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MAX_ARGS 8
+#define LOG_TEXT_SIZE 176          // 엔트리당 문자열 인자 복사 공간
+#define LOG_RING_SIZE 512          // 스레드당 엔트리 수 (2의 거듭제곱)
+#define LOG_RATE_LIMIT 10          // 호출 위치별 초당 최대 메시지 수
+
+typedef enum {
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+} LogArgType;
+
+typedef struct {
+    LogArgType type;
+    union {
+        long i;
+        unsigned long u;
+        double d;
+        const char *s;
+        const void *p;
+    };
+} LogArg;
+
+// 실행 시점 최소 레벨 (환경 변수 FAINTER_LOG_LEVEL=debug|info|warn|error|off)
+extern atomic_int log_level;
+
+static inline LogArg log_arg_int(long v) { return (LogArg){LOG_ARG_INT, {.i = v}}; }
+static inline LogArg log_arg_uint(unsigned long v) { return (LogArg){LOG_ARG_UINT, {.u = v}}; }
+static inline LogArg log_arg_double(double v) { return (LogArg){LOG_ARG_DOUBLE, {.d = v}}; }
+static inline LogArg log_arg_string(const char *v) { return (LogArg){LOG_ARG_STRING, {.s = v}}; }
+static inline LogArg log_arg_pointer(const void *v) { return (LogArg){LOG_ARG_POINTER, {.p = v}}; }
+
+// 인자 타입에 맞는 LogArg 생성
+#define LOG_ARG(x) _Generic((x),                                     \
+    char *: log_arg_string, const char *: log_arg_string,          \
+    float: log_arg_double, double: log_arg_double,                 \
+    unsigned char: log_arg_uint, unsigned short: log_arg_uint,     \
+    unsigned int: log_arg_uint, unsigned long: log_arg_uint,       \
+    unsigned long long: log_arg_uint,                              \
+    void *: log_arg_pointer, const void *: log_arg_pointer,        \
+    default: log_arg_int)(x)
+
+// 가변 인자 개수 세기와 각 인자에 LOG_ARG 적용
+#define LOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define LOG_NARG(...) LOG_NARG_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_CAT_(a, b) a##b
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_MAP_0()
+#define LOG_MAP_1(a) , LOG_ARG(a)
+#define LOG_MAP_2(a, ...) , LOG_ARG(a) LOG_MAP_1(__VA_ARGS__)
+#define LOG_MAP_3(a, ...) , LOG_ARG(a) LOG_MAP_2(__VA_ARGS__)
+#define LOG_MAP_4(a, ...) , LOG_ARG(a) LOG_MAP_3(__VA_ARGS__)
+#define LOG_MAP_5(a, ...) , LOG_ARG(a) LOG_MAP_4(__VA_ARGS__)
+#define LOG_MAP_6(a, ...) , LOG_ARG(a) LOG_MAP_5(__VA_ARGS__)
+#define LOG_MAP_7(a, ...) , LOG_ARG(a) LOG_MAP_6(__VA_ARGS__)
+#define LOG_MAP_8(a, ...) , LOG_ARG(a) LOG_MAP_7(__VA_ARGS__)
+#define LOG_MAP(...) LOG_CAT(LOG_MAP_, LOG_NARG(__VA_ARGS__))(__VA_ARGS__)
+
+#define LOG_AT(level, fmt, ...) do {                                                     \
+    if ((level) >= LOG_COMPILE_LEVEL &&                                                 \
+        (int)(level) >= atomic_load_explicit(&log_level, memory_order_relaxed)) {       \
+        const LogArg log_args_[] = { {LOG_ARG_INT, {0}} LOG_MAP(__VA_ARGS__) };          \
+        log_write((level), "" fmt, log_args_ + 1, LOG_NARG(__VA_ARGS__));                \
+    }                                                                                   \
+} while (0)
+
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+// 링에 엔트리 하나 기록 (가득 차면 버리고 유실 수만 센다)
+void log_write(LogLevel level, const char *fmt, const LogArg *args, int nargs);
+
+// 실행 시점 레벨을 읽고 로그 스레드 시작 (exit 시 남은 로그를 비운다)
+void log_init(void);
+
+// 쌓인 로그를 지금 바로 출력
+void log_flush(void);
+
+#endif // LOG_H
@@ -0,0 +1,278 @@
+#include "metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "log.h"
+
+__thread MetricsShard *metrics_local_shard = NULL;
+static MetricsShard *shards = NULL;                  // 등록된 스레드별 카운터, 히스토그램 리스트
+static pthread_mutex_t shards_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_ulong gauges[GAUGE_COUNT];
+
+static TaskQueue *queues[METRICS_MAX_QUEUES];
+static atomic_int queue_count = 0;
+
+// 이름, 설명, 종류 (MetricId 순서와 같아야 한다)
+static const struct {
+    const char *name;
+    const char *help;
+    const char *type;
+} metric_info[METRIC_COUNT] = {
+    {"fainter_epoll_wakeups_total", "epoll_wait returns on the main thread", "counter"},
+    {"fainter_epoll_events_total", "Events returned by epoll_wait (rate() gives events per second)", "counter"},
+    {"fainter_bytes_in_total", "Bytes read from client sockets", "counter"},
+    {"fainter_bytes_out_total", "Bytes written to client sockets", "counter"},
+    {"fainter_http_requests_total", "HTTP requests handled", "counter"},
+    {"fainter_pixels_applied_total", "Pixel updates applied to the canvas", "counter"},
+    {"fainter_pixels_rejected_total", "Pixel updates rejected by validation", "counter"},
+    {"fainter_ticks_total", "Broadcast ticks that had dirty pixels", "counter"},
+    {"fainter_dirty_pixels_total", "Dirty pixels sent, summed over ticks", "counter"},
+    {"fainter_broadcast_fanout_count", "Broadcast fan-outs", "counter"},
+    {"fainter_broadcast_fanout_seconds_sum", "Time spent sending broadcast frames to all clients", "counter"},
+    {"fainter_snapshot_encode_count", "Canvas snapshots encoded for joining clients", "counter"},
+    {"fainter_snapshot_encode_seconds_sum", "Time spent encoding canvas snapshots", "counter"},
+    {"fainter_slow_consumer_resyncs_total", "Clients over the outbound limit whose queued deltas were dropped for a snapshot resync", "counter"},
+    {"fainter_slow_consumer_disconnects_total", "Clients disconnected for exceeding the outbound limit", "counter"},
+    {"fainter_outbound_frames_discarded_total", "Queued or new frames discarded for slow clients", "counter"},
+    {"fainter_rate_limited_messages_total", "Paint messages dropped by the per-connection token bucket", "counter"},
+    {"fainter_rate_limited_ip_messages_total", "Paint messages dropped by the per-IP token bucket", "counter"},
+    {"fainter_rate_limit_disconnects_total", "Connections closed for repeatedly exceeding the message rate limit", "counter"},
+    {"fainter_handshake_timeouts_total", "Connections closed for not completing the WebSocket upgrade in time", "counter"},
+    {"fainter_idle_timeouts_total", "Idle HTTP keep-alive and WebSocket connections closed", "counter"},
+    {"fainter_pings_sent_total", "WebSocket pings sent to quiet clients", "counter"},
+    {"fainter_ping_timeouts_total", "WebSocket connections closed for not answering a ping", "counter"},
+    {"fainter_zerocopy_sends_total", "Large frame sends issued with MSG_ZEROCOPY", "counter"},
+    {"fainter_zerocopy_bytes_total", "Bytes sent with MSG_ZEROCOPY", "counter"},
+    {"fainter_zerocopy_copied_total", "MSG_ZEROCOPY sends the kernel completed by copying", "counter"},
+    {"fainter_zerocopy_fallbacks_total", "Large frame sends copied because MSG_ZEROCOPY returned ENOBUFS", "counter"},
+};
+
+// 게이지 이름, 설명 (GaugeId 순서와 같아야 한다)
+static const struct {
+    const char *name;
+    const char *help;
+} gauge_info[GAUGE_COUNT] = {
+    {"fainter_dirty_pixels_last_tick", "Dirty pixels in the most recent tick"},
+    {"fainter_outbound_queued_bytes", "Bytes waiting in per-client outbound queues"},
+};
+
+// 히스토그램 이름, 설명 (HistogramId 순서와 같아야 한다)
+static const struct {
+    const char *name;
+    const char *help;
+} histogram_info[HIST_COUNT] = {
+    {"fainter_pixel_queue_wait_seconds", "Socket read to canvas thread dequeue for pixel messages"},
+    {"fainter_pixel_apply_seconds", "Time to apply one pixel message to the canvas"},
+    {"fainter_pixel_tick_wait_seconds", "Pixel applied to the start of the broadcast tick"},
+    {"fainter_broadcast_fanout_seconds", "Time to send one broadcast frame to every client"},
+    {"fainter_paint_to_broadcast_seconds", "Socket read of the oldest pixel in a tick to the last broadcast send"},
+};
+
+static const double histogram_quantiles[] = {0.5, 0.99, 0.999};
+
+MetricsShard *metrics_thread_shard(void) {
+
+    MetricsShard *shard = (MetricsShard *)aligned_alloc(64, sizeof(MetricsShard));
+    if (shard == NULL) {
+        LOG_ERROR("메트릭 메모리 할당 실패");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        atomic_init(&shard->values[i], 0);
+    }
+    for (int i = 0; i < HIST_COUNT; i++) {
+        histogram_init(&shard->histograms[i]);
+    }
+
+    pthread_mutex_lock(&shards_lock);
+    shard->next = shards;
+    shards = shard;
+    pthread_mutex_unlock(&shards_lock);
+
+    metrics_local_shard = shard;
+    return shard;
+}
+
+unsigned long metrics_total(MetricId id) {
+
+    unsigned long total = 0;
+    pthread_mutex_lock(&shards_lock);
+    for (MetricsShard *shard = shards; shard != NULL; shard = shard->next) {
+        total += atomic_load_explicit(&shard->values[id], memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&shards_lock);
+    return total;
+}
+
+const char *metrics_counter_name(MetricId id) {
+    return metric_info[id].name;
+}
+
+void metrics_set_gauge(GaugeId id, unsigned long value) {
+    atomic_store_explicit(&gauges[id], value, memory_order_relaxed);
+}
+
+unsigned long metrics_gauge(GaugeId id) {
+    return atomic_load_explicit(&gauges[id], memory_order_relaxed);
+}
+
+const char *metrics_gauge_name(GaugeId id) {
+    return gauge_info[id].name;
+}
+
+void metrics_record(HistogramId id, unsigned long ns) {
+    MetricsShard *shard = metrics_local_shard;
+    if (shard == NULL) {
+        shard = metrics_thread_shard();
+    }
+    histogram_record_owned(&shard->histograms[id], ns);
+}
+
+void metrics_histogram(HistogramId id, Histogram *merged) {
+
+    histogram_init(merged);
+    pthread_mutex_lock(&shards_lock);
+    for (MetricsShard *shard = shards; shard != NULL; shard = shard->next) {
+        histogram_merge(merged, &shard->histograms[id]);
+    }
+    pthread_mutex_unlock(&shards_lock);
+}
+
+const char *metrics_histogram_name(HistogramId id) {
+    return histogram_info[id].name;
+}
+
+void metrics_register_queue(TaskQueue *queue) {
+    int index = atomic_fetch_add(&queue_count, 1);
+    if (index < METRICS_MAX_QUEUES) {
+        queues[index] = queue;
+    }
+}
+
+int metrics_queue_count(void) {
+    int count = atomic_load(&queue_count);
+    return count < METRICS_MAX_QUEUES ? count : METRICS_MAX_QUEUES;
+}
+
+TaskQueue *metrics_queue(int index) {
+    return queues[index];
+}
+
+unsigned long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+// 버퍼 끝을 넘지 않게 이어 쓰기
+size_t metrics_append(char *buf, size_t size, size_t offset, const char *format, ...) {
+    if (offset >= size) {
+        return offset;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + offset, size - offset, format, args);
+    va_end(args);
+    return n < 0 ? offset : offset + n;
+}
+
+size_t metrics_render(char *buf, size_t size) {
+
+    size_t offset = 0;
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        unsigned long value = metrics_total(id);
+        offset = metrics_append(buf, size, offset, "# HELP %s %s\n# TYPE %s %s\n",
+                        metric_info[id].name, metric_info[id].help, metric_info[id].name, metric_info[id].type);
+        // 시간 합계는 ns로 모으고 초 단위로 노출
+        if (id == METRIC_BROADCAST_FANOUT_NS || id == METRIC_SNAPSHOT_ENCODE_NS) {
+            offset = metrics_append(buf, size, offset, "%s %.9f\n", metric_info[id].name, value / 1e9);
+        } else {
+            offset = metrics_append(buf, size, offset, "%s %lu\n", metric_info[id].name, value);
+        }
+    }
+
+    for (int id = 0; id < GAUGE_COUNT; id++) {
+        offset = metrics_append(buf, size, offset, "# HELP %s %s\n# TYPE %s gauge\n%s %lu\n",
+                        gauge_info[id].name, gauge_info[id].help, gauge_info[id].name,
+                        gauge_info[id].name, metrics_gauge(id));
+    }
+
+    // 지연 시간 분포 (Prometheus summary), 스레드별 분포를 합쳐서
+    Histogram merged;
+    Histogram *histogram = &merged;
+    for (int id = 0; id < HIST_COUNT; id++) {
+        metrics_histogram(id, histogram);
+        offset = metrics_append(buf, size, offset, "# HELP %s %s\n# TYPE %s summary\n",
+                        histogram_info[id].name, histogram_info[id].help, histogram_info[id].name);
+        for (size_t q = 0; q < sizeof(histogram_quantiles) / sizeof(histogram_quantiles[0]); q++) {
+            offset = metrics_append(buf, size, offset, "%s{quantile=\"%g\"} %.9f\n", histogram_info[id].name,
+                            histogram_quantiles[q], histogram_percentile(histogram, histogram_quantiles[q]) / 1e9);
+        }
+        offset = metrics_append(buf, size, offset, "%s_sum %.9f\n%s_count %lu\n",
+                        histogram_info[id].name, atomic_load(&histogram->sum) / 1e9,
+                        histogram_info[id].name, atomic_load(&histogram->total));
+    }
+
+    // Task Queue 별 깊이, 용량, 누적 push/drop
+    int count = metrics_queue_count();
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_depth Tasks waiting in the queue\n# TYPE fainter_queue_depth gauge\n");
+    for (int i = 0; i < count; i++) {
+        offset = metrics_append(buf, size, offset, "fainter_queue_depth{queue=\"%s\"} %d\n",
+                        queues[i]->name, task_queue_depth(queues[i]));
+    }
+    // 레인별 깊이와 대기 시간 (push -> pop)
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_lane_depth Tasks waiting in one priority lane\n"
+                    "# TYPE fainter_queue_lane_depth gauge\n");
+    for (int i = 0; i < count; i++) {
+        for (int lane = 0; lane < TASK_LANE_COUNT; lane++) {
+            offset = metrics_append(buf, size, offset, "fainter_queue_lane_depth{queue=\"%s\",lane=\"%s\"} %d\n",
+                            queues[i]->name, task_lane_name(lane), task_queue_lane_depth(queues[i], lane));
+        }
+    }
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_wait_seconds Time a task waits in its lane before the owner thread pops it\n"
+                    "# TYPE fainter_queue_wait_seconds summary\n");
+    for (int i = 0; i < count; i++) {
+        for (int lane = 0; lane < TASK_LANE_COUNT; lane++) {
+            Histogram *wait = &queues[i]->lanes[lane].wait;
+            for (size_t q = 0; q < sizeof(histogram_quantiles) / sizeof(histogram_quantiles[0]); q++) {
+                offset = metrics_append(buf, size, offset, "fainter_queue_wait_seconds{queue=\"%s\",lane=\"%s\",quantile=\"%g\"} %.9f\n",
+                                queues[i]->name, task_lane_name(lane), histogram_quantiles[q],
+                                histogram_percentile(wait, histogram_quantiles[q]) / 1e9);
+            }
+            offset = metrics_append(buf, size, offset,
+                            "fainter_queue_wait_seconds_sum{queue=\"%s\",lane=\"%s\"} %.9f\n"
+                            "fainter_queue_wait_seconds_count{queue=\"%s\",lane=\"%s\"} %lu\n",
+                            queues[i]->name, task_lane_name(lane), atomic_load(&wait->sum) / 1e9,
+                            queues[i]->name, task_lane_name(lane), atomic_load(&wait->total));
+        }
+    }
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_capacity Queue capacity per lane\n# TYPE fainter_queue_capacity gauge\n");
+    for (int i = 0; i < count; i++) {
+        offset = metrics_append(buf, size, offset, "fainter_queue_capacity{queue=\"%s\"} %d\n",
+                        queues[i]->name, queues[i]->size - 1);
+    }
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_pushed_total Tasks pushed\n# TYPE fainter_queue_pushed_total counter\n");
+    for (int i = 0; i < count; i++) {
+        offset = metrics_append(buf, size, offset, "fainter_queue_pushed_total{queue=\"%s\"} %lu\n",
+                        queues[i]->name, atomic_load(&queues[i]->pushed));
+    }
+    offset = metrics_append(buf, size, offset,
+                    "# HELP fainter_queue_dropped_total Tasks dropped because the queue was full\n"
+                    "# TYPE fainter_queue_dropped_total counter\n");
+    for (int i = 0; i < count; i++) {
+        offset = metrics_append(buf, size, offset, "fainter_queue_dropped_total{queue=\"%s\"} %lu\n",
+                        queues[i]->name, atomic_load(&queues[i]->dropped));
+    }
+
+    return offset < size ? offset : size;
+}
@@ -0,0 +1,117 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "task_queue.h"
+#include "histogram.h"
+
+#define METRICS_MAX_QUEUES 8            // /metrics에 노출할 수 있는 Task Queue 수
+#define METRICS_BUFFER_SIZE (16 * 1024) // /metrics 응답 버퍼 크기
+
+// 누적 카운터 종류 (스레드별로 따로 더하고, 읽을 때 합산)
+typedef enum {
+    METRIC_EPOLL_WAKEUPS,           // epoll_wait 반환 횟수
+    METRIC_EPOLL_EVENTS,            // epoll 이벤트 수
+    METRIC_BYTES_IN,                // 소켓에서 읽은 바이트
+    METRIC_BYTES_OUT,               // 소켓으로 보낸 바이트
+    METRIC_HTTP_REQUESTS,           // 처리한 HTTP 요청 수
+    METRIC_PIXELS_APPLIED,          // 캔버스에 반영된 픽셀 수
+    METRIC_PIXELS_REJECTED,         // 잘못된 좌표/색상으로 버려진 픽셀 수
+    METRIC_TICKS,                   // 브로드캐스트 틱 수 (변경이 있었던 틱)
+    METRIC_DIRTY_PIXELS,            // 틱마다 보낸 변경 픽셀 수 합계
+    METRIC_BROADCASTS,              // 브로드캐스트 팬아웃 횟수
+    METRIC_BROADCAST_FANOUT_NS,     // 브로드캐스트 팬아웃 소요 시간 합계 (ns)
+    METRIC_SNAPSHOTS,               // 초기 캔버스 스냅샷 인코딩 횟수
+    METRIC_SNAPSHOT_ENCODE_NS,      // 스냅샷 인코딩 소요 시간 합계 (ns)
+    METRIC_SLOW_RESYNCS,            // 송신 대기열 상한을 넘어 변경분을 버리고 스냅샷으로 다시 맞춘 횟수
+    METRIC_SLOW_DISCONNECTS,        // 송신 대기열 상한을 넘어 끊은 연결 수
+    METRIC_FRAMES_DISCARDED,        // 느린 클라이언트에게 보내지 않고 버린 frame 수
+    METRIC_RATE_LIMITED,            // 연결별 속도 제한으로 버린 페인트 메세지 수
+    METRIC_RATE_LIMITED_IP,         // IP별 속도 제한으로 버린 페인트 메세지 수
+    METRIC_RATE_LIMIT_DISCONNECTS,  // 속도 제한을 계속 넘겨서 끊은 연결 수
+    METRIC_HANDSHAKE_TIMEOUTS,      // 제한 시간 안에 WebSocket 업그레이드를 끝내지 않아 끊은 연결 수
+    METRIC_IDLE_TIMEOUTS,           // 유휴 제한 시간을 넘겨 끊은 연결 수 (HTTP keep-alive, WebSocket)
+    METRIC_PINGS_SENT,              // 보낸 ping 수
+    METRIC_PING_TIMEOUTS,           // ping에 답이 없어 끊은 연결 수
+    METRIC_ZEROCOPY_SENDS,          // MSG_ZEROCOPY로 보낸 send 수
+    METRIC_ZEROCOPY_BYTES,          // MSG_ZEROCOPY로 보낸 바이트
+    METRIC_ZEROCOPY_COPIED,         // 커널이 결국 복사했다고 알린 MSG_ZEROCOPY send 수 (루프백 등)
+    METRIC_ZEROCOPY_FALLBACKS,      // 페이지 고정 한도(ENOBUFS)로 복사해서 보낸 send 수
+    METRIC_COUNT
+} MetricId;
+
+// 지연 시간 히스토그램 (ns로 기록하고 /metrics에서 초 단위 p50/p99/p999로 노출)
+typedef enum {
+    HIST_QUEUE_WAIT,                // 소켓 수신 -> 캔버스 스레드가 꺼낼 때까지
+    HIST_APPLY,                     // 픽셀 메세지 하나를 캔버스에 반영하는 시간
+    HIST_TICK_WAIT,                 // 픽셀 반영 -> 브로드캐스트 틱까지
+    HIST_FANOUT,                    // 브로드캐스트 프레임을 모든 클라이언트에 보내는 시간
+    HIST_END_TO_END,                // 틱에서 가장 오래된 픽셀의 수신 -> 마지막 send
+    HIST_COUNT
+} HistogramId;
+
+// 스레드 하나가 가진 카운터와 히스토그램 묶음 (캐시 라인 단위로 분리해서 스레드 간 경합이 없다)
+typedef struct MetricsShard {
+    _Alignas(64) atomic_ulong values[METRIC_COUNT];
+    Histogram histograms[HIST_COUNT];
+    struct MetricsShard *next;
+} MetricsShard;
+
+// 현재 스레드의 카운터 묶음 (처음 호출 시 등록)
+extern __thread MetricsShard *metrics_local_shard;
+MetricsShard *metrics_thread_shard(void);
+
+// 현재 스레드의 카운터에 값을 더한다 (소유 스레드만 쓰므로 원자적 덧셈이 필요 없다)
+static inline void metrics_add(MetricId id, unsigned long value) {
+    MetricsShard *shard = metrics_local_shard;
+    if (shard == NULL) {
+        shard = metrics_thread_shard();
+    }
+    atomic_store_explicit(&shard->values[id],
+                          atomic_load_explicit(&shard->values[id], memory_order_relaxed) + value,
+                          memory_order_relaxed);
+}
+
+// 모든 스레드의 카운터 합계
+unsigned long metrics_total(MetricId id);
+
+// 카운터 이름 (Prometheus 이름, 통계 CSV 열 이름으로도 쓴다)
+const char *metrics_counter_name(MetricId id);
+
+// 마지막 값만 의미 있는 게이지
+typedef enum {
+    GAUGE_DIRTY_PIXELS_LAST_TICK,   // 마지막 틱의 변경 픽셀 수
+    GAUGE_OUTBOUND_BYTES,           // 모든 클라이언트의 송신 대기열에 남은 바이트
+    GAUGE_COUNT
+} GaugeId;
+
+void metrics_set_gauge(GaugeId id, unsigned long value);
+unsigned long metrics_gauge(GaugeId id);
+const char *metrics_gauge_name(GaugeId id);
+
+// 현재 스레드의 히스토그램에 기록
+void metrics_record(HistogramId id, unsigned long ns);
+
+// 모든 스레드의 누적 히스토그램을 합친 스냅샷 (통계 샘플러가 구간별 차이를 계산할 때 사용)
+void metrics_histogram(HistogramId id, Histogram *merged);
+const char *metrics_histogram_name(HistogramId id);
+
+// 깊이/드롭 수를 노출할 Task Queue 등록
+void metrics_register_queue(TaskQueue *queue);
+
+// 등록된 Task Queue 수와 index번째 큐
+int metrics_queue_count(void);
+TaskQueue *metrics_queue(int index);
+
+// 단조 증가 시계 (ns)
+unsigned long monotonic_ns(void);
+
+// 버퍼 끝을 넘지 않게 printf 형식으로 이어 쓰고 새 offset 반환
+size_t metrics_append(char *buf, size_t size, size_t offset, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+// Prometheus 텍스트 형식으로 출력, 쓴 길이를 반환 (ClientManager 상태는 호출자가 덧붙인다)
+size_t metrics_render(char *buf, size_t size);
+
+#endif // METRICS_H
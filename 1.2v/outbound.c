@@ -0,0 +1,270 @@
+#include "outbound.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include "metrics.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+SharedFrame *shared_frame_create(const uint8_t *data, size_t len, int refs) {
+    SharedFrame *frame = malloc(sizeof(SharedFrame) + len);
+    if (frame == NULL) {
+        return NULL;
+    }
+    atomic_init(&frame->refs, refs);
+    frame->len = len;
+    memcpy(frame->data, data, len);
+    return frame;
+}
+
+void shared_frame_retain(SharedFrame *frame) {
+    atomic_fetch_add(&frame->refs, 1);
+}
+
+void shared_frame_release(SharedFrame *frame) {
+    if (atomic_fetch_sub(&frame->refs, 1) == 1) {
+        free(frame);
+    }
+}
+
+void outbound_init(OutboundQueue *queue) {
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->offset = 0;
+    queue->bytes = 0;
+    queue->zerocopy_threshold = 0;
+    queue->zerocopy_next_id = 0;
+    queue->zerocopy_head = NULL;
+    queue->zerocopy_tail = NULL;
+}
+
+bool outbound_enable_zerocopy(OutboundQueue *queue, int fd, size_t threshold) {
+
+    int one = 1;
+    // TCP가 아닌 소켓(시뮬레이션의 socketpair 등)은 EOPNOTSUPP
+    if (threshold == 0 || setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == -1) {
+        return false;
+    }
+    queue->zerocopy_threshold = threshold;
+    return true;
+}
+
+// 커널이 frame 페이지를 놓을 때까지 참조를 붙잡는다
+static void zerocopy_track(OutboundQueue *queue, SharedFrame *frame) {
+
+    ZerocopySend *entry = malloc(sizeof(ZerocopySend));
+    if (entry == NULL) {
+        // 놓칠 수는 없다: 참조를 하나 흘려서 frame을 살려 둔다
+        shared_frame_retain(frame);
+        queue->zerocopy_next_id++;
+        return;
+    }
+    shared_frame_retain(frame);
+    entry->frame = frame;
+    entry->id = queue->zerocopy_next_id++;
+    entry->next = NULL;
+    if (queue->zerocopy_tail == NULL) {
+        queue->zerocopy_head = entry;
+    } else {
+        queue->zerocopy_tail->next = entry;
+    }
+    queue->zerocopy_tail = entry;
+}
+
+ssize_t outbound_send(OutboundQueue *queue, int fd, SharedFrame *frame, size_t offset) {
+
+    size_t len = frame->len - offset;
+    if (queue->zerocopy_threshold == 0 || len < queue->zerocopy_threshold) {
+        return send(fd, frame->data + offset, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+
+    ssize_t n = send(fd, frame->data + offset, len, MSG_NOSIGNAL | MSG_DONTWAIT | MSG_ZEROCOPY);
+    if (n > 0) {
+        // 보낸 바이트가 있는 send마다 번호 하나 (0바이트로 끝난 send는 커널이 번호를 되돌린다)
+        zerocopy_track(queue, frame);
+        metrics_add(METRIC_ZEROCOPY_SENDS, 1);
+        metrics_add(METRIC_ZEROCOPY_BYTES, n);
+        return n;
+    }
+    if (n == -1 && errno == ENOBUFS) {
+        // 고정할 수 있는 페이지/optmem 한도: 이번 send는 복사로
+        metrics_add(METRIC_ZEROCOPY_FALLBACKS, 1);
+        return send(fd, frame->data + offset, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+    return n;
+}
+
+// 완료된 번호 범위 [lo, hi]의 send가 붙잡고 있던 frame을 놓는다 (번호는 32비트로 돌아간다)
+static void zerocopy_release(OutboundQueue *queue, uint32_t lo, uint32_t hi) {
+
+    ZerocopySend **link = &queue->zerocopy_head;
+    ZerocopySend *previous = NULL;
+    while (*link != NULL) {
+        ZerocopySend *entry = *link;
+        if (entry->id - lo <= hi - lo) {
+            *link = entry->next;
+            shared_frame_release(entry->frame);
+            free(entry);
+        } else {
+            previous = entry;
+            link = &entry->next;
+        }
+    }
+    queue->zerocopy_tail = previous;
+}
+
+int outbound_zerocopy_complete(OutboundQueue *queue, int fd) {
+
+    // MSG_ZEROCOPY를 켜지 않은 소켓은 읽을 완료 알림이 없다 (AF_UNIX는 MSG_ERRQUEUE를 무시하고 데이터를 읽는다)
+    if (queue->zerocopy_threshold == 0) {
+        return 0;
+    }
+
+    int count = 0;
+    while (1) {
+        char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + 64];
+        struct msghdr msg = {0};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return count;   // EAGAIN: 오류 큐가 비었다
+        }
+        // 오류 큐에서 읽은 것이 아니면 (상대가 닫아 0을 받는 경우 등) 더 읽을 알림이 없다
+        if (!(msg.msg_flags & MSG_ERRQUEUE)) {
+            return count;
+        }
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            bool recverr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                           (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            if (!recverr) {
+                continue;
+            }
+            struct sock_extended_err *err = (struct sock_extended_err *)CMSG_DATA(cmsg);
+            if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0) {
+                continue;
+            }
+            // 루프백처럼 커널이 결국 복사한 경우 (이 연결은 MSG_ZEROCOPY의 이득이 없다)
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                metrics_add(METRIC_ZEROCOPY_COPIED, err->ee_data - err->ee_info + 1);
+            }
+            zerocopy_release(queue, err->ee_info, err->ee_data);
+            count++;
+        }
+    }
+}
+
+bool outbound_push(OutboundQueue *queue, SharedFrame *frame, size_t offset) {
+
+    OutboundFrame *entry = malloc(sizeof(OutboundFrame));
+    if (entry == NULL) {
+        return false;
+    }
+    shared_frame_retain(frame);
+    entry->frame = frame;
+    entry->next = NULL;
+
+    if (queue->tail == NULL) {
+        queue->head = entry;
+        queue->offset = offset;
+        queue->bytes = frame->len - offset;
+    } else {
+        queue->tail->next = entry;
+        queue->bytes += frame->len;
+    }
+    queue->tail = entry;
+    return true;
+}
+
+int outbound_discard_pending(OutboundQueue *queue) {
+
+    if (queue->head == NULL) {
+        return 0;
+    }
+
+    // 보내던 frame이 있으면 그 다음부터 버린다
+    OutboundFrame *keep = queue->offset > 0 ? queue->head : NULL;
+    OutboundFrame *entry = keep ? keep->next : queue->head;
+    int discarded = 0;
+    while (entry != NULL) {
+        OutboundFrame *next = entry->next;
+        shared_frame_release(entry->frame);
+        free(entry);
+        entry = next;
+        discarded++;
+    }
+
+    if (keep) {
+        keep->next = NULL;
+        queue->tail = keep;
+        queue->bytes = keep->frame->len - queue->offset;
+    } else {
+        // MSG_ZEROCOPY 상태는 그대로 (보낸 frame은 아직 커널이 물고 있을 수 있다)
+        queue->head = NULL;
+        queue->tail = NULL;
+        queue->offset = 0;
+        queue->bytes = 0;
+    }
+    return discarded;
+}
+
+int outbound_flush(OutboundQueue *queue, int fd, size_t *sent) {
+
+    while (queue->head != NULL) {
+        SharedFrame *frame = queue->head->frame;
+        ssize_t n = outbound_send(queue, fd, frame, queue->offset);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+        }
+        *sent += n;
+        queue->offset += n;
+        queue->bytes -= n;
+
+        // frame 하나를 다 보냈으면 다음 frame으로
+        if (queue->offset == frame->len) {
+            OutboundFrame *done = queue->head;
+            queue->head = done->next;
+            if (queue->head == NULL) {
+                queue->tail = NULL;
+            }
+            queue->offset = 0;
+            shared_frame_release(done->frame);
+            free(done);
+        }
+    }
+    return 0;
+}
+
+void outbound_clear(OutboundQueue *queue) {
+
+    OutboundFrame *entry = queue->head;
+    while (entry != NULL) {
+        OutboundFrame *next = entry->next;
+        shared_frame_release(entry->frame);
+        free(entry);
+        entry = next;
+    }
+    ZerocopySend *pending = queue->zerocopy_head;
+    while (pending != NULL) {
+        ZerocopySend *next = pending->next;
+        shared_frame_release(pending->frame);
+        free(pending);
+        pending = next;
+    }
+    outbound_init(queue);
+}
@@ -0,0 +1,84 @@
+#ifndef OUTBOUND_H
+#define OUTBOUND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+// 클라이언트별 송신 대기열
+// 소켓 송신 버퍼가 가득 차서 다 보내지 못한 frame을 순서대로 쌓아두고, 쓰기 가능(EPOLLOUT)해지면 이어서 보낸다.
+// frame은 참조 카운트로 공유한다 (브로드캐스트 frame 하나를 느린 클라이언트 여럿이 복사 없이 나눠 쓴다).
+// 큰 frame(초기 스냅샷 등)은 MSG_ZEROCOPY로 보낸다: 커널이 복사하지 않고 frame 페이지를 직접 물고 있으므로
+// 소켓 오류 큐로 완료 알림이 올 때까지 보낸 frame의 참조를 붙잡아 둔다 (outbound_zerocopy_complete).
+
+#define OUTBOUND_DEFAULT_LIMIT (4 * 1024 * 1024)    // 클라이언트당 대기 바이트 상한, FAINTER_OUTBOUND_LIMIT 로 변경
+#define OUTBOUND_ZEROCOPY_THRESHOLD (128 * 1024)    // 이 크기 이상은 MSG_ZEROCOPY, FAINTER_ZEROCOPY_THRESHOLD 로 변경 (0이면 끔)
+
+// 여러 클라이언트에게 같은 내용을 보내는 frame (마지막으로 보낸 쪽이 해제)
+typedef struct {
+    atomic_int refs;
+    size_t len;
+    uint8_t data[];
+} SharedFrame;
+
+// data를 복사해서 refs개의 참조를 가진 frame 생성 (실패 시 NULL)
+SharedFrame *shared_frame_create(const uint8_t *data, size_t len, int refs);
+void shared_frame_retain(SharedFrame *frame);
+void shared_frame_release(SharedFrame *frame);
+
+// 상한을 넘긴 느린 클라이언트 처리 방식 (FAINTER_SLOW_POLICY=resync|drop)
+typedef enum {
+    SLOW_CONSUMER_RESYNC,       // 쌓인 변경분을 버리고, 밀린 바이트를 다 보내면 새 스냅샷으로 다시 맞춘다 (기본)
+    SLOW_CONSUMER_DROP          // 연결을 끊는다
+} SlowConsumerPolicy;
+
+typedef struct OutboundFrame {
+    SharedFrame *frame;
+    struct OutboundFrame *next;
+} OutboundFrame;
+
+// MSG_ZEROCOPY로 보냈지만 아직 완료 알림이 오지 않은 send 한 번
+typedef struct ZerocopySend {
+    SharedFrame *frame;
+    uint32_t id;                // 소켓별 send 번호 (완료 알림의 범위와 비교)
+    struct ZerocopySend *next;
+} ZerocopySend;
+
+typedef struct {
+    OutboundFrame *head;
+    OutboundFrame *tail;
+    size_t offset;              // head frame에서 이미 보낸 바이트
+    size_t bytes;               // 아직 보내지 못한 바이트
+    size_t zerocopy_threshold;  // 남은 바이트가 이 이상이면 MSG_ZEROCOPY (0: 소켓이 지원하지 않거나 끔)
+    uint32_t zerocopy_next_id;  // 다음 MSG_ZEROCOPY send가 받을 번호 (커널과 같은 방식으로 센다)
+    ZerocopySend *zerocopy_head;    // 완료를 기다리는 send (번호 순)
+    ZerocopySend *zerocopy_tail;
+} OutboundQueue;
+
+void outbound_init(OutboundQueue *queue);
+
+// 소켓에 SO_ZEROCOPY를 켜고 threshold 이상인 send를 MSG_ZEROCOPY로 보낸다 (지원하지 않는 소켓이면 false, 복사 전송 유지)
+bool outbound_enable_zerocopy(OutboundQueue *queue, int fd, size_t threshold);
+
+// frame을 offset부터 한 번 send (큰 frame은 MSG_ZEROCOPY, send와 같은 반환값)
+ssize_t outbound_send(OutboundQueue *queue, int fd, SharedFrame *frame, size_t offset);
+
+// 소켓 오류 큐의 완료 알림을 모두 읽고 끝난 send의 frame 참조를 놓는다 (EPOLLERR)
+// 반환: 읽은 알림 수, 오류 큐가 비어 있었으면 0
+int outbound_zerocopy_complete(OutboundQueue *queue, int fd);
+
+// frame을 offset 바이트부터 보내도록 뒤에 추가 (참조 하나를 가져간다, offset은 빈 대기열에서만 의미가 있다)
+bool outbound_push(OutboundQueue *queue, SharedFrame *frame, size_t offset);
+
+// 아직 보내기 시작하지 않은 frame을 모두 버리고 버린 수를 반환 (보내던 frame은 중간에 끊을 수 없어서 남긴다)
+int outbound_discard_pending(OutboundQueue *queue);
+
+// EAGAIN이 날 때까지 보낸다: 0 다 보냄, 1 남음, -1 소켓 오류 (sent에 보낸 바이트를 더한다)
+int outbound_flush(OutboundQueue *queue, int fd, size_t *sent);
+
+// 모두 버린다 (연결 종료, 완료를 기다리던 frame도 놓는다: 닫는 연결이라 아직 나가지 않은 바이트가 바뀌어도 상관없다)
+void outbound_clear(OutboundQueue *queue);
+
+#endif // OUTBOUND_H
@@ -1,6 +1,9 @@
 #include "parsing_json.h"
 #include "canvas.h"
 #include <cjson/cJSON.h>
+#include "metrics.h"
+#include "log.h"
+#include "recorder.h"
 
 // 유효한 좌표인지 확인
 bool is_valid_coordinate(int x, int y, int width, int height) {
@@ -26,14 +29,14 @@ bool is_valid_hex_color(const char *color) {
 Pixel *parse_pixel_json(const char *json_str) {
     cJSON *json = cJSON_Parse(json_str);
     if (json == NULL) {
-        fprintf(stderr, "Invalid JSON: %s\n", json_str);
+        LOG_WARN("Invalid JSON: %s", json_str);
         return NULL;
     }
 
     // "pixel" 객체 찾기
     cJSON *pixel_item = cJSON_GetObjectItem(json, "pixel");
     if (!cJSON_IsObject(pixel_item)) {
-        fprintf(stderr, "Invalid pixel object in JSON: %s\n", json_str);
+        LOG_WARN("Invalid pixel object in JSON: %s", json_str);
         cJSON_Delete(json);
         return NULL;
     }
@@ -44,14 +47,14 @@ Pixel *parse_pixel_json(const char *json_str) {
     cJSON *color_item = cJSON_GetObjectItem(pixel_item, "color");
 
     if (!cJSON_IsNumber(x_item) || !cJSON_IsNumber(y_item) || !cJSON_IsString(color_item)) {
-        fprintf(stderr, "Invalid pixel data in JSON: %s\n", json_str);
+        LOG_WARN("Invalid pixel data in JSON: %s", json_str);
         cJSON_Delete(json);
         return NULL;
     }
 
     Pixel *parsed_pixel = malloc(sizeof(Pixel));
     if (parsed_pixel == NULL) {
-        fprintf(stderr, "Failed to allocate memory for Pixel.\n");
+        LOG_ERROR("Failed to allocate memory for Pixel.");
         cJSON_Delete(json);
         return NULL;
     }
@@ -63,7 +66,7 @@ Pixel *parse_pixel_json(const char *json_str) {
     return parsed_pixel;
 }
 
-void process_json(Canvas *canvas, const char *buffer, size_t length) {
+void process_json(Canvas *canvas, int client, const char *buffer, size_t length, unsigned long recv_ns) {
 
     size_t start = 0;  // JSON 객체 시작 위치
     int brace_count = 0; // 중괄호 개수 추적
@@ -99,6 +102,7 @@ void process_json(Canvas *canvas, const char *buffer, size_t length) {
                         //printf("Update Pixel: x=%d, y=%d, color=%d\n", pixel->x, pixel->y, pixel->color);
 
                         // 픽셀 업데이트 처리
+                        metrics_add(METRIC_PIXELS_APPLIED, 1);
                         int index = pixel->y * canvas->canvas_width + pixel->x;
                         strcpy(canvas->pixels[index].color, pixel->color);
 
@@ -116,8 +120,14 @@ void process_json(Canvas *canvas, const char *buffer, size_t length) {
                             // 이미 존재하면 색상 업데이트
                             
                         }
+                        // 브로드캐스트되는 건 마지막 업데이트이므로 시각도 덮어쓴다
+                        p->recv_ns = recv_ns;
+                        p->applied_ns = monotonic_ns();
+
+                        recorder_pixel(client, recv_ns, pixel->x, pixel->y, pixel->color);
                     } else {
-                        fprintf(stderr, "Invalid Pixel: x=%d, y=%d, color=%s\n", pixel->x, pixel->y, pixel->color);
+                        metrics_add(METRIC_PIXELS_REJECTED, 1);
+                        LOG_WARN("Invalid Pixel: x=%d, y=%d, color=%s", pixel->x, pixel->y, pixel->color);
                     }
                     free(pixel);
                 }
@@ -4,7 +4,7 @@
 
 #include "canvas.h"
 
-void process_json(Canvas *canvas, const char *buffer, size_t length);
+void process_json(Canvas *canvas, int client, const char *buffer, size_t length, unsigned long recv_ns);
 Pixel *parse_pixel_json(const char *json_str);
 bool is_valid_hex_color(const char *color);
 bool is_valid_coordinate(int x, int y, int width, int height);
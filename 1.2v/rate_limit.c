@@ -0,0 +1,210 @@
+#include "rate_limit.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics.h"
+#include "log.h"
+
+// CM이 쓰고 메인 스레드가 읽는 연결 등록 정보
+typedef struct {
+    atomic_uint gen;            // 등록할 때마다 증가 (fd 재사용 구분)
+    atomic_uint ip;
+} RateRegistration;
+
+// 메인 스레드만 쓰는 연결 상태
+typedef struct {
+    unsigned long tat;          // 이 시각보다 tolerance 이상 일찍 온 메세지는 초과
+    unsigned int gen;
+    uint32_t ip;
+    int ip_slot;                // IP 버킷 위치 (-1: 아직 못 찾음)
+    unsigned int dropped;       // 이 연결에서 버린 메세지 수
+    bool closing;               // 끊기로 했다 (나머지는 버린다)
+} RateConn;
+
+typedef struct {
+    uint32_t ip;                // 0이면 빈 칸
+    unsigned long tat;
+} RateIp;
+
+static bool enabled = false;
+static unsigned long interval_ns = 0;       // 메세지 하나가 쓰는 시간 (1 / 초당 메세지)
+static unsigned long tolerance_ns = 0;      // (버스트 - 1) * interval
+static unsigned long ip_interval_ns = 0;
+static unsigned long ip_tolerance_ns = 0;
+static unsigned int disconnect_after = 0;
+
+static int max_fds = 0;
+static RateRegistration *registrations = NULL;
+static RateConn *conns = NULL;
+static RateIp ip_buckets[RATE_LIMIT_IP_SLOTS];
+
+static double env_double(const char *name, double fallback) {
+    const char *value = getenv(name);
+    return (value != NULL && atof(value) > 0) ? atof(value) : fallback;
+}
+
+void rate_limit_init(void) {
+
+    double rate = env_double("FAINTER_RATE_LIMIT", 0);
+    double ip_rate = env_double("FAINTER_RATE_LIMIT_IP", 0);
+    rate_limit_configure(rate, env_double("FAINTER_RATE_BURST", rate),
+                         ip_rate, env_double("FAINTER_RATE_BURST_IP", ip_rate),
+                         (unsigned int)env_double("FAINTER_RATE_DISCONNECT", 0));
+    if (enabled) {
+        LOG_INFO("메세지 속도 제한: 연결당 초당 %.1f개 (버스트 %.0f), IP당 초당 %.1f개 (버스트 %.0f), %u개 버리면 종료",
+                 rate, env_double("FAINTER_RATE_BURST", rate), ip_rate, env_double("FAINTER_RATE_BURST_IP", ip_rate),
+                 disconnect_after);
+    }
+}
+
+void rate_limit_configure(double rate, double burst, double ip_rate, double ip_burst, unsigned int disconnect) {
+
+    interval_ns = rate > 0 ? (unsigned long)(1e9 / rate) : 0;
+    tolerance_ns = (burst > 1 ? (unsigned long)(burst - 1) : 0) * interval_ns;
+    ip_interval_ns = ip_rate > 0 ? (unsigned long)(1e9 / ip_rate) : 0;
+    ip_tolerance_ns = (ip_burst > 1 ? (unsigned long)(ip_burst - 1) : 0) * ip_interval_ns;
+    disconnect_after = disconnect;
+    memset(ip_buckets, 0, sizeof(ip_buckets));
+
+    enabled = interval_ns != 0 || ip_interval_ns != 0;
+    if (!enabled || registrations != NULL) {
+        return;
+    }
+
+    // fd로 바로 찾는다 (calloc이라 쓰지 않은 fd의 페이지는 실제로 할당되지 않는다)
+    struct rlimit limit;
+    max_fds = (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < RATE_LIMIT_MAX_FDS)
+              ? (int)limit.rlim_cur : RATE_LIMIT_MAX_FDS;
+    registrations = (RateRegistration *)calloc(max_fds, sizeof(RateRegistration));
+    conns = (RateConn *)calloc(max_fds, sizeof(RateConn));
+    if (registrations == NULL || conns == NULL) {
+        LOG_ERROR("메세지 속도 제한 메모리 할당 실패, 제한하지 않음");
+        free(registrations);
+        free(conns);
+        registrations = NULL;
+        conns = NULL;
+        enabled = false;
+    }
+}
+
+// 피어 주소를 IP 키로 (IPv6는 /64 대역 단위, 유닉스 소켓은 0)
+static uint32_t peer_ip(int fd) {
+
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr *)&addr, &addr_len) == -1) {
+        return 0;
+    }
+    uint32_t key = 0;
+    if (addr.ss_family == AF_INET) {
+        key = ntohl(((struct sockaddr_in *)&addr)->sin_addr.s_addr);
+    }
+    else if (addr.ss_family == AF_INET6) {
+        const uint8_t *bytes = ((struct sockaddr_in6 *)&addr)->sin6_addr.s6_addr;
+        uint32_t words[4];
+        memcpy(words, bytes, sizeof(words));
+        key = IN6_IS_ADDR_V4MAPPED(&((struct sockaddr_in6 *)&addr)->sin6_addr) ? ntohl(words[3])
+                                                                                : words[0] ^ (words[1] * 2654435761u);
+    }
+    return key != 0 ? key : 1;
+}
+
+void rate_limit_register(int fd) {
+    if (enabled && fd >= 0 && fd < max_fds) {
+        rate_limit_register_ip(fd, ip_interval_ns != 0 ? peer_ip(fd) : 0);
+    }
+}
+
+void rate_limit_register_ip(int fd, uint32_t ip) {
+    if (!enabled || fd < 0 || fd >= max_fds) {
+        return;
+    }
+    atomic_store_explicit(&registrations[fd].ip, ip, memory_order_relaxed);
+    atomic_fetch_add_explicit(&registrations[fd].gen, 1, memory_order_release);
+}
+
+// IP 버킷 찾기, 없으면 빈 칸이나 오래 조용한 칸을 가져온다 (가득 차면 -1: 제한하지 않는다)
+static int find_ip_slot(uint32_t ip, unsigned long now_ns) {
+
+    unsigned int start = (ip * 2654435761u) >> (32 - RATE_LIMIT_IP_BITS);
+    int reusable = -1;
+    for (int i = 0; i < RATE_LIMIT_IP_PROBES; i++) {
+        int slot = (start + i) & (RATE_LIMIT_IP_SLOTS - 1);
+        RateIp *bucket = &ip_buckets[slot];
+        if (bucket->ip == ip) {
+            return slot;
+        }
+        if (reusable == -1 && (bucket->ip == 0 || bucket->tat + RATE_LIMIT_IP_IDLE_NS < now_ns)) {
+            reusable = slot;
+        }
+    }
+    if (reusable != -1) {
+        ip_buckets[reusable].ip = ip;
+        ip_buckets[reusable].tat = 0;
+    }
+    return reusable;
+}
+
+RateVerdict rate_limit_check(int fd, unsigned long now_ns) {
+
+    if (!enabled || fd < 0 || fd >= max_fds) {
+        return RATE_ALLOW;
+    }
+
+    // CM이 다시 등록했으면 새 연결
+    RateConn *conn = &conns[fd];
+    unsigned int gen = atomic_load_explicit(&registrations[fd].gen, memory_order_acquire);
+    if (conn->gen != gen) {
+        conn->gen = gen;
+        conn->tat = 0;
+        conn->ip = atomic_load_explicit(&registrations[fd].ip, memory_order_relaxed);
+        conn->ip_slot = -1;
+        conn->dropped = 0;
+        conn->closing = false;
+    }
+    if (conn->closing) {
+        return RATE_DROP;
+    }
+
+    // 둘 다 통과해야 둘 다 쓴다 (버린 메세지는 어느 버킷도 쓰지 않는다)
+    unsigned long tat = conn->tat > now_ns ? conn->tat : now_ns;
+    if (interval_ns != 0 && tat - now_ns > tolerance_ns) {
+        metrics_add(METRIC_RATE_LIMITED, 1);
+        goto drop;
+    }
+
+    RateIp *bucket = NULL;
+    unsigned long ip_tat = 0;
+    if (ip_interval_ns != 0 && conn->ip != 0) {
+        if (conn->ip_slot == -1 || ip_buckets[conn->ip_slot].ip != conn->ip) {
+            conn->ip_slot = find_ip_slot(conn->ip, now_ns);
+        }
+        if (conn->ip_slot != -1) {
+            bucket = &ip_buckets[conn->ip_slot];
+            ip_tat = bucket->tat > now_ns ? bucket->tat : now_ns;
+            if (ip_tat - now_ns > ip_tolerance_ns) {
+                metrics_add(METRIC_RATE_LIMITED_IP, 1);
+                goto drop;
+            }
+        }
+    }
+
+    conn->tat = tat + interval_ns;
+    if (bucket != NULL) {
+        bucket->tat = ip_tat + ip_interval_ns;
+    }
+    return RATE_ALLOW;
+
+drop:
+    conn->dropped++;
+    if (disconnect_after != 0 && conn->dropped >= disconnect_after) {
+        conn->closing = true;
+        metrics_add(METRIC_RATE_LIMIT_DISCONNECTS, 1);
+        return RATE_DISCONNECT;
+    }
+    return RATE_DROP;
+}
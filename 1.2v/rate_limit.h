@@ -0,0 +1,43 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 페인트 메세지 속도 제한 (연결별, IP별 토큰 버킷)
+// 메인 스레드가 WebSocket frame을 파싱하거나 큐에 넣기 전에 검사한다. 버킷은 GCRA 형태로
+// "다음 메세지가 제시간에 오는 시각" 하나만 저장해서, 검사는 할당 없이 비교와 덧셈 몇 번이다.
+//   FAINTER_RATE_LIMIT=<초당 메세지>      연결별 (없거나 0이면 제한 없음)
+//   FAINTER_RATE_BURST=<메세지>           연결별 버스트 (기본: 초당 메세지 수)
+//   FAINTER_RATE_LIMIT_IP, FAINTER_RATE_BURST_IP   같은 IP의 연결 전체
+//   FAINTER_RATE_DISCONNECT=<메세지>      한 연결에서 이만큼 버리면 연결을 끊는다 (0이면 버리기만)
+// 연결 상태는 fd로 찾는다: CM이 등록할 때 세대 번호를 올리면 메인 스레드가 다음 메세지에서 새 연결로 초기화한다.
+
+#define RATE_LIMIT_MAX_FDS (1 << 20)      // 이보다 큰 fd는 제한하지 않는다
+#define RATE_LIMIT_IP_BITS 12
+#define RATE_LIMIT_IP_SLOTS (1 << RATE_LIMIT_IP_BITS)   // IP 버킷 수
+#define RATE_LIMIT_IP_PROBES 8            // IP 버킷을 찾을 때 살펴보는 칸 수
+#define RATE_LIMIT_IP_IDLE_NS (60UL * 1000000000UL)  // 이만큼 조용한 IP 버킷은 다른 IP가 가져간다
+
+typedef enum {
+    RATE_ALLOW,                 // 처리
+    RATE_DROP,                  // 버림
+    RATE_DISCONNECT             // 버리고 연결 종료 (연결마다 한 번)
+} RateVerdict;
+
+// 환경 변수로 설정 (CM 초기화 전에)
+void rate_limit_init(void);
+
+// 직접 설정 (초당 0이면 끔, 벤치마크용)
+void rate_limit_configure(double rate, double burst, double ip_rate, double ip_burst, unsigned int disconnect_after);
+
+// CM: 새 연결 등록 (epoll 등록 전에), 피어 주소로 IP 키를 정한다
+void rate_limit_register(int fd);
+
+// rate_limit_register와 같지만 IP 키를 직접 준다 (0이면 IP 제한 없음, 벤치마크용)
+void rate_limit_register_ip(int fd, uint32_t ip);
+
+// 메인 스레드: 페인트 메세지 하나 검사 (now_ns: 수신 시각)
+RateVerdict rate_limit_check(int fd, unsigned long now_ns);
+
+#endif // RATE_LIMIT_H
@@ -0,0 +1,125 @@
+#include "recorder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "include/uthash.h"
+#include "metrics.h"
+#include "log.h"
+
+#define RECORD_BUFFER_SIZE (1024 * 1024)
+
+// 소켓 fd -> 현재 접속 번호
+typedef struct {
+    int fd;
+    uint32_t conn_id;
+    UT_hash_handle hh;
+} RecordConnection;
+
+static FILE *record_file = NULL;
+static unsigned long start_ns = 0;
+static uint32_t next_conn_id = 0;
+static RecordConnection *connections = NULL;
+
+bool recorder_init(int width, int height) {
+
+    const char *path = getenv("FAINTER_RECORD");
+    if (path == NULL || path[0] == '\0') {
+        return false;
+    }
+
+    record_file = fopen(path, "wb");
+    if (record_file == NULL) {
+        LOG_ERROR("녹화 파일 열기 실패 (%s): %s", path, strerror(errno));
+        return false;
+    }
+    setvbuf(record_file, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORD_MAGIC, sizeof(header.magic));
+    header.version = RECORD_VERSION;
+    header.width = (uint16_t)width;
+    header.height = (uint16_t)height;
+    header.start_unix_ms = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    fwrite(&header, sizeof(header), 1, record_file);
+
+    start_ns = monotonic_ns();
+    LOG_INFO("트래픽 녹화 시작: %s", path);
+    return true;
+}
+
+// fd의 현재 접속 번호 (새 접속이면 새 번호)
+static uint32_t connection_id(int fd, bool joined) {
+
+    RecordConnection *conn;
+    HASH_FIND_INT(connections, &fd, conn);
+    if (conn == NULL) {
+        conn = (RecordConnection *)malloc(sizeof(RecordConnection));
+        if (conn == NULL) {
+            return 0;
+        }
+        conn->fd = fd;
+        HASH_ADD_INT(connections, fd, conn);
+        joined = true;
+    }
+    if (joined) {
+        conn->conn_id = ++next_conn_id;
+    }
+    return conn->conn_id;
+}
+
+static void write_entry(RecordEntry *entry, unsigned long time_ns) {
+
+    entry->time_ns = time_ns > start_ns ? time_ns - start_ns : 0;
+    if (fwrite(entry, sizeof(*entry), 1, record_file) != 1) {
+        LOG_ERROR("녹화 파일 쓰기 실패: %s, 녹화를 멈춥니다", strerror(errno));
+        fclose(record_file);
+        record_file = NULL;
+    }
+}
+
+void recorder_join(int client, unsigned long time_ns) {
+
+    if (record_file == NULL) {
+        return;
+    }
+    RecordEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.type = RECORD_JOIN;
+    entry.conn_id = connection_id(client, true);
+    write_entry(&entry, time_ns);
+}
+
+void recorder_pixel(int client, unsigned long recv_ns, int x, int y, const char *color) {
+
+    if (record_file == NULL) {
+        return;
+    }
+    // color는 검증을 통과한 "#rrggbb"
+    unsigned long rgb = strtoul(color + 1, NULL, 16);
+
+    RecordEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.type = RECORD_PIXEL;
+    entry.conn_id = connection_id(client, false);
+    entry.x = (uint16_t)x;
+    entry.y = (uint16_t)y;
+    entry.rgb[0] = (rgb >> 16) & 0xFF;
+    entry.rgb[1] = (rgb >> 8) & 0xFF;
+    entry.rgb[2] = rgb & 0xFF;
+    write_entry(&entry, recv_ns != 0 ? recv_ns : monotonic_ns());
+}
+
+void recorder_flush(void) {
+
+    if (record_file != NULL && fflush(record_file) != 0) {
+        LOG_ERROR("녹화 파일 쓰기 실패: %s, 녹화를 멈춥니다", strerror(errno));
+        fclose(record_file);
+        record_file = NULL;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 수신 픽셀 트래픽 녹화 (환경 변수 FAINTER_RECORD=파일 경로 일 때만)
+// 캔버스 스레드가 디코딩/검증을 마친 픽셀과 WebSocket 접속을 시각과 함께 기록한다.
+// tools/replay 로 같은 부하를 실제 서버나 프로세스 안의 캔버스에 다시 넣을 수 있다.
+// 캔버스 스레드에서만 호출한다 (락 없음).
+
+#define RECORD_MAGIC "FNTREC01"
+#define RECORD_VERSION 1
+
+typedef enum {
+    RECORD_JOIN = 1,        // WebSocket 접속 (초기 캔버스 전송)
+    RECORD_PIXEL = 2        // 반영된 픽셀
+} RecordType;
+
+// 파일 머리
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint16_t width;
+    uint16_t height;
+    uint64_t start_unix_ms;     // 녹화 시작 시각
+} RecordHeader;
+
+// 이벤트 하나 (고정 크기)
+typedef struct {
+    uint64_t time_ns;       // 녹화 시작부터 (픽셀은 소켓에서 읽은 시각)
+    uint32_t conn_id;       // 접속마다 새로 붙는 번호 (fd 재사용과 구분), 1부터
+    uint16_t x;
+    uint16_t y;
+    uint8_t type;           // RecordType
+    uint8_t rgb[3];
+    uint32_t reserved;
+} RecordEntry;
+
+_Static_assert(sizeof(RecordEntry) == 24, "record entry layout changed");
+
+// FAINTER_RECORD가 있으면 파일을 열고 녹화 시작
+bool recorder_init(int width, int height);
+
+void recorder_join(int client, unsigned long time_ns);
+void recorder_pixel(int client, unsigned long recv_ns, int x, int y, const char *color);
+
+// 버퍼에 쌓인 이벤트를 파일로 (브로드캐스트 틱마다 호출)
+void recorder_flush(void);
+
+#endif // RECORDER_H
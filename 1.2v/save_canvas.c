@@ -3,9 +3,13 @@
 #include <string.h>
 #include <cjson/cJSON.h>
 #include <sys/time.h>
+#include <errno.h>
 #include "canvas.h"
 #include <sys/stat.h> 
 #include <sys/types.h> 
+#include "log.h"
+#include "save_canvas.h"
+#include "parsing_json.h"
 
 // JSON 파일로 캔버스 저장
 void save_canvas_as_json(Canvas *canvas) {
@@ -13,8 +17,9 @@ void save_canvas_as_json(Canvas *canvas) {
     // 타이밍 시작
     clock_t start = clock();
 
-    // 파일 이름 생성
-    char *filename = "save/save.json";
+    // 파일 이름 생성 (임시 파일에 다 쓴 뒤 바꿔치기: 적재하는 쪽이 반쯤 쓴 파일을 보지 않도록)
+    const char *filename = SAVE_CANVAS_PATH;
+    const char *tmp_filename = SAVE_CANVAS_PATH ".tmp";
 
     // JSON 객체 생성
     cJSON *root = cJSON_CreateObject();
@@ -32,25 +37,79 @@ void save_canvas_as_json(Canvas *canvas) {
 
     // JSON 데이터를 파일로 저장
     char *json_string = cJSON_Print(root);
-    FILE *file = fopen(filename, "w");
+    FILE *file = fopen(tmp_filename, "w");
     if (file) {
         fprintf(file, "%s", json_string);
-        fclose(file);
-        printf("JSON 파일 저장 완료: %s\n", filename);
+        if (fclose(file) != 0 || rename(tmp_filename, filename) == -1) {
+            LOG_ERROR("JSON 파일 저장 실패: %s", strerror(errno));
+        } else {
+            LOG_INFO("JSON 파일 저장 완료: %s", filename);
+        }
     } else {
-        perror("JSON 파일 저장 실패");
+        LOG_ERROR("JSON 파일 저장 실패: %s", strerror(errno));
     }
 
     // 타이밍 끝
     clock_t end = clock();
     double time_taken = ((double)(end - start)) / CLOCKS_PER_SEC;
-    printf("JSON 저장 소요 시간: %f 초\n", time_taken);
+    LOG_INFO("JSON 저장 소요 시간: %f 초", time_taken);
 
     // 메모리 해제
     free(json_string);
     cJSON_Delete(root);
 }
 
+int load_canvas_from_json(Canvas *canvas, const char *filename) {
+
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        LOG_WARN("저장된 캔버스 열기 실패: %s (%s)", filename, strerror(errno));
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size > 0 ? malloc(size + 1) : NULL;
+    if (text == NULL || fread(text, 1, size, file) != (size_t)size) {
+        LOG_ERROR("저장된 캔버스 읽기 실패: %s", filename);
+        free(text);
+        fclose(file);
+        return -1;
+    }
+    text[size] = '\0';
+    fclose(file);
+
+    cJSON *root = cJSON_Parse(text);
+    free(text);
+    cJSON *width = cJSON_GetObjectItem(root, "width");
+    cJSON *height = cJSON_GetObjectItem(root, "height");
+    cJSON *pixels = cJSON_GetObjectItem(root, "pixels");
+    const int count = canvas->canvas_width * canvas->canvas_height;
+    if (!cJSON_IsNumber(width) || !cJSON_IsNumber(height) || !cJSON_IsArray(pixels) ||
+        width->valueint != canvas->canvas_width || height->valueint != canvas->canvas_height ||
+        cJSON_GetArraySize(pixels) != count) {
+        LOG_ERROR("저장된 캔버스 형식이나 크기가 다름: %s", filename);
+        cJSON_Delete(root);
+        return -1;
+    }
+
+    // 잘못된 색은 건너뛰고 흰색으로 둔다
+    int index = 0;
+    int invalid = 0;
+    for (cJSON *color = pixels->child; color != NULL; color = color->next) {
+        if (cJSON_IsString(color) && is_valid_hex_color(color->valuestring)) {
+            strcpy(canvas->pixels[index].color, color->valuestring);
+        } else {
+            invalid++;
+        }
+        index++;
+    }
+    cJSON_Delete(root);
+
+    LOG_INFO("저장된 캔버스 적재 완료: %s (잘못된 픽셀 %d개)", filename, invalid);
+    return 0;
+}
+
 char *trans_canvas_as_json(Canvas *canvas) {
     // 타이밍 시작
     clock_t start = clock();
@@ -79,7 +138,7 @@ char *trans_canvas_as_json(Canvas *canvas) {
     // 타이밍 끝        
     clock_t end = clock();
     double time_taken = ((double)(end - start)) / CLOCKS_PER_SEC;
-    printf("변환 저장 소요 시간: %f 초\n", time_taken);
+    LOG_DEBUG("변환 저장 소요 시간: %f 초", time_taken);
 
     cJSON_Delete(root);
     return json_string;
@@ -3,7 +3,12 @@
 
 #include "canvas.h"
 
+#define SAVE_CANVAS_PATH "save/save.json"
+
 void save_canvas_as_json(Canvas *canvas);
+
+// 저장된 캔버스를 픽셀 배열에 적재 (크기가 다르거나 읽을 수 없으면 -1, 캔버스는 그대로)
+int load_canvas_from_json(Canvas *canvas, const char *filename);
 char *trans_canvas_as_json(Canvas *canvas);
 
 #endif // SAVE_CANVAS_H
\ No newline at end of file
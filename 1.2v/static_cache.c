@@ -0,0 +1,507 @@
+#include "static_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <errno.h>
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include "log.h"
+#include "work_pool.h"
+
+// MIME 타입 결정 함수
+static const char *get_mime_type(const char *path) {
+    const char *ext = strrchr(path, '.');
+    if (!ext) return "text/plain";
+
+    if (strcmp(ext, ".html") == 0) return "text/html";
+    if (strcmp(ext, ".css") == 0) return "text/css";
+    if (strcmp(ext, ".js") == 0) return "application/javascript";
+    if (strcmp(ext, ".png") == 0) return "image/png";
+    if (strcmp(ext, ".jpg") == 0) return "image/jpeg";
+    // 필요에 따라 추가 MIME 타입을 정의
+
+    return "application/octet-stream";
+}
+
+#define STRINGIFY(x) #x
+#define TO_STRING(x) STRINGIFY(x)
+
+const char *http_connection_header(HttpConnectionMode mode) {
+    if (mode == HTTP_KEEP_ALIVE) {
+        return "Connection: keep-alive\r\n"
+               "Keep-Alive: timeout=" TO_STRING(HTTP_KEEP_ALIVE_TIMEOUT) "\r\n";
+    }
+    return "Connection: close\r\n";
+}
+
+static void free_static_file(StaticFile *file) {
+    if (file->fd != -1) {
+        close(file->fd);
+    }
+    for (int encoding = 0; encoding < STATIC_ENCODINGS; encoding++) {
+        StaticVariant *variant = &file->variants[encoding];
+        free(variant->body);
+        for (int mode = 0; mode < HTTP_CONNECTION_MODES; mode++) {
+            free(variant->header[mode]);
+            free(variant->not_modified[mode]);
+        }
+    }
+    free(file);
+}
+
+static char *copy_buffer(const char *src, size_t len) {
+    char *dst = (char *)malloc(len);
+    if (dst) {
+        memcpy(dst, src, len);
+    }
+    return dst;
+}
+
+// 압축해서 전송할 만한 MIME 타입인지 확인
+static bool is_compressible(const char *mime_type) {
+    return strncmp(mime_type, "text/", 5) == 0 ||
+           strcmp(mime_type, "application/javascript") == 0 ||
+           strcmp(mime_type, "application/json") == 0;
+}
+
+// gzip 압축, 원본보다 작아지지 않으면 NULL
+static char *compress_gzip(const char *src, size_t src_len, size_t *out_len) {
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits 15 + 16: zlib 대신 gzip 헤더 사용
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+
+    size_t bound = deflateBound(&stream, src_len);
+    char *out = (char *)malloc(bound);
+    if (out == NULL) {
+        deflateEnd(&stream);
+        return NULL;
+    }
+
+    stream.next_in = (Bytef *)src;
+    stream.avail_in = src_len;
+    stream.next_out = (Bytef *)out;
+    stream.avail_out = bound;
+    int result = deflate(&stream, Z_FINISH);
+    *out_len = stream.total_out;
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END || *out_len >= src_len) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+#ifdef HAVE_BROTLI
+// brotli 압축, 원본보다 작아지지 않으면 NULL
+static char *compress_brotli(const char *src, size_t src_len, size_t *out_len) {
+
+    size_t bound = BrotliEncoderMaxCompressedSize(src_len);
+    char *out = (char *)malloc(bound);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    *out_len = bound;
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               src_len, (const uint8_t *)src, out_len, (uint8_t *)out) ||
+        *out_len >= src_len) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+#endif
+
+static const char *const encoding_names[STATIC_ENCODINGS] = {"identity", "gzip", "br"};
+static const char *const etag_suffixes[STATIC_ENCODINGS] = {"", "-gz", "-br"};
+
+// 변형 하나의 연결 방식별 200/304 응답 헤더를 미리 만들어 둔다
+static int build_variant_headers(StaticFile *file, StaticVariant *variant, StaticEncoding encoding, bool vary) {
+
+    char extra[128];
+    snprintf(extra, sizeof(extra), "%s%s%s",
+             encoding != STATIC_ENCODING_IDENTITY ? "Content-Encoding: " : "",
+             encoding != STATIC_ENCODING_IDENTITY ? encoding_names[encoding] : "",
+             encoding != STATIC_ENCODING_IDENTITY ? "\r\n" : "");
+    if (vary) {
+        strcat(extra, "Vary: Accept-Encoding\r\n");
+    }
+
+    for (int mode = 0; mode < HTTP_CONNECTION_MODES; mode++) {
+        char header[512];
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.1 200 OK\r\n"
+                                  "Content-Type: %s\r\n"
+                                  "Content-Length: %zu\r\n"
+                                  "%s"
+                                  "ETag: %s\r\n"
+                                  "Last-Modified: %s\r\n"
+                                  "Cache-Control: no-cache\r\n"
+                                  "%s"
+                                  "\r\n",
+                                  file->mime_type, variant->body_len, extra, variant->etag, file->last_modified,
+                                  http_connection_header(mode));
+        variant->header[mode] = copy_buffer(header, header_len);
+        variant->header_len[mode] = header_len;
+
+        int not_modified_len = snprintf(header, sizeof(header),
+                                        "HTTP/1.1 304 Not Modified\r\n"
+                                        "ETag: %s\r\n"
+                                        "Last-Modified: %s\r\n"
+                                        "Cache-Control: no-cache\r\n"
+                                        "%s"
+                                        "%s"
+                                        "\r\n",
+                                        variant->etag, file->last_modified,
+                                        vary ? "Vary: Accept-Encoding\r\n" : "", http_connection_header(mode));
+        variant->not_modified[mode] = copy_buffer(header, not_modified_len);
+        variant->not_modified_len[mode] = not_modified_len;
+
+        if (variant->header[mode] == NULL || variant->not_modified[mode] == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 파일 하나를 읽어서 인코딩별 본문과 응답을 미리 만들어 둔다
+static StaticFile *load_static_file(const char *root, const char *name) {
+
+    char file_path[STATIC_PATH_MAX * 2];
+    snprintf(file_path, sizeof(file_path), "%s/%s", root, name);
+
+    int fd = open(file_path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    StaticFile *file = (StaticFile *)calloc(1, sizeof(StaticFile));
+    if (file == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    snprintf(file->path, sizeof(file->path), "/%s", name);
+    file->mime_type = get_mime_type(name);
+    file->mtime = st.st_mtime;
+    file->fd = fd;
+
+    struct tm tm;
+    gmtime_r(&st.st_mtime, &tm);
+    strftime(file->last_modified, sizeof(file->last_modified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    StaticVariant *identity = &file->variants[STATIC_ENCODING_IDENTITY];
+    identity->body_len = (size_t)st.st_size;
+
+    // 작은 파일은 본문을 메모리에 올리고, 큰 파일은 fd를 유지해서 sendfile로 보낸다
+    if (identity->body_len < STATIC_SENDFILE_THRESHOLD) {
+        identity->body = (char *)malloc(identity->body_len);
+        if (identity->body_len > 0 && identity->body == NULL) {
+            free_static_file(file);
+            return NULL;
+        }
+        size_t offset = 0;
+        while (offset < identity->body_len) {
+            ssize_t n = pread(fd, identity->body + offset, identity->body_len - offset, offset);
+            if (n <= 0) {
+                free_static_file(file);
+                return NULL;
+            }
+            offset += n;
+        }
+        close(fd);
+        file->fd = -1;
+    }
+
+    // 메모리에 올린 텍스트 파일은 적재 시점에 한 번만 압축해 둔다
+    if (identity->body && identity->body_len >= STATIC_COMPRESS_MIN_SIZE && is_compressible(file->mime_type)) {
+        StaticVariant *gzip = &file->variants[STATIC_ENCODING_GZIP];
+        gzip->body = compress_gzip(identity->body, identity->body_len, &gzip->body_len);
+#ifdef HAVE_BROTLI
+        StaticVariant *brotli = &file->variants[STATIC_ENCODING_BROTLI];
+        brotli->body = compress_brotli(identity->body, identity->body_len, &brotli->body_len);
+#endif
+    }
+
+    // 압축 변형이 하나라도 있으면 모든 응답에 Vary를 붙인다
+    bool vary = false;
+    for (int encoding = STATIC_ENCODING_GZIP; encoding < STATIC_ENCODINGS; encoding++) {
+        vary |= file->variants[encoding].body != NULL;
+    }
+
+    for (int encoding = 0; encoding < STATIC_ENCODINGS; encoding++) {
+        StaticVariant *variant = &file->variants[encoding];
+        if (encoding != STATIC_ENCODING_IDENTITY && variant->body == NULL) {
+            continue;
+        }
+        snprintf(variant->etag, sizeof(variant->etag), "\"%lx-%lx%s\"",
+                 (unsigned long)st.st_size, (unsigned long)st.st_mtime, etag_suffixes[encoding]);
+        if (build_variant_headers(file, variant, encoding, vary) == -1) {
+            free_static_file(file);
+            return NULL;
+        }
+    }
+
+    return file;
+}
+
+// Accept-Encoding에서 coding의 q 값을 읽는다 (없으면 -1, "*"는 나머지 전부)
+static double accepted_quality(const char *accept_encoding, const char *coding) {
+
+    double wildcard = -1;
+    const char *p = accept_encoding;
+    while (p && *p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        size_t len = strcspn(p, ",;");
+        size_t name_len = len;
+        while (name_len > 0 && (p[name_len - 1] == ' ' || p[name_len - 1] == '\t')) {
+            name_len--;
+        }
+
+        double quality = 1.0;
+        const char *next = p + len;
+        if (*next == ';') {
+            const char *q = strstr(next, "q=");
+            const char *comma = strchr(next, ',');
+            if (q && (comma == NULL || q < comma)) {
+                quality = strtod(q + 2, NULL);
+            }
+        }
+
+        if (name_len == strlen(coding) && strncasecmp(p, coding, name_len) == 0) {
+            return quality;
+        }
+        if (name_len == 1 && *p == '*') {
+            wildcard = quality;
+        }
+        p = strchr(next, ',');
+    }
+    return wildcard;
+}
+
+StaticVariant *select_static_variant(StaticFile *file, const char *accept_encoding) {
+
+    if (accept_encoding == NULL) {
+        return &file->variants[STATIC_ENCODING_IDENTITY];
+    }
+
+    // 클라이언트가 허용하는(q > 0) 인코딩 중 가장 작은 것을 고른다 (br < gzip < 원본)
+    StaticVariant *best = &file->variants[STATIC_ENCODING_IDENTITY];
+    for (int encoding = STATIC_ENCODING_GZIP; encoding < STATIC_ENCODINGS; encoding++) {
+        StaticVariant *variant = &file->variants[encoding];
+        if (variant->body == NULL || variant->body_len >= best->body_len) {
+            continue;
+        }
+        if (accepted_quality(accept_encoding, encoding_names[encoding]) > 0) {
+            best = variant;
+        }
+    }
+    return best;
+}
+
+// 디렉토리 안의 일반 파일을 모두 읽어서 새 해시 맵을 만든다 (하위 디렉토리는 다루지 않음)
+static StaticFile *load_static_dir(const char *root) {
+
+    DIR *dir = opendir(root);
+    if (dir == NULL) {
+        LOG_ERROR("[CM] 정적 파일 디렉토리 열기 실패: %s", strerror(errno));
+        return NULL;
+    }
+
+    StaticFile *files = NULL;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        StaticFile *file = load_static_file(root, entry->d_name);
+        if (file) {
+            HASH_ADD_STR(files, path, file);
+        }
+    }
+    closedir(dir);
+
+    return files;
+}
+
+static void free_static_files(StaticFile *files) {
+    StaticFile *file, *tmp;
+    HASH_ITER(hh, files, file, tmp) {
+        HASH_DEL(files, file);
+        free_static_file(file);
+    }
+}
+
+static StaticTable *new_static_table(const char *root) {
+    StaticTable *table = malloc(sizeof(StaticTable));
+    if (table == NULL) {
+        return NULL;
+    }
+    table->files = load_static_dir(root);
+    atomic_init(&table->refs, 1);
+    return table;
+}
+
+// 새 묶음으로 교체하고 이전 묶음의 캐시 참조를 놓는다
+static void install_static_table(StaticCache *cache, StaticTable *table) {
+    pthread_mutex_lock(&cache->lock);
+    StaticTable *old = cache->table;
+    cache->table = table;
+    pthread_mutex_unlock(&cache->lock);
+    if (old != NULL) {
+        static_cache_release(old);
+    }
+}
+
+int init_static_cache(StaticCache *cache, const char *root) {
+
+    snprintf(cache->root, sizeof(cache->root), "%s", root);
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->reloading = false;
+    cache->reload_again = false;
+    cache->table = new_static_table(root);
+    if (cache->table == NULL) {
+        LOG_ERROR("[CM] 정적 파일 캐시 할당 실패");
+        return -1;
+    }
+
+    // 파일이 바뀌면 다시 읽을 수 있도록 디렉토리 감시
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache->inotify_fd == -1) {
+        LOG_ERROR("[CM] inotify 초기화 실패, 정적 파일 캐시는 갱신되지 않습니다: %s", strerror(errno));
+    }
+    else if (inotify_add_watch(cache->inotify_fd, root,
+                               IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) == -1) {
+        LOG_ERROR("[CM] inotify 감시 등록 실패, 정적 파일 캐시는 갱신되지 않습니다: %s", strerror(errno));
+        close(cache->inotify_fd);
+        cache->inotify_fd = -1;
+    }
+
+    LOG_INFO("[CM] 정적 파일 캐시 적재 완료: %u개 파일", HASH_COUNT(cache->table->files));
+    return 0;
+}
+
+void reload_static_cache(StaticCache *cache) {
+
+    StaticTable *table = new_static_table(cache->root);
+    if (table == NULL) {
+        LOG_ERROR("[CM] 정적 파일 캐시 재적재 실패");
+        return;
+    }
+    install_static_table(cache, table);
+    LOG_INFO("[CM] 정적 파일 캐시 재적재: %u개 파일", HASH_COUNT(table->files));
+}
+
+// 작업 풀에서 실행: 디렉토리를 읽고 압축까지 끝낸 뒤 교체, 그 사이 또 바뀌었으면 한 번 더
+static void reload_static_cache_job(void *arg) {
+
+    StaticCache *cache = (StaticCache *)arg;
+    bool again = true;
+    while (again) {
+        reload_static_cache(cache);
+        pthread_mutex_lock(&cache->lock);
+        again = cache->reload_again;
+        cache->reload_again = false;
+        cache->reloading = again;
+        pthread_mutex_unlock(&cache->lock);
+    }
+}
+
+void handle_static_cache_events(StaticCache *cache) {
+
+    if (cache->inotify_fd == -1) {
+        return;
+    }
+
+    // edge triggered로 등록되어 있으므로 큐를 끝까지 비운다
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    while (read(cache->inotify_fd, buf, sizeof(buf)) > 0) {
+        changed = true;
+    }
+    if (!changed) {
+        return;
+    }
+
+    // 파일 읽기와 압축은 워커에서 (이미 재적재 중이면 끝난 뒤 한 번 더 하도록 표시만)
+    pthread_mutex_lock(&cache->lock);
+    bool start = !cache->reloading;
+    if (start) {
+        cache->reloading = true;
+    } else {
+        cache->reload_again = true;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (start) {
+        work_pool_submit(reload_static_cache_job, cache);
+    }
+}
+
+StaticTable *static_cache_acquire(StaticCache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    StaticTable *table = cache->table;
+    atomic_fetch_add(&table->refs, 1);
+    pthread_mutex_unlock(&cache->lock);
+    return table;
+}
+
+void static_cache_release(StaticTable *table) {
+    if (atomic_fetch_sub(&table->refs, 1) == 1) {
+        free_static_files(table->files);
+        free(table);
+    }
+}
+
+StaticFile *find_static_file(StaticTable *table, const char *path) {
+
+    // 쿼리스트링 제거
+    char key[STATIC_PATH_MAX];
+    size_t len = strcspn(path, "?#");
+    if (len >= sizeof(key)) {
+        return NULL;
+    }
+    memcpy(key, path, len);
+    key[len] = '\0';
+
+    if (strcmp(key, "/") == 0) {
+        strcpy(key, "/index.html");
+    }
+
+    StaticFile *file;
+    HASH_FIND_STR(table->files, key, file);
+    return file;
+}
+
+void destroy_static_cache(StaticCache *cache) {
+
+    static_cache_release(cache->table);
+    cache->table = NULL;
+    pthread_mutex_destroy(&cache->lock);
+    if (cache->inotify_fd != -1) {
+        close(cache->inotify_fd);
+    }
+    free(cache);
+}
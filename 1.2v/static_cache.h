@@ -0,0 +1,98 @@
+#ifndef STATIC_CACHE_H
+#define STATIC_CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "include/uthash.h"
+
+#define STATIC_SENDFILE_THRESHOLD (64 * 1024)  // 이 크기 이상인 파일은 메모리에 올리지 않고 sendfile로 전송
+#define STATIC_PATH_MAX 256
+#define STATIC_COMPRESS_MIN_SIZE 256             // 이보다 작은 파일은 압축하지 않음
+
+#define HTTP_KEEP_ALIVE_TIMEOUT 5               // keep-alive 연결의 유휴 제한 시간 (초)
+
+// 응답 후 연결 처리 방식 (Connection 헤더)
+typedef enum {
+    HTTP_KEEP_ALIVE,                // 응답 후 연결 유지
+    HTTP_CLOSE,                     // 응답 후 연결 종료
+    HTTP_CONNECTION_MODES
+} HttpConnectionMode;
+
+// 미리 압축해 두는 인코딩 (Accept-Encoding 협상 순서대로)
+typedef enum {
+    STATIC_ENCODING_IDENTITY,       // 압축하지 않은 원본
+    STATIC_ENCODING_GZIP,
+    STATIC_ENCODING_BROTLI,         // HAVE_BROTLI로 빌드한 경우에만 생성
+    STATIC_ENCODINGS
+} StaticEncoding;
+
+// 인코딩 하나에 대한 본문과 미리 만들어둔 응답
+typedef struct {
+    char *body;                     // 본문 (sendfile로 보내는 큰 원본은 NULL)
+    size_t body_len;
+    char etag[56];                  // 인코딩마다 다른 ETag ("크기-수정시각[-gz|-br]")
+    char *header[HTTP_CONNECTION_MODES];            // 미리 만들어둔 200 응답 헤더 (연결 방식별)
+    size_t header_len[HTTP_CONNECTION_MODES];
+    char *not_modified[HTTP_CONNECTION_MODES];      // 미리 만들어둔 304 응답 (연결 방식별)
+    size_t not_modified_len[HTTP_CONNECTION_MODES];
+} StaticVariant;
+
+// 캐시된 정적 파일 하나
+typedef struct StaticFile {
+    char path[STATIC_PATH_MAX];     // 요청 경로 (예: "/index.html"), 해시 키
+    const char *mime_type;          // Content-Type
+    char last_modified[48];         // Last-Modified (IMF-fixdate)
+    time_t mtime;                   // 파일 수정 시각 (If-Modified-Since 비교용)
+    int fd;                         // sendfile용 파일 디스크립터 (메모리에 올린 파일은 -1)
+
+    StaticVariant variants[STATIC_ENCODINGS];   // 헤더가 NULL인 인코딩은 없는 것
+
+    UT_hash_handle hh;              // uthash 핸들
+} StaticFile;
+
+// 한 번 적재한 파일 묶음 (참조 수가 0이 되면 해제)
+// 재적재는 새 묶음을 만들어 교체하므로, 응답을 보내는 중인 워커는 이전 묶음을 끝까지 쓴다.
+typedef struct {
+    StaticFile *files;              // 경로 -> 파일 해시 맵
+    atomic_int refs;                // 캐시가 가진 참조 1 + 사용 중인 요청 수
+} StaticTable;
+
+// 정적 파일 캐시 (응답은 작업 풀 워커가, inotify 처리는 ClientManager 스레드가 한다)
+typedef struct {
+    StaticTable *table;             // 현재 묶음 (lock으로 보호)
+    pthread_mutex_t lock;           // table 교체와 재적재 상태 보호
+    bool reloading;                 // 작업 풀에서 재적재 중
+    bool reload_again;              // 재적재 중에 또 바뀌었다
+    char root[STATIC_PATH_MAX];     // 정적 파일 디렉토리
+    int inotify_fd;                 // 디렉토리 변경 감시용 inotify 파일 디스크립터 (실패 시 -1)
+} StaticCache;
+
+// 연결 방식에 맞는 Connection 헤더 줄
+const char *http_connection_header(HttpConnectionMode mode);
+
+// 디렉토리를 읽어서 캐시를 채우고 inotify 감시를 시작
+int init_static_cache(StaticCache *cache, const char *root);
+
+// 디렉토리를 다시 읽어서 캐시를 통째로 교체 (호출한 스레드에서)
+void reload_static_cache(StaticCache *cache);
+
+// inotify 이벤트를 모두 읽고, 변경이 있었으면 작업 풀에서 다시 적재
+void handle_static_cache_events(StaticCache *cache);
+
+// 현재 파일 묶음의 참조를 얻는다 (다 쓰면 static_cache_release)
+StaticTable *static_cache_acquire(StaticCache *cache);
+void static_cache_release(StaticTable *table);
+
+// Accept-Encoding 값에 맞는 변형 선택 (없으면 원본)
+StaticVariant *select_static_variant(StaticFile *file, const char *accept_encoding);
+
+// 요청 경로에 해당하는 캐시 항목 검색 ("/"는 "/index.html", 쿼리스트링 무시)
+StaticFile *find_static_file(StaticTable *table, const char *path);
+
+// 캐시 정리
+void destroy_static_cache(StaticCache *cache);
+
+#endif // STATIC_CACHE_H
@@ -0,0 +1,276 @@
+#include "stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "log.h"
+#include "affinity.h"
+
+#define STATS_FILE_SIZE (STATS_HEADER_SIZE + sizeof(StatsSample) * STATS_CAPACITY)
+#define STATS_CSV_ROW_MAX 1024
+
+static StatsFileHeader *ring = NULL;
+
+static StatsSample *ring_samples(const StatsFileHeader *header) {
+    return (StatsSample *)((char *)header + STATS_HEADER_SIZE);
+}
+
+static uint64_t realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 링 파일을 mmap (같은 형식의 파일이 있으면 이어서 쓴다)
+static StatsFileHeader *map_ring(const char *path) {
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        LOG_WARN("통계 파일 열기 실패 (%s): %s, 메모리에만 기록합니다", path, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, STATS_FILE_SIZE) == -1) {
+        LOG_WARN("통계 파일 크기 설정 실패 (%s): %s, 메모리에만 기록합니다", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, STATS_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOG_WARN("통계 파일 mmap 실패 (%s): %s, 메모리에만 기록합니다", path, strerror(errno));
+        return NULL;
+    }
+    return (StatsFileHeader *)map;
+}
+
+static void init_header(StatsFileHeader *header) {
+
+    bool reuse = memcmp(header->magic, STATS_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == STATS_VERSION &&
+                 header->record_size == sizeof(StatsSample) &&
+                 header->capacity == STATS_CAPACITY;
+    if (!reuse) {
+        memset(header, 0, STATS_HEADER_SIZE);
+        memcpy(header->magic, STATS_MAGIC, sizeof(header->magic));
+        header->version = STATS_VERSION;
+        header->record_size = sizeof(StatsSample);
+        header->capacity = STATS_CAPACITY;
+        atomic_init(&header->head, 0);
+    }
+    header->interval_ms = STATS_INTERVAL_MS;
+
+    int queue_count = metrics_queue_count();
+    for (int i = 0; i < STATS_MAX_QUEUES; i++) {
+        snprintf(header->queue_names[i], sizeof(header->queue_names[i]), "%s",
+                 i < queue_count ? metrics_queue(i)->name : "");
+    }
+}
+
+// 샘플러가 직전 샘플에서 본 누적값
+typedef struct {
+    uint64_t time_ms;
+    unsigned long counters[METRIC_COUNT];
+    unsigned long hist_counts[HIST_COUNT][HISTOGRAM_BUCKETS];
+    unsigned long queue_dropped[STATS_MAX_QUEUES];
+} StatsBaseline;
+
+static void take_sample(ClientManager *cm, StatsBaseline *base, StatsSample *sample) {
+
+    uint64_t now = realtime_ms();
+    sample->timestamp_ms = now;
+    sample->interval_ms = (uint32_t)(now - base->time_ms);
+    sample->clients = get_client_count(cm);
+    base->time_ms = now;
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        unsigned long total = metrics_total(id);
+        sample->counters[id] = total - base->counters[id];
+        base->counters[id] = total;
+    }
+    for (int id = 0; id < GAUGE_COUNT; id++) {
+        sample->gauges[id] = metrics_gauge(id);
+    }
+
+    // 누적 분포와 직전 분포의 차이로 이번 구간의 분포를 만든다
+    static Histogram merged, interval;
+    for (int id = 0; id < HIST_COUNT; id++) {
+        Histogram *histogram = &merged;
+        metrics_histogram(id, histogram);
+        unsigned long count = 0;
+        histogram_init(&interval);
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            unsigned long total = atomic_load_explicit(&histogram->counts[b], memory_order_relaxed);
+            unsigned long delta = total - base->hist_counts[id][b];
+            base->hist_counts[id][b] = total;
+            atomic_store_explicit(&interval.counts[b], delta, memory_order_relaxed);
+            count += delta;
+        }
+        // 구간 최대값은 모르므로 버킷 상한을 그대로 쓴다
+        atomic_store_explicit(&interval.max, ~0UL, memory_order_relaxed);
+        sample->hist_count[id] = count;
+        sample->hist_p50_ns[id] = count ? histogram_percentile(&interval, 0.5) : 0;
+        sample->hist_p99_ns[id] = count ? histogram_percentile(&interval, 0.99) : 0;
+        sample->hist_max_ns[id] = count ? histogram_percentile(&interval, 1.0) : 0;
+    }
+
+    int queue_count = metrics_queue_count();
+    for (int i = 0; i < STATS_MAX_QUEUES; i++) {
+        if (i < queue_count) {
+            TaskQueue *queue = metrics_queue(i);
+            unsigned long dropped = atomic_load(&queue->dropped);
+            sample->queue_depth[i] = task_queue_depth(queue);
+            sample->queue_dropped[i] = dropped - base->queue_dropped[i];
+            base->queue_dropped[i] = dropped;
+        } else {
+            sample->queue_depth[i] = 0;
+            sample->queue_dropped[i] = 0;
+        }
+    }
+}
+
+static void *sampler_thread(void *arg) {
+
+    ClientManager *cm = (ClientManager *)arg;
+    affinity_apply("stats", -1);
+    StatsBaseline *base = (StatsBaseline *)calloc(1, sizeof(StatsBaseline));
+    if (base == NULL) {
+        LOG_ERROR("통계 샘플러 메모리 할당 실패");
+        return NULL;
+    }
+
+    // 시작 시점의 누적값을 기준으로 삼는다 (첫 샘플 버림)
+    StatsSample discard;
+    take_sample(cm, base, &discard);
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (1) {
+        // 절대 시각으로 잠들어서 샘플 간격이 밀리지 않게 한다
+        next.tv_nsec += STATS_INTERVAL_MS * 1000000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        take_sample(cm, base, &ring_samples(ring)[head % STATS_CAPACITY]);
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+void stats_start(ClientManager *cm) {
+
+    const char *path = getenv("FAINTER_STATS_FILE");
+    ring = map_ring(path != NULL ? path : STATS_DEFAULT_FILE);
+    if (ring == NULL) {
+        ring = (StatsFileHeader *)calloc(1, STATS_FILE_SIZE);
+        if (ring == NULL) {
+            LOG_ERROR("통계 링 메모리 할당 실패");
+            return;
+        }
+    }
+    init_header(ring);
+
+    pthread_t tid;
+    const int n = pthread_create(&tid, NULL, sampler_thread, cm);
+    if (n != 0) {
+        LOG_ERROR("통계 샘플러 스레드 생성 실패: %s", strerror(n));
+        return;
+    }
+    pthread_detach(tid);
+    LOG_INFO("통계 샘플러 시작: %u ms 간격, 샘플 %u개 보관", STATS_INTERVAL_MS, STATS_CAPACITY);
+}
+
+const StatsFileHeader *stats_ring(void) {
+    return ring;
+}
+
+static size_t render_csv_header(const StatsFileHeader *header, char *buf, size_t size) {
+
+    size_t offset = metrics_append(buf, size, 0, "timestamp_ms,interval_ms,clients");
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        offset = metrics_append(buf, size, offset, ",%s", metrics_counter_name(id));
+    }
+    for (int id = 0; id < GAUGE_COUNT; id++) {
+        offset = metrics_append(buf, size, offset, ",%s", metrics_gauge_name(id));
+    }
+    for (int id = 0; id < HIST_COUNT; id++) {
+        const char *name = metrics_histogram_name(id);
+        offset = metrics_append(buf, size, offset, ",%s_count,%s_p50_ms,%s_p99_ms,%s_max_ms",
+                                name, name, name, name);
+    }
+    for (int i = 0; i < STATS_MAX_QUEUES && header->queue_names[i][0] != '\0'; i++) {
+        offset = metrics_append(buf, size, offset, ",queue_depth_%.16s,queue_dropped_%.16s",
+                                header->queue_names[i], header->queue_names[i]);
+    }
+    return metrics_append(buf, size, offset, "\n");
+}
+
+static size_t render_csv_row(const StatsFileHeader *header, const StatsSample *sample, char *buf, size_t size) {
+
+    size_t offset = metrics_append(buf, size, 0, "%lu,%u,%u",
+                                   (unsigned long)sample->timestamp_ms, sample->interval_ms, sample->clients);
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        // 시간 합계는 /metrics와 같이 초 단위로
+        if (id == METRIC_BROADCAST_FANOUT_NS || id == METRIC_SNAPSHOT_ENCODE_NS) {
+            offset = metrics_append(buf, size, offset, ",%.6f", sample->counters[id] / 1e9);
+        } else {
+            offset = metrics_append(buf, size, offset, ",%lu", (unsigned long)sample->counters[id]);
+        }
+    }
+    for (int id = 0; id < GAUGE_COUNT; id++) {
+        offset = metrics_append(buf, size, offset, ",%lu", (unsigned long)sample->gauges[id]);
+    }
+    for (int id = 0; id < HIST_COUNT; id++) {
+        offset = metrics_append(buf, size, offset, ",%lu,%.3f,%.3f,%.3f", (unsigned long)sample->hist_count[id],
+                                sample->hist_p50_ns[id] / 1e6, sample->hist_p99_ns[id] / 1e6,
+                                sample->hist_max_ns[id] / 1e6);
+    }
+    for (int i = 0; i < STATS_MAX_QUEUES && header->queue_names[i][0] != '\0'; i++) {
+        offset = metrics_append(buf, size, offset, ",%u,%u", sample->queue_depth[i], sample->queue_dropped[i]);
+    }
+    return metrics_append(buf, size, offset, "\n");
+}
+
+char *stats_render_csv(const StatsFileHeader *header, uint64_t since_ms, size_t last, size_t *length) {
+
+    uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+    uint64_t capacity = header->capacity;
+    uint64_t first = head > capacity ? head - capacity : 0;
+    if (last != 0 && head - first > last) {
+        first = head - last;
+    }
+
+    size_t size = STATS_CSV_ROW_MAX * 4 + STATS_CSV_ROW_MAX * (head - first);
+    char *buf = (char *)malloc(size);
+    if (buf == NULL) {
+        return NULL;
+    }
+    size_t offset = render_csv_header(header, buf, size);
+
+    const StatsSample *samples = ring_samples(header);
+    for (uint64_t i = first; i < head; i++) {
+        StatsSample sample = samples[i % capacity];
+        // 복사하는 동안 샘플러가 이 칸을 덮어썼으면 버린다
+        uint64_t now = atomic_load_explicit(&header->head, memory_order_acquire);
+        if (now > capacity && i < now - capacity) {
+            continue;
+        }
+        if (sample.timestamp_ms < since_ms) {
+            continue;
+        }
+        offset += render_csv_row(header, &sample, buf + offset, size - offset);
+    }
+
+    *length = offset < size ? offset : size;
+    return buf;
+}
@@ -0,0 +1,64 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "metrics.h"
+#include "client_manager.h"
+
+// 통계 샘플러
+// 샘플러 스레드가 STATS_INTERVAL_MS마다 메트릭 카운터/히스토그램을 읽어서
+// 고정 크기 바이너리 링(mmap한 파일)에 샘플 하나를 쓴다.
+// 측정하는 쪽(핫 패스)은 기존 메트릭 카운터에 더하기만 하고, 파일 I/O와 포맷팅은 하지 않는다.
+//  - GET /stats[?last=N][&since=unix_ms] : CSV로 조회 (이 호스트에서만, FAINTER_ADMIN_HTTP=1 이면 어디서나)
+//  - tools/stats_csv <파일>               : 서버 없이 파일을 CSV로 변환
+
+#define STATS_INTERVAL_MS 1000
+#define STATS_CAPACITY 3600                 // 링에 남는 샘플 수 (1초 간격이면 1시간)
+#define STATS_MAX_QUEUES 4
+#define STATS_DEFAULT_FILE "save/stats.bin" // FAINTER_STATS_FILE 로 변경
+#define STATS_MAGIC "FNTSTATS"
+#define STATS_VERSION 1
+#define STATS_HEADER_SIZE 256               // 샘플은 파일의 이 위치부터 시작
+
+// 샘플 하나 (카운터와 큐 드롭 수는 직전 샘플 이후 증가량)
+typedef struct {
+    uint64_t timestamp_ms;                  // CLOCK_REALTIME
+    uint32_t interval_ms;                   // 직전 샘플과의 실제 간격
+    uint32_t clients;                       // 열린 WebSocket 클라이언트 수
+    uint64_t counters[METRIC_COUNT];
+    uint64_t gauges[GAUGE_COUNT];
+    uint64_t hist_count[HIST_COUNT];        // 구간 동안 기록된 값 수
+    uint64_t hist_p50_ns[HIST_COUNT];       // 구간 분포의 백분위
+    uint64_t hist_p99_ns[HIST_COUNT];
+    uint64_t hist_max_ns[HIST_COUNT];       // 구간 분포에서 가장 높은 버킷의 상한
+    uint32_t queue_depth[STATS_MAX_QUEUES];
+    uint32_t queue_dropped[STATS_MAX_QUEUES];
+} StatsSample;
+
+// 파일 머리 (레코드 크기/용량이 다르면 새로 만든다)
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint32_t interval_ms;
+    char queue_names[STATS_MAX_QUEUES][16];
+    _Atomic uint64_t head;                  // 지금까지 쓴 샘플 수 (다음 칸 = head % capacity)
+} StatsFileHeader;
+
+_Static_assert(sizeof(StatsFileHeader) <= STATS_HEADER_SIZE, "stats header too large");
+
+// 링 파일을 열고 샘플러 스레드 시작 (파일을 못 쓰면 메모리에만 둔다)
+void stats_start(ClientManager *cm);
+
+// 현재 링 (시작 전이면 NULL)
+const StatsFileHeader *stats_ring(void);
+
+// 링의 샘플을 CSV로 만든다 (호출자가 free, 실패 시 NULL)
+// since_ms 이후 샘플 중 마지막 last개 (0이면 제한 없음)
+// 쓰는 중에 덮어써진 샘플은 건너뛴다.
+char *stats_render_csv(const StatsFileHeader *ring, uint64_t since_ms, size_t last, size_t *length);
+
+#endif // STATS_H
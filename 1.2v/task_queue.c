@@ -1,54 +1,239 @@
 #include "task_queue.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include "metrics.h"
+#include "trace.h"
+#include "log.h"
+
+static const char *lane_names[TASK_LANE_COUNT] = {"control", "bulk"};
+
+TaskLane task_lane(TaskType type) {
+
+    switch (type) {
+        // 대량: 페인트 폭주 때 쌓이는 작업
+        case TASK_PIXEL_UPDATE:
+        case TASK_FRAME_MESSAGE:
+        case TASK_MESSAGE_INCOMPLETE_FRAME:
+        case TASK_BROADCAST:
+        case TASK_INIT_CANAVAS:         // 브로드캐스트보다 먼저 나가야 하므로 같은 레인
+        case TASK_CLIENT_WRITABLE:
+        case TASK_CLIENT_CLOSE:         // 같은 연결에서 먼저 읽은 frame을 모두 반영한 뒤에 닫는다
+        case TASK_WEBSOCKET_CLOSE:
+        case TASK_HANDOFF:              // 먼저 들어온 픽셀 메세지, 브로드캐스트를 모두 처리한 뒤에 넘긴다
+            return TASK_LANE_BULK;
+        default:
+            return TASK_LANE_CONTROL;
+    }
+}
+
+const char *task_lane_name(TaskLane lane) {
+    return lane_names[lane];
+}
 
 // 작업 큐 초기화
-void init_task_queue(TaskQueue *queue, int size) {
+void init_task_queue(TaskQueue *queue, int size, const char *name) {
+
+    for (int i = 0; i < TASK_LANE_COUNT; i++) {
+        TaskQueueLane *lane = &queue->lanes[i];
+        lane->tasks = (Task *)malloc(sizeof(Task) * size);
+        lane->enqueue_ns = malloc(sizeof(unsigned long) * size);
+        lane->sample_mask = i == TASK_LANE_BULK ? TASK_LANE_BULK_SAMPLE - 1 : 0;
+        lane->front = lane->rear = 0;
+        atomic_init(&lane->dropped, 0);
+        histogram_init(&lane->wait);
+    }
+
+    const char *weight = getenv("FAINTER_LANE_WEIGHT");
+    queue->weight = (weight != NULL && atoi(weight) >= 0) ? atoi(weight) : TASK_LANE_DEFAULT_WEIGHT;
+    queue->control_streak = 0;
 
-    queue->tasks = (Task *)malloc(sizeof(Task) * size);
     queue->size = size;
+    queue->name = name;
+    atomic_init(&queue->pushed, 0);
+    atomic_init(&queue->dropped, 0);
+    snprintf(queue->push_event, sizeof(queue->push_event), "push %s", name);
+    snprintf(queue->pop_event, sizeof(queue->pop_event), "pop %s", name);
 
-    queue->front = queue->rear = 0;
     pthread_mutex_init(&queue->lock, NULL);
-    pthread_cond_init(&queue->cond, NULL);
+    // pop_task_timeout의 마감은 단조 시계로 잰다 (시스템 시각이 바뀌어도 틱이 밀리지 않게)
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&queue->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_cond_init(&queue->space, NULL);
+    queue->push_waiters = 0;
+}
+
+static __thread unsigned int push_count = 0;  // 이 스레드가 넣은 작업 수 (대기 시간 표본 선택)
+
+// 대기 시간을 잴 작업이면 지금 시각 (락 밖에서 읽는다), 아니면 0
+static unsigned long sample_enqueue_ns(TaskQueueLane *lane) {
+    return (push_count++ & lane->sample_mask) == 0 ? monotonic_ns() : 0;
+}
+
+static bool lane_full(TaskQueue *queue, TaskQueueLane *lane) {
+    return (lane->rear + 1) % queue->size == lane->front;
+}
+
+static bool lane_empty(TaskQueueLane *lane) {
+    return lane->front == lane->rear;
+}
+
+// 락을 잡은 상태에서 레인 뒤에 추가
+static void lane_push(TaskQueue *queue, TaskQueueLane *lane, Task task, unsigned long enqueue_ns) {
+
+    lane->tasks[lane->rear] = task;                 // 작업 추가
+    lane->enqueue_ns[lane->rear] = enqueue_ns;
+    lane->rear = (lane->rear + 1) % queue->size;    // rear 포인터 이동
+    atomic_fetch_add_explicit(&queue->pushed, 1, memory_order_relaxed);
+
+    pthread_cond_signal(&queue->cond);              // 대기 중인 스레드에 신호
 }
 
 // 작업을 큐에 추가
-void push_task(TaskQueue *queue, Task task) {
+bool push_task(TaskQueue *queue, Task task) {
 
+    unsigned long trace_start_ns = trace_begin();
+    TaskQueueLane *lane = &queue->lanes[task_lane(task.type)];
+    unsigned long enqueue_ns = sample_enqueue_ns(lane);
     pthread_mutex_lock(&queue->lock);
-    const int size = queue->size;
-    // 큐가 가득 찬 경우 처리
-    if ((queue->rear + 1) % size == queue->front) {
-        perror("Task queue is full! Dropping task.\n");
+    // 레인이 가득 찬 경우 처리
+    if (lane_full(queue, lane)) {
         pthread_mutex_unlock(&queue->lock);
-        return;
+        // 드롭은 메트릭으로 집계하고, 로그는 처음과 1024번마다 한 번만 남긴다
+        atomic_fetch_add_explicit(&lane->dropped, 1, memory_order_relaxed);
+        unsigned long dropped = atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+        if ((dropped & 1023) == 0) {
+            LOG_WARN("Task queue '%s' is full! Dropping task. (총 %lu개)", queue->name, dropped + 1);
+        }
+        trace_end(queue->push_event, trace_start_ns, task.type);
+        return false;
     }
 
-    queue->tasks[queue->rear] = task;                 // 작업 추가
-    queue->rear = (queue->rear + 1) % size;     // rear 포인터 이동
+    lane_push(queue, lane, task, enqueue_ns);
+    pthread_mutex_unlock(&queue->lock);
+    trace_end(queue->push_event, trace_start_ns, task.type);
+    return true;
+}
+
+void push_task_wait(TaskQueue *queue, Task task) {
+
+    unsigned long trace_start_ns = trace_begin();
+    TaskQueueLane *lane = &queue->lanes[task_lane(task.type)];
+    unsigned long enqueue_ns = sample_enqueue_ns(lane);
+    pthread_mutex_lock(&queue->lock);
+    while (lane_full(queue, lane)) {
+        queue->push_waiters++;
+        pthread_cond_wait(&queue->space, &queue->lock);
+        queue->push_waiters--;
+    }
 
-    pthread_cond_signal(&queue->cond);               // 대기 중인 스레드에 신호
+    lane_push(queue, lane, task, enqueue_ns);
     pthread_mutex_unlock(&queue->lock);
+    trace_end(queue->push_event, trace_start_ns, task.type);
 }
 
-// 큐에서 작업을 가져오기
-Task pop_task(TaskQueue *queue) {
+// 락을 잡은 채로 비어 있지 않은 큐에서 작업 하나를 꺼낸다 (락은 풀고 돌아온다)
+static Task take_task(TaskQueue *queue, unsigned long trace_start_ns) {
 
     const int size = queue->size;
+    TaskQueueLane *control = &queue->lanes[TASK_LANE_CONTROL];
+    TaskQueueLane *bulk = &queue->lanes[TASK_LANE_BULK];
+
+    // 제어 레인 우선, 대량 작업이 기다리는 동안 제어 작업을 weight개 꺼냈으면 대량 작업 하나 (굶지 않도록)
+    TaskQueueLane *lane = control;
+    if (lane_empty(control) || (!lane_empty(bulk) && queue->weight > 0 && queue->control_streak >= queue->weight)) {
+        lane = bulk;
+    }
+    if (lane == control && !lane_empty(bulk)) {
+        queue->control_streak++;
+    } else {
+        queue->control_streak = 0;
+    }
+
+    Task task = lane->tasks[lane->front];           // 작업 가져오기
+    unsigned long enqueue_ns = lane->enqueue_ns[lane->front];
+    lane->front = (lane->front + 1) % size;         // front 포인터 이동
+    if (queue->push_waiters > 0) {
+        // 기다리는 스레드가 어느 레인에 넣으려는지 모르므로 모두 깨운다 (드문 경우)
+        pthread_cond_broadcast(&queue->space);
+    }
 
+    pthread_mutex_unlock(&queue->lock);
+    if (enqueue_ns != 0) {
+        histogram_record(&lane->wait, monotonic_ns() - enqueue_ns);
+    }
+    trace_end(queue->pop_event, trace_start_ns, task.type);    // 빈 큐에서 기다린 시간 포함
+    return task;
+}
+
+static bool queue_empty(TaskQueue *queue) {
+    return lane_empty(&queue->lanes[TASK_LANE_CONTROL]) && lane_empty(&queue->lanes[TASK_LANE_BULK]);
+}
+
+// 큐에서 작업을 가져오기
+Task pop_task(TaskQueue *queue) {
+
+    unsigned long trace_start_ns = trace_begin();
     pthread_mutex_lock(&queue->lock);
 
     // 큐가 비어 있는 경우 대기
-    while (queue->front == queue->rear) {
+    while (queue_empty(queue)) {
         pthread_cond_wait(&queue->cond, &queue->lock);
     }
+    return take_task(queue, trace_start_ns);
+}
+
+bool pop_task_timeout(TaskQueue *queue, Task *task, int timeout_ms) {
+
+    if (timeout_ms < 0) {
+        *task = pop_task(queue);
+        return true;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    unsigned long trace_start_ns = trace_begin();
+    pthread_mutex_lock(&queue->lock);
+    while (queue_empty(queue)) {
+        if (pthread_cond_timedwait(&queue->cond, &queue->lock, &deadline) == ETIMEDOUT && queue_empty(queue)) {
+            pthread_mutex_unlock(&queue->lock);
+            return false;
+        }
+    }
+    *task = take_task(queue, trace_start_ns);
+    return true;
+}
 
-    Task task = queue->tasks[queue->front];           // 작업 가져오기
-    queue->front = (queue->front + 1) % size;         // front 포인터 이동
+// 큐에 쌓인 작업 수
+int task_queue_depth(TaskQueue *queue) {
 
+    pthread_mutex_lock(&queue->lock);
+    int depth = 0;
+    for (int i = 0; i < TASK_LANE_COUNT; i++) {
+        depth += (queue->lanes[i].rear - queue->lanes[i].front + queue->size) % queue->size;
+    }
     pthread_mutex_unlock(&queue->lock);
-    return task;
+    return depth;
+}
+
+int task_queue_lane_depth(TaskQueue *queue, TaskLane lane) {
+
+    pthread_mutex_lock(&queue->lock);
+    int depth = (queue->lanes[lane].rear - queue->lanes[lane].front + queue->size) % queue->size;
+    pthread_mutex_unlock(&queue->lock);
+    return depth;
 }
 
 // 작업 큐 파괴 함수
@@ -56,8 +241,12 @@ void destroy_task_queue(TaskQueue *queue) {
 
     pthread_mutex_destroy(&queue->lock);
     pthread_cond_destroy(&queue->cond);
+    pthread_cond_destroy(&queue->space);
 
-    free(queue->tasks);
+    for (int i = 0; i < TASK_LANE_COUNT; i++) {
+        free(queue->lanes[i].tasks);
+        free(queue->lanes[i].enqueue_ns);
+    }
     free(queue);
 
-}
\ No newline at end of file
+}
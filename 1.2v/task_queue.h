@@ -2,7 +2,10 @@
 #define TASK_QUEUE_H
 
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include "histogram.h"
 
 typedef enum {
     TASK_NEW_CLIENT,                // 새로운 클라이언트가 접속 요청하는 경우
@@ -15,7 +18,21 @@ typedef enum {
     TASK_MESSAGE_INCOMPLETE_FRAME,       // 메세지가 불완전함(조각남, frame)
     TASK_FRAME_MESSAGE,             // frame 메세지 요청(완전함, 혹은 마지막 조각임)
     TASK_UNKNOWN_MESSAGE,           // 알수없는 형식(http 조각 일 수 있음)
-    TASK_INIT_CANAVAS
+    TASK_INIT_CANAVAS,
+    TASK_STATIC_RELOAD,             // 정적 파일 디렉토리 변경(inotify)
+    TASK_TIMER_TICK,                // 1초 주기 타이머
+    TASK_REGISTER_CLIENT,           // 이미 연결된 소켓 등록 (accept 없이, 시뮬레이션용)
+    TASK_HTTP_DONE,                 // 작업 풀이 HTTP 요청 하나에 응답을 끝냄 (CM)
+    TASK_SNAPSHOT_DONE,             // 작업 풀이 초기 스냅샷을 보낼 준비를 끝냄 (캔버스)
+    TASK_CLIENT_WRITABLE,           // 송신 대기열이 남은 소켓에 다시 쓸 수 있음 (EPOLLOUT)
+    TASK_RESYNC_CLIENT,             // 변경분을 버린 느린 클라이언트에게 새 스냅샷 (캔버스)
+    TASK_HANDOFF,                   // 무중단 재시작: 새 프로세스에 넘겨주기 (main -> CM -> 캔버스 -> CM)
+    TASK_ADOPT_CLIENT,              // 무중단 재시작: 이전 프로세스에서 받은 클라이언트 등록 (CM)
+    TASK_RESTORE_DIRTY,             // 무중단 재시작: 이전 프로세스가 브로드캐스트하지 못한 픽셀 표시 (캔버스)
+    TASK_WEBSOCKET_PING,            // 클라이언트가 보낸 ping (같은 페이로드로 pong)
+    TASK_WEBSOCKET_PONG,            // 서버가 보낸 ping의 답
+    TASK_SEND_FAILED,               // 송신 스레드가 브로드캐스트를 보내다 실패한 클라이언트 (CM이 제거)
+    TASK_ZEROCOPY_COMPLETE          // 소켓 오류 큐에 MSG_ZEROCOPY 완료 알림 (EPOLLERR, CM이 frame 참조를 놓는다)
 }TaskType;
 
 // 작업(Task) 구조체
@@ -24,26 +41,76 @@ typedef struct {
     TaskType type;     // 작업 유형
     void *data;        // 클라이언트로부터 받은 데이터 (예: JSON)
     ssize_t data_len;  // 데이터 길이
+    unsigned long recv_ns;  // 소켓에서 읽은 시각 (monotonic ns, 0이면 측정하지 않음)
+    unsigned int gen;       // 메인 스레드가 읽은 연결의 세대 (conn_input, 0이면 확인하지 않음)
 } Task;
 
-// 작업 큐(Task Queue) 구조체
+// 우선순위 레인: 접속/제어 작업이 대량의 픽셀/브로드캐스트 작업 뒤에서 기다리지 않도록 나눈다
+// 같은 레인 안에서는 FIFO. 한 클라이언트의 순서가 중요한 작업(HTTP 조각들, frame과 종료, 스냅샷과 브로드캐스트)은 같은 레인에 둔다.
+typedef enum {
+    TASK_LANE_CONTROL,      // 접속, 핸드셰이크, 작업 풀 완료, 타이머
+    TASK_LANE_BULK,         // 픽셀 메세지와 그 연결의 종료, 브로드캐스트, 스냅샷 전송
+    TASK_LANE_COUNT
+} TaskLane;
+
+#define TASK_LANE_DEFAULT_WEIGHT 8  // 둘 다 쌓여 있으면 제어 작업 8개마다 대량 작업 1개, FAINTER_LANE_WEIGHT 로 변경 (0이면 엄격한 우선순위)
+
+#define TASK_LANE_BULK_SAMPLE 16    // 대량 레인은 스레드마다 16번 push에 한 번만 대기 시간을 잰다 (제어 레인은 모두, 2의 거듭제곱)
+
+// 레인 하나 (고정 크기 링)
 typedef struct {
-    Task *tasks; // 작업 배열 (고정 크기 큐)
+    Task *tasks;
+    unsigned long *enqueue_ns;  // 넣은 시각 (재지 않는 작업은 0)
+    unsigned int sample_mask;   // 시계 호출과 히스토그램 기록 비용을 줄이는 표본 주기 - 1
     int front, rear;        // 큐의 앞(front)과 뒤(rear) 인덱스
+    atomic_ulong dropped;   // 레인이 가득 차서 버린 작업 수
+    Histogram wait;         // push -> pop 대기 시간 (ns, 표본)
+} TaskQueueLane;
+
+// 작업 큐(Task Queue) 구조체
+typedef struct {
+    TaskQueueLane lanes[TASK_LANE_COUNT];
+    int weight;             // 대량 작업 하나를 꺼내기 전에 연속으로 꺼낼 수 있는 제어 작업 수 (0이면 제한 없음)
+    int control_streak;     // 대량 작업이 기다리는 동안 연속으로 꺼낸 제어 작업 수
     pthread_mutex_t lock;   // 뮤텍스
     pthread_cond_t cond;    // 조건 변수
-    int size;
+    pthread_cond_t space;   // 자리가 나기를 기다리는 push_task_wait용
+    int push_waiters;       // space에서 기다리는 스레드 수
+    int size;               // 레인마다의 링 크기
+    const char *name;       // 메트릭 이름 ("cm", "canvas")
+    atomic_ulong pushed;    // 누적 push 수 (모든 레인)
+    atomic_ulong dropped;   // 큐가 가득 차서 버린 작업 수 (모든 레인)
+    char push_event[24];    // 트레이스 이벤트 이름 ("push cm")
+    char pop_event[24];     // 트레이스 이벤트 이름 ("pop cm")
 } TaskQueue;
 
+// 작업 유형이 들어갈 레인
+TaskLane task_lane(TaskType type);
+const char *task_lane_name(TaskLane lane);
+
 // 작업 큐 초기화 함수
-void init_task_queue(TaskQueue *queue, int size);
+void init_task_queue(TaskQueue *queue, int size, const char *name);
+
+// 현재 큐에 쌓인 작업 수 (모든 레인)
+int task_queue_depth(TaskQueue *queue);
 
-// 작업을 큐에 추가하는 함수
-void push_task(TaskQueue *queue, Task task);
+// 레인 하나에 쌓인 작업 수
+int task_queue_lane_depth(TaskQueue *queue, TaskLane lane);
 
-// 작업을 큐에서 가져오는 함수
+// 작업을 큐에 추가하는 함수 (가득 차 있으면 버리고 false, 기다리지 않는다)
+bool push_task(TaskQueue *queue, Task task);
+
+// 가득 차 있으면 자리가 날 때까지 기다렸다가 추가 (작업 풀의 완료 통지처럼 버리면 안 되는 작업)
+// 큐를 소비하는 스레드 자신은 부르면 안 된다.
+void push_task_wait(TaskQueue *queue, Task task);
+
+// 작업을 큐에서 가져오는 함수 (제어 레인 우선, weight개마다 대량 레인 하나)
 Task pop_task(TaskQueue *queue);
 
+// pop_task와 같지만 timeout_ms 동안 작업이 없으면 false (음수면 올 때까지 기다린다)
+// 작업이 없어도 주기적으로 할 일이 있는 소비 스레드용 (캔버스의 브로드캐스트 틱)
+bool pop_task_timeout(TaskQueue *queue, Task *task, int timeout_ms);
+
 // 작업 큐 삭제 함수
 void destroy_task_queue(TaskQueue *queue);
 
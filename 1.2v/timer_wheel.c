@@ -0,0 +1,75 @@
+#include "timer_wheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+void timer_wheel_init(TimerWheel *wheel, unsigned long now) {
+
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slots[i].next = &wheel->slots[i];
+        wheel->slots[i].prev = &wheel->slots[i];
+    }
+    wheel->now = now;
+    wheel->count = 0;
+}
+
+static void unlink_node(TimerWheel *wheel, TimerNode *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+    wheel->count--;
+}
+
+void timer_schedule(TimerWheel *wheel, TimerNode *node, unsigned long expires) {
+
+    if (timer_pending(node)) {
+        unlink_node(wheel, node);
+    }
+    if (expires <= wheel->now) {
+        expires = wheel->now + 1;
+    }
+    node->expires = expires;
+
+    // 칸의 맨 앞에 넣는다 (만료 처리 중에 같은 칸으로 다시 예약해도 이번 순회에서 다시 만나지 않는다)
+    TimerNode *head = &wheel->slots[expires & TIMER_WHEEL_MASK];
+    node->prev = head;
+    node->next = head->next;
+    head->next->prev = node;
+    head->next = node;
+    wheel->count++;
+}
+
+void timer_cancel(TimerWheel *wheel, TimerNode *node) {
+    if (timer_pending(node)) {
+        unlink_node(wheel, node);
+    }
+}
+
+size_t timer_wheel_advance(TimerWheel *wheel, unsigned long now, TimerCallback callback, void *arg) {
+
+    if (now <= wheel->now) {
+        return 0;
+    }
+
+    // 한 바퀴 넘게 밀렸으면 (tick을 오래 놓쳤다) 모든 칸을 한 번씩만 본다
+    unsigned long from = wheel->now;
+    unsigned long ticks = now - from < TIMER_WHEEL_SLOTS ? now - from : TIMER_WHEEL_SLOTS;
+    // 콜백에서 다시 예약하는 타이머는 now 이후로 가도록 먼저 옮겨 둔다
+    wheel->now = now;
+
+    size_t fired = 0;
+    for (unsigned long tick = from + 1; tick <= from + ticks; tick++) {
+        TimerNode *head = &wheel->slots[tick & TIMER_WHEEL_MASK];
+        TimerNode *node = head->next;
+        while (node != head) {
+            TimerNode *next = node->next;
+            if (node->expires <= now) {
+                unlink_node(wheel, node);
+                callback(node, arg);
+                fired++;
+            }
+            node = next;
+        }
+    }
+    return fired;
+}
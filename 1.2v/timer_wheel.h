@@ -0,0 +1,51 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// 해시 타이밍 휠
+// 만료 tick을 칸 수로 나눈 나머지 칸에 이중 연결 리스트로 매단다. 예약과 취소는 O(1)이고,
+// tick이 지날 때 그 칸만 훑는다 (한 바퀴보다 먼 타이머는 만료 tick이 될 때까지 건너뛴다).
+// 노드는 구조체에 넣어 쓰므로 (Client.timer) 타이머마다 할당이나 fd가 없다.
+// 한 스레드에서만 쓴다 (CM).
+
+#define TIMER_WHEEL_SLOTS 256       // 2의 거듭제곱
+
+typedef struct TimerNode {
+    struct TimerNode *next;
+    struct TimerNode *prev;         // NULL이면 예약되지 않음
+    unsigned long expires;          // 만료 tick
+} TimerNode;
+
+typedef struct {
+    TimerNode slots[TIMER_WHEEL_SLOTS];     // 칸마다 원형 리스트의 머리
+    unsigned long now;                      // 마지막으로 처리한 tick
+    size_t count;                           // 예약된 타이머 수
+} TimerWheel;
+
+// 만료된 타이머 처리 (노드는 이미 휠에서 빠져 있다, 자기 노드만 다시 예약하거나 해제할 수 있다)
+typedef void (*TimerCallback)(TimerNode *node, void *arg);
+
+void timer_wheel_init(TimerWheel *wheel, unsigned long now);
+
+static inline void timer_node_init(TimerNode *node) {
+    node->next = NULL;
+    node->prev = NULL;
+    node->expires = 0;
+}
+
+static inline bool timer_pending(const TimerNode *node) {
+    return node->prev != NULL;
+}
+
+// expires tick에 만료되도록 예약 (이미 예약되어 있으면 옮긴다, 지난 tick이면 다음 tick)
+void timer_schedule(TimerWheel *wheel, TimerNode *node, unsigned long expires);
+
+// 예약 취소 (예약되지 않았으면 아무것도 하지 않는다)
+void timer_cancel(TimerWheel *wheel, TimerNode *node);
+
+// now tick까지 만료된 타이머를 모두 처리하고 처리한 수를 반환
+size_t timer_wheel_advance(TimerWheel *wheel, unsigned long now, TimerCallback callback, void *arg);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,871 @@
+// WebSocket 부하 생성기 (epoll, 스레드마다 epoll 하나)
+// 연결 N개를 열고 그중 일부는 일정한 속도로 픽셀을 칠하고(painter), 나머지는 브로드캐스트만 받는다(viewer).
+// painter는 캔버스 칸을 차례대로 돌며 칠하므로, 브로드캐스트로 돌아온 픽셀의 좌표로 보낸 시각을 찾아
+// 전달 지연 시간을 잰다 (캔버스를 한 바퀴 돌기 전까지는 같은 칸을 다시 칠하지 않는다).
+//
+// 사용법: ./tools/loadgen [-a 주소] [-p 포트] [-c 연결 수] [-P painter 수] [-r painter당 초당 픽셀]
+//                        [-d 실행 시간(초)] [-R 초당 연결 수(0이면 한 번에)] [-t 스레드 수]
+//                        [-W 캔버스 너비] [-H 캔버스 높이] [-o CSV 파일]
+//                        [-m json|bin3|bin5] [-S 서브프로토콜] [-O 요약 CSV 파일]
+//
+// -m은 서버 세대별 픽셀 프로토콜:
+//   json  1.2v            {"pixel":{"x":..,"y":..,"color":"#rrggbb"}} 텍스트 frame
+//   bin3  1.libwebsocket, 2.multithreading   x(1) y(1) color(1) 바이너리 frame
+//   bin5  3.epoll_clicnt  x(2, LE) y(2, LE) color(1), 브로드캐스트는 타입 바이트 0x01이 앞에 붙는다
+// -O는 실행 결과를 한 줄로 덧붙인다 (파일이 비어 있으면 헤더도 쓴다, 서버 비교 스크립트용)
+//
+// CSV는 total.py와 같은 형식 (timestamp,client_count,elapsed_time_ms)에 초당 paints, deliveries 열을 덧붙인다.
+// elapsed_time_ms는 그 1초 동안 전달된 픽셀의 평균 지연 시간이고, 전달이 없었던 초는 비워둔다.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "histogram.h"
+
+#define LOADGEN_MAX_EVENTS 1024
+#define LOADGEN_RECV_SIZE (64 * 1024)
+#define LOADGEN_OUT_SIZE 256            // 핸드셰이크 요청, 픽셀 frame 하나가 들어가는 크기
+#define LOADGEN_HEADER_MAX 4096         // 101 응답 헤더 최대 크기
+#define LOADGEN_OPEN_BATCH 256          // 한 번의 루프에서 새로 여는 연결 수
+
+typedef enum {
+    PROTO_JSON,
+    PROTO_BIN3,
+    PROTO_BIN5
+} Protocol;
+
+typedef enum {
+    CONN_IDLE,                  // 아직 연결 안 함
+    CONN_CONNECTING,            // connect 진행 중
+    CONN_HANDSHAKE,             // 101 응답 대기
+    CONN_OPEN,                  // WebSocket 연결됨
+    CONN_CLOSED
+} ConnState;
+
+typedef struct {
+    int fd;
+    ConnState state;
+    bool painter;
+    bool joined;                // 초기 캔버스 스냅샷을 다 받았는지
+    unsigned long connect_ns;   // connect 시작 시각
+    unsigned char *buf;         // 받은 데이터 중 아직 처리 못한 부분
+    size_t len, cap;
+    unsigned long skip;         // 읽고 버릴 바이트 수 (스냅샷 본문)
+    char out[LOADGEN_OUT_SIZE]; // 보내지 못한 데이터
+    size_t out_len, out_off;
+} Conn;
+
+typedef struct {
+    int id;
+    pthread_t tid;
+    int epoll_fd;
+    Conn *conns;                // 이 스레드가 맡은 연결
+    int count;
+    int opened;                 // connect를 시작한 연결 수
+    int *painters;              // painter 연결 번호
+    int painter_count;
+    int painter_cursor;         // 다음에 칠할 painter (라운드 로빈)
+    unsigned long painted;      // 지금까지 보낸(또는 건너뛴) 칠하기 횟수
+
+    Histogram handshake;        // connect -> 101 응답
+    Histogram snapshot;         // connect -> 초기 스냅샷 수신 완료
+    Histogram latency;          // 픽셀 전송 -> 브로드캐스트 수신
+
+    atomic_ulong paints;        // 보낸 픽셀 수
+    atomic_ulong skipped;       // 소켓이 막혀서 건너뛴 픽셀 수
+    atomic_ulong deliveries;    // 받은 (자기가 보낸 것으로 확인된) 픽셀 수
+    atomic_ulong latency_sum;   // deliveries의 지연 시간 합 (ns)
+    atomic_ulong bytes_in;
+    atomic_ulong failed;        // 연결/핸드셰이크 실패
+    atomic_ulong closed;        // 서버가 끊은 연결
+} Worker;
+
+// 실행 옵션
+static struct {
+    struct sockaddr_in addr;
+    char host[64];
+    int port;
+    int connections;
+    int painters;
+    double rate;
+    int duration;
+    double ramp;
+    int threads;
+    int width, height;
+    const char *csv_path;
+    Protocol protocol;
+    const char *subprotocol;    // Sec-WebSocket-Protocol (없으면 NULL)
+    const char *summary_path;
+} config = {
+    .host = "127.0.0.1",
+    .port = 8080,
+    .connections = 100,
+    .painters = 10,
+    .rate = 1.0,
+    .duration = 30,
+    .ramp = 0,
+    .threads = 1,
+    .width = 500,
+    .height = 500,
+    .csv_path = "loadgen_log.csv",
+    .protocol = PROTO_JSON,
+};
+
+static atomic_int stop = 0;
+static atomic_int open_connections = 0;
+static atomic_ulong next_seq = 0;
+static atomic_ulong *sent_ns;           // 캔버스 칸 -> 마지막으로 칠한 시각
+static unsigned long start_ns;
+
+static unsigned long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static void handle_signal(int sig) {
+    (void)sig;
+    atomic_store(&stop, 1);
+}
+
+static void close_conn(Worker *w, Conn *c, bool failed) {
+
+    if (c->state == CONN_CLOSED || c->state == CONN_IDLE) {
+        return;
+    }
+    if (c->state == CONN_OPEN) {
+        atomic_fetch_sub(&open_connections, 1);
+        if (!atomic_load(&stop)) {
+            atomic_fetch_add_explicit(&w->closed, 1, memory_order_relaxed);
+        }
+    }
+    if (failed) {
+        atomic_fetch_add_explicit(&w->failed, 1, memory_order_relaxed);
+    }
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->state = CONN_CLOSED;
+    free(c->buf);
+    c->buf = NULL;
+    c->len = c->cap = 0;
+}
+
+// 보내지 못한 데이터 전송, 다 보내면 EPOLLOUT 감시를 끈다
+static void flush_out(Worker *w, Conn *c) {
+
+    while (c->out_off < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.ptr = c};
+                epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+                return;
+            }
+            close_conn(w, c, c->state != CONN_OPEN);
+            return;
+        }
+        c->out_off += n;
+    }
+    c->out_len = c->out_off = 0;
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+    epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+// 클라이언트 frame 작성 (클라이언트는 반드시 마스킹해야 한다)
+static size_t build_client_frame(char *out, uint8_t opcode, const char *payload, size_t len, uint32_t mask) {
+
+    size_t off = 0;
+    out[off++] = (char)(0x80 | opcode);
+    if (len < 126) {
+        out[off++] = (char)(0x80 | len);
+    } else {
+        out[off++] = (char)(0x80 | 126);
+        out[off++] = (char)((len >> 8) & 0xFF);
+        out[off++] = (char)(len & 0xFF);
+    }
+    unsigned char key[4] = {mask >> 24, mask >> 16, mask >> 8, mask};
+    memcpy(out + off, key, 4);
+    off += 4;
+    for (size_t i = 0; i < len; i++) {
+        out[off + i] = payload[i] ^ key[i % 4];
+    }
+    return off + len;
+}
+
+static void open_conn(Worker *w, Conn *c) {
+
+    c->connect_ns = monotonic_ns();
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd == -1) {
+        perror("socket");
+        c->state = CONN_CLOSED;
+        atomic_fetch_add_explicit(&w->failed, 1, memory_order_relaxed);
+        return;
+    }
+    int flag = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+    if (connect(c->fd, (struct sockaddr *)&config.addr, sizeof(config.addr)) == -1 && errno != EINPROGRESS) {
+        c->state = CONN_CONNECTING;
+        close_conn(w, c, true);
+        return;
+    }
+    c->state = CONN_CONNECTING;
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.ptr = c};
+    if (epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, c->fd, &ev) == -1) {
+        perror("epoll_ctl");
+        close(c->fd);
+        c->fd = -1;
+        c->state = CONN_CLOSED;
+        atomic_fetch_add_explicit(&w->failed, 1, memory_order_relaxed);
+    }
+}
+
+// connect 완료 -> 업그레이드 요청 전송
+static void start_handshake(Worker *w, Conn *c) {
+
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) == -1 || err != 0) {
+        close_conn(w, c, true);
+        return;
+    }
+    c->state = CONN_HANDSHAKE;
+    int n = snprintf(c->out, sizeof(c->out),
+                     "GET / HTTP/1.1\r\n"
+                     "Host: %s:%d\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n"
+                     "%s%s%s"
+                     "\r\n",
+                     config.host, config.port,
+                     config.subprotocol ? "Sec-WebSocket-Protocol: " : "",
+                     config.subprotocol ? config.subprotocol : "",
+                     config.subprotocol ? "\r\n" : "");
+    c->out_len = (size_t)n;
+    c->out_off = 0;
+    flush_out(w, c);
+}
+
+static bool append_buffer(Conn *c, const unsigned char *data, size_t n) {
+
+    if (c->len + n > c->cap) {
+        size_t cap = c->cap ? c->cap : 4096;
+        while (cap < c->len + n) {
+            cap *= 2;
+        }
+        unsigned char *buf = realloc(c->buf, cap);
+        if (buf == NULL) {
+            return false;
+        }
+        c->buf = buf;
+        c->cap = cap;
+    }
+    memcpy(c->buf + c->len, data, n);
+    c->len += n;
+    return true;
+}
+
+static void record_join(Worker *w, Conn *c) {
+    c->joined = true;
+    histogram_record(&w->snapshot, monotonic_ns() - c->connect_ns);
+}
+
+// 브로드캐스트로 돌아온 칸 하나의 지연 시간 기록
+static inline void record_delivery(Worker *w, unsigned long x, unsigned long y, unsigned long now,
+                                   unsigned long *count, unsigned long *sum) {
+
+    if (x >= (unsigned long)config.width || y >= (unsigned long)config.height) {
+        return;
+    }
+    unsigned long sent = atomic_load_explicit(&sent_ns[y * config.width + x], memory_order_relaxed);
+    if (sent != 0 && sent <= now) {
+        histogram_record(&w->latency, now - sent);
+        (*count)++;
+        *sum += now - sent;
+    }
+}
+
+// "key":숫자 를 찾아 값을 읽는다 (못 찾으면 NULL)
+static const unsigned char *json_number(const unsigned char *p, const unsigned char *end,
+                                        const char *key, size_t key_len, unsigned long *value) {
+
+    p = memmem(p, end - p, key, key_len);
+    if (p == NULL) {
+        return NULL;
+    }
+    p += key_len;
+    if (p >= end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    unsigned long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (unsigned long)(*p - '0');
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// 브로드캐스트 본문에서 칠해진 칸을 찾아 지연 시간 기록
+static void record_deliveries(Worker *w, const unsigned char *payload, size_t len) {
+
+    unsigned long now = monotonic_ns();
+    unsigned long count = 0, sum = 0;
+    const unsigned char *end = payload + len;
+
+    switch (config.protocol) {
+        case PROTO_JSON: {
+            // {"client_count":N,"updated_pixel":[{"x":..,"y":..,"color":".."},...]}
+            const unsigned char *p = payload;
+            unsigned long x, y;
+            while ((p = json_number(p, end, "\"x\":", 4, &x)) != NULL &&
+                   (p = json_number(p, end, "\"y\":", 4, &y)) != NULL) {
+                record_delivery(w, x, y, now, &count, &sum);
+            }
+            break;
+        }
+        case PROTO_BIN3:
+            for (size_t i = 0; i + 3 <= len; i += 3) {
+                record_delivery(w, payload[i], payload[i + 1], now, &count, &sum);
+            }
+            break;
+        case PROTO_BIN5:
+            // 0x01: 픽셀 업데이트, 0x02: 동접자 수
+            if (len == 0 || payload[0] != 0x01) {
+                break;
+            }
+            for (size_t i = 1; i + 5 <= len; i += 5) {
+                unsigned long x = payload[i] | (payload[i + 1] << 8);
+                unsigned long y = payload[i + 2] | (payload[i + 3] << 8);
+                record_delivery(w, x, y, now, &count, &sum);
+            }
+            break;
+    }
+
+    if (count > 0) {
+        atomic_fetch_add_explicit(&w->deliveries, count, memory_order_relaxed);
+        atomic_fetch_add_explicit(&w->latency_sum, sum, memory_order_relaxed);
+    }
+}
+
+static void handle_frame(Worker *w, Conn *c, uint8_t opcode, const unsigned char *payload, size_t len) {
+
+    if (!c->joined) {
+        record_join(w, c);      // 첫 frame은 초기 캔버스 스냅샷
+        return;
+    }
+    switch (opcode) {
+        case 0x1:
+        case 0x2:
+            record_deliveries(w, payload, len);
+            break;
+        case 0x8:
+            close_conn(w, c, false);
+            break;
+        case 0x9:
+            // ping -> pong (보낼 데이터가 남아 있으면 생략)
+            if (c->out_len == 0 && len <= 125) {
+                c->out_len = build_client_frame(c->out, 0xA, (const char *)payload, len, 0);
+                c->out_off = 0;
+                flush_out(w, c);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// 버퍼에 모인 frame 처리
+static void parse_frames(Worker *w, Conn *c) {
+
+    size_t off = 0;
+    while (c->state == CONN_OPEN && c->len - off >= 2) {
+        const unsigned char *b = c->buf + off;
+        size_t avail = c->len - off;
+        uint8_t opcode = b[0] & 0x0F;
+        unsigned long payload_len = b[1] & 0x7F;
+        size_t header_len = 2;
+
+        if (payload_len == 126) {
+            header_len = 4;
+            if (avail < header_len) break;
+            payload_len = ((unsigned long)b[2] << 8) | b[3];
+        } else if (payload_len == 127) {
+            header_len = 10;
+            if (avail < header_len) break;
+            payload_len = 0;
+            for (int i = 0; i < 8; i++) {
+                payload_len = (payload_len << 8) | b[2 + i];
+            }
+        }
+        if (b[1] & 0x80) {
+            header_len += 4;        // 서버는 마스킹하지 않지만 혹시 모르니 건너뛴다
+            if (avail < header_len) break;
+        }
+
+        // 스냅샷은 크기가 크므로 버퍼에 모으지 않고 읽으면서 버린다
+        if (!c->joined && payload_len > avail - header_len) {
+            c->skip = payload_len - (avail - header_len);
+            off = c->len;
+            break;
+        }
+        if (avail - header_len < payload_len) {
+            break;
+        }
+        handle_frame(w, c, opcode, b + header_len, payload_len);
+        off += header_len + payload_len;
+    }
+
+    if (c->state != CONN_OPEN) {
+        return;
+    }
+    if (off > 0) {
+        memmove(c->buf, c->buf + off, c->len - off);
+        c->len -= off;
+    }
+}
+
+static void feed_frames(Worker *w, Conn *c, const unsigned char *data, size_t n) {
+
+    while (n > 0 && c->state == CONN_OPEN) {
+        if (c->skip > 0) {
+            size_t take = n < c->skip ? n : c->skip;
+            c->skip -= take;
+            data += take;
+            n -= take;
+            if (c->skip == 0) {
+                record_join(w, c);
+            }
+            continue;
+        }
+        if (!append_buffer(c, data, n)) {
+            fprintf(stderr, "수신 버퍼 할당 실패\n");
+            close_conn(w, c, false);
+            return;
+        }
+        n = 0;
+        parse_frames(w, c);
+    }
+}
+
+// 101 응답 헤더 처리, 나머지는 frame으로 넘긴다
+static void feed_handshake(Worker *w, Conn *c, const unsigned char *data, size_t n) {
+
+    if (!append_buffer(c, data, n)) {
+        close_conn(w, c, true);
+        return;
+    }
+    unsigned char *end = memmem(c->buf, c->len, "\r\n\r\n", 4);
+    if (end == NULL) {
+        if (c->len > LOADGEN_HEADER_MAX) {
+            close_conn(w, c, true);
+        }
+        return;
+    }
+    if (c->len < 12 || memcmp(c->buf, "HTTP/1.1 101", 12) != 0) {
+        close_conn(w, c, true);
+        return;
+    }
+    histogram_record(&w->handshake, monotonic_ns() - c->connect_ns);
+    c->state = CONN_OPEN;
+    atomic_fetch_add(&open_connections, 1);
+
+    size_t header_len = (size_t)(end - c->buf) + 4;
+    size_t rest = c->len - header_len;
+    unsigned char *buf = c->buf;
+    c->buf = NULL;
+    c->len = c->cap = 0;
+    feed_frames(w, c, buf + header_len, rest);
+    free(buf);
+}
+
+static void handle_readable(Worker *w, Conn *c, unsigned char *recv_buf) {
+
+    while (c->state == CONN_HANDSHAKE || c->state == CONN_OPEN) {
+        ssize_t n = recv(c->fd, recv_buf, LOADGEN_RECV_SIZE, 0);
+        if (n > 0) {
+            atomic_fetch_add_explicit(&w->bytes_in, n, memory_order_relaxed);
+            if (c->state == CONN_HANDSHAKE) {
+                feed_handshake(w, c, recv_buf, n);
+            } else {
+                feed_frames(w, c, recv_buf, n);
+            }
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        close_conn(w, c, c->state == CONN_HANDSHAKE);
+        return;
+    }
+}
+
+// painter 하나가 픽셀 하나 전송 (좌표는 일련번호 순서라 캔버스를 한 바퀴 돌 때까지 겹치지 않는다)
+static void paint(Worker *w, Conn *c) {
+
+    if (c->out_len != 0) {
+        atomic_fetch_add_explicit(&w->skipped, 1, memory_order_relaxed);
+        return;
+    }
+    unsigned long seq = atomic_fetch_add_explicit(&next_seq, 1, memory_order_relaxed);
+    unsigned long cell = seq % ((unsigned long)config.width * config.height);
+    unsigned long x = cell % config.width, y = cell / config.width;
+    char payload[96];
+    size_t len;
+    uint8_t opcode = 0x2;
+
+    switch (config.protocol) {
+        case PROTO_JSON:
+            len = (size_t)snprintf(payload, sizeof(payload), "{\"pixel\":{\"x\":%lu,\"y\":%lu,\"color\":\"#%06lx\"}}",
+                                   x, y, seq & 0xFFFFFF);
+            opcode = 0x1;
+            break;
+        case PROTO_BIN3:
+            payload[0] = (char)x;
+            payload[1] = (char)y;
+            payload[2] = (char)(seq % 30);     // 색상 인덱스
+            len = 3;
+            break;
+        case PROTO_BIN5:
+        default:
+            payload[0] = (char)(x & 0xFF);
+            payload[1] = (char)(x >> 8);
+            payload[2] = (char)(y & 0xFF);
+            payload[3] = (char)(y >> 8);
+            payload[4] = (char)(seq % 30);
+            len = 5;
+            break;
+    }
+
+    atomic_store_explicit(&sent_ns[cell], monotonic_ns(), memory_order_relaxed);
+    c->out_len = build_client_frame(c->out, opcode, payload, len, (uint32_t)seq * 2654435761u);
+    c->out_off = 0;
+    flush_out(w, c);
+    atomic_fetch_add_explicit(&w->paints, 1, memory_order_relaxed);
+}
+
+// 전체 painter 속도에 맞춰 밀린 만큼 칠한다
+static void paint_due(Worker *w, unsigned long now) {
+
+    if (w->painter_count == 0 || config.rate <= 0) {
+        return;
+    }
+    unsigned long due = (unsigned long)((now - start_ns) / 1e9 * config.rate * w->painter_count);
+    if (due - w->painted > (unsigned long)w->painter_count) {
+        w->painted = due - w->painter_count;      // 한 바퀴 이상 밀린 건 버린다
+    }
+    for (int tries = 0; w->painted < due && tries < w->painter_count; tries++) {
+        Conn *c = &w->conns[w->painters[w->painter_cursor]];
+        w->painter_cursor = (w->painter_cursor + 1) % w->painter_count;
+        if (c->state != CONN_OPEN || !c->joined) {
+            continue;
+        }
+        paint(w, c);
+        w->painted++;
+    }
+}
+
+static void *worker_thread(void *arg) {
+
+    Worker *w = (Worker *)arg;
+    struct epoll_event events[LOADGEN_MAX_EVENTS];
+    unsigned char *recv_buf = malloc(LOADGEN_RECV_SIZE);
+    if (recv_buf == NULL) {
+        fprintf(stderr, "수신 버퍼 할당 실패\n");
+        return NULL;
+    }
+
+    while (!atomic_load(&stop)) {
+        unsigned long now = monotonic_ns();
+
+        // 연결 속도 제한 (ramp)
+        int target = w->count;
+        if (config.ramp > 0) {
+            double allowed = (now - start_ns) / 1e9 * config.ramp / config.threads;
+            if (allowed < target) {
+                target = (int)allowed;
+            }
+        }
+        for (int i = 0; w->opened < target && i < LOADGEN_OPEN_BATCH; i++) {
+            open_conn(w, &w->conns[w->opened++]);
+        }
+
+        paint_due(w, now);
+
+        int timeout = (w->painter_count > 0 || w->opened < w->count) ? 1 : 100;
+        int n = epoll_wait(w->epoll_fd, events, LOADGEN_MAX_EVENTS, timeout);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            Conn *c = (Conn *)events[i].data.ptr;
+            if (c->state == CONN_CONNECTING) {
+                if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    start_handshake(w, c);
+                }
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flush_out(w, c);
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                handle_readable(w, c, recv_buf);
+            }
+        }
+    }
+
+    for (int i = 0; i < w->count; i++) {
+        close_conn(w, &w->conns[i], false);
+    }
+    free(recv_buf);
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "사용법: %s [-a 주소] [-p 포트] [-c 연결 수] [-P painter 수] [-r painter당 초당 픽셀]\n"
+            "          [-d 실행 시간(초)] [-R 초당 연결 수] [-t 스레드 수] [-W 너비] [-H 높이] [-o CSV 파일]\n"
+            "          [-m json|bin3|bin5] [-S 서브프로토콜] [-O 요약 CSV 파일]\n",
+            prog);
+}
+
+static void print_histogram(const char *name, Histogram *h) {
+    printf("%-22s n=%-10lu p50=%.3fms p99=%.3fms p999=%.3fms max=%.3fms\n", name,
+           atomic_load(&h->total),
+           histogram_percentile(h, 0.5) / 1e6, histogram_percentile(h, 0.99) / 1e6,
+           histogram_percentile(h, 0.999) / 1e6, atomic_load(&h->max) / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:p:c:P:r:d:R:t:W:H:o:m:S:O:")) != -1) {
+        switch (opt) {
+            case 'a': snprintf(config.host, sizeof(config.host), "%s", optarg); break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'c': config.connections = atoi(optarg); break;
+            case 'P': config.painters = atoi(optarg); break;
+            case 'r': config.rate = atof(optarg); break;
+            case 'd': config.duration = atoi(optarg); break;
+            case 'R': config.ramp = atof(optarg); break;
+            case 't': config.threads = atoi(optarg); break;
+            case 'W': config.width = atoi(optarg); break;
+            case 'H': config.height = atoi(optarg); break;
+            case 'o': config.csv_path = optarg; break;
+            case 'm':
+                if (strcmp(optarg, "json") == 0) config.protocol = PROTO_JSON;
+                else if (strcmp(optarg, "bin3") == 0) config.protocol = PROTO_BIN3;
+                else if (strcmp(optarg, "bin5") == 0) config.protocol = PROTO_BIN5;
+                else { usage(argv[0]); return 1; }
+                break;
+            case 'S': config.subprotocol = optarg; break;
+            case 'O': config.summary_path = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (config.connections <= 0 || config.threads <= 0 || config.width <= 0 || config.height <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (config.protocol == PROTO_BIN3 && (config.width > 256 || config.height > 256)) {
+        fprintf(stderr, "bin3 프로토콜은 좌표가 1바이트라서 캔버스가 256x256 이하여야 합니다\n");
+        return 1;
+    }
+    if (config.painters > config.connections) {
+        config.painters = config.connections;
+    }
+    if (config.threads > config.connections) {
+        config.threads = config.connections;
+    }
+
+    config.addr.sin_family = AF_INET;
+    config.addr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.host, &config.addr.sin_addr) != 1) {
+        fprintf(stderr, "잘못된 주소: %s\n", config.host);
+        return 1;
+    }
+
+    // 연결 수만큼 fd가 필요하다
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)config.connections + 64) {
+        fprintf(stderr, "경고: fd 제한(%lu)이 연결 수보다 작습니다\n", (unsigned long)limit.rlim_cur);
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    sent_ns = calloc((size_t)config.width * config.height, sizeof(atomic_ulong));
+    Conn *conns = calloc(config.connections, sizeof(Conn));
+    Worker *workers = calloc(config.threads, sizeof(Worker));
+    FILE *csv = fopen(config.csv_path, "w");
+    if (sent_ns == NULL || conns == NULL || workers == NULL) {
+        fprintf(stderr, "메모리 할당 실패\n");
+        return 1;
+    }
+    if (csv == NULL) {
+        perror("CSV 파일 열기 실패");
+        return 1;
+    }
+    fprintf(csv, "timestamp,client_count,elapsed_time_ms,paints,deliveries\n");
+
+    // 연결을 스레드마다 연속 구간으로 나누고, 앞쪽 연결부터 painter로 지정
+    for (int i = 0; i < config.connections; i++) {
+        conns[i].fd = -1;
+        conns[i].painter = i < config.painters;
+    }
+    int offset = 0;
+    for (int t = 0; t < config.threads; t++) {
+        Worker *w = &workers[t];
+        w->id = t;
+        w->count = config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0);
+        w->conns = conns + offset;
+        offset += w->count;
+        w->painters = malloc(sizeof(int) * (w->count ? w->count : 1));
+        for (int i = 0; i < w->count; i++) {
+            if (w->conns[i].painter) {
+                w->painters[w->painter_count++] = i;
+            }
+        }
+        histogram_init(&w->handshake);
+        histogram_init(&w->snapshot);
+        histogram_init(&w->latency);
+        w->epoll_fd = epoll_create1(0);
+        if (w->epoll_fd == -1) {
+            perror("epoll_create1");
+            return 1;
+        }
+    }
+
+    printf("loadgen: %s:%d 연결 %d (painter %d x %.1f/s), 스레드 %d, %d초\n",
+           config.host, config.port, config.connections, config.painters, config.rate,
+           config.threads, config.duration);
+
+    start_ns = monotonic_ns();
+    for (int t = 0; t < config.threads; t++) {
+        if (pthread_create(&workers[t].tid, NULL, worker_thread, &workers[t]) != 0) {
+            fprintf(stderr, "스레드 생성 실패\n");
+            return 1;
+        }
+    }
+
+    // 1초마다 CSV 한 줄
+    unsigned long last_paints = 0, last_deliveries = 0, last_sum = 0;
+    for (int second = 0; second < config.duration && !atomic_load(&stop); second++) {
+        sleep(1);
+        unsigned long paints = 0, deliveries = 0, sum = 0;
+        for (int t = 0; t < config.threads; t++) {
+            paints += atomic_load_explicit(&workers[t].paints, memory_order_relaxed);
+            deliveries += atomic_load_explicit(&workers[t].deliveries, memory_order_relaxed);
+            sum += atomic_load_explicit(&workers[t].latency_sum, memory_order_relaxed);
+        }
+
+        char timestamp[32];
+        time_t now = time(NULL);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+        int clients = atomic_load(&open_connections);
+        unsigned long window = deliveries - last_deliveries;
+        if (window > 0) {
+            fprintf(csv, "%s,%d,%.3f,%lu,%lu\n", timestamp, clients,
+                    (sum - last_sum) / 1e6 / window, paints - last_paints, window);
+        } else {
+            fprintf(csv, "%s,%d,,%lu,%lu\n", timestamp, clients, paints - last_paints, window);
+        }
+        fflush(csv);
+        printf("[%3ds] 연결 %d, 전송 %lu/s, 수신 %lu/s, 평균 지연 %.3fms\n", second + 1, clients,
+               paints - last_paints, window, window ? (sum - last_sum) / 1e6 / window : 0.0);
+
+        last_paints = paints;
+        last_deliveries = deliveries;
+        last_sum = sum;
+    }
+
+    atomic_store(&stop, 1);
+    double elapsed = (monotonic_ns() - start_ns) / 1e9;
+    for (int t = 0; t < config.threads; t++) {
+        pthread_join(workers[t].tid, NULL);
+    }
+    fclose(csv);
+
+    // 스레드별 결과 합산
+    static Histogram handshake, snapshot, latency;
+    histogram_init(&handshake);
+    histogram_init(&snapshot);
+    histogram_init(&latency);
+    unsigned long paints = 0, skipped = 0, deliveries = 0, bytes_in = 0, failed = 0, closed = 0;
+    for (int t = 0; t < config.threads; t++) {
+        Worker *w = &workers[t];
+        histogram_merge(&handshake, &w->handshake);
+        histogram_merge(&snapshot, &w->snapshot);
+        histogram_merge(&latency, &w->latency);
+        paints += atomic_load(&w->paints);
+        skipped += atomic_load(&w->skipped);
+        deliveries += atomic_load(&w->deliveries);
+        bytes_in += atomic_load(&w->bytes_in);
+        failed += atomic_load(&w->failed);
+        closed += atomic_load(&w->closed);
+        close(w->epoll_fd);
+        free(w->painters);
+    }
+
+    printf("\n연결: 성공 %lu / %d, 실패 %lu, 서버가 끊음 %lu\n",
+           atomic_load(&handshake.total), config.connections, failed, closed);
+    print_histogram("join (101)", &handshake);
+    print_histogram("join (snapshot)", &snapshot);
+    printf("전송: %lu (%.1f/s), 건너뜀 %lu\n", paints, paints / elapsed, skipped);
+    printf("수신: %lu (%.1f/s), %.1f MB/s\n", deliveries, deliveries / elapsed, bytes_in / elapsed / 1e6);
+    print_histogram("delivery latency", &latency);
+    printf("CSV: %s\n", config.csv_path);
+
+    if (config.summary_path != NULL) {
+        FILE *summary = fopen(config.summary_path, "a");
+        if (summary == NULL) {
+            perror("요약 파일 열기 실패");
+        } else {
+            if (ftell(summary) == 0) {
+                fprintf(summary, "connections,painters,rate,opened,failed,closed,paints_per_sec,deliveries_per_sec,"
+                                 "mb_in_per_sec,join_p50_ms,join_p99_ms,latency_p50_ms,latency_p99_ms,latency_p999_ms\n");
+            }
+            fprintf(summary, "%d,%d,%.1f,%lu,%lu,%lu,%.1f,%.1f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                    config.connections, config.painters, config.rate,
+                    atomic_load(&handshake.total), failed, closed,
+                    paints / elapsed, deliveries / elapsed, bytes_in / elapsed / 1e6,
+                    histogram_percentile(&snapshot, 0.5) / 1e6, histogram_percentile(&snapshot, 0.99) / 1e6,
+                    histogram_percentile(&latency, 0.5) / 1e6, histogram_percentile(&latency, 0.99) / 1e6,
+                    histogram_percentile(&latency, 0.999) / 1e6);
+            fclose(summary);
+        }
+    }
+
+    free(workers);
+    free(conns);
+    free(sent_ns);
+    return 0;
+}
@@ -0,0 +1,423 @@
+// 녹화한 픽셀 트래픽 재생기 (FAINTER_RECORD 로 만든 파일)
+// 녹화된 시각 간격을 그대로(또는 배속으로) 지키며 이벤트를 다시 넣는다.
+//  - 소켓 모드(기본): 실행 중인 서버에 접속마다 실제 WebSocket 연결을 열고 픽셀 frame을 보낸다.
+//                    서버가 보내는 데이터는 읽고 버린다 (안 읽으면 서버가 느린 클라이언트로 끊는다).
+//  - 프로세스 내 모드(-C): 서버 스레드 없이 캔버스 코어 함수(process_json, 스냅샷 인코딩,
+//                    broadcast_updates)를 직접 호출하고 구간별 소요 시간을 잰다.
+//                    브로드캐스트 틱은 녹화 시각 기준 500ms마다라서 배속과 무관하게 같은 묶음이 나온다.
+//
+// 사용법: ./tools/replay [-a 주소] [-p 포트] [-x 배속(기본 1, 0이면 최대 속도)] [-w 끝난 뒤 대기(초)] [-C] 녹화파일
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "canvas.h"
+#include "client_manager.h"
+#include "histogram.h"
+#include "parsing_json.h"
+#include "recorder.h"
+#include "save_canvas.h"
+#include "task_queue.h"
+
+#define REPLAY_TICK_NS 500000000UL          // 서버 브로드캐스트 주기와 같게
+#define REPLAY_MAX_EVENTS 256
+#define REPLAY_RECV_SIZE (64 * 1024)
+#define REPLAY_HEADER_MAX 4096
+
+static struct {
+    char host[64];
+    int port;
+    double speed;               // 0이면 최대 속도
+    int wait;                   // 재생 후 서버 데이터를 더 받는 시간 (초)
+    bool in_process;
+} config = {
+    .host = "127.0.0.1",
+    .port = 8080,
+    .speed = 1.0,
+    .wait = 2,
+    .in_process = false,
+};
+
+static RecordHeader header;
+static RecordEntry *entries = NULL;
+static size_t entry_count = 0;
+static uint32_t max_conn_id = 0;
+
+static unsigned long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static bool load_recording(const char *path) {
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, RECORD_MAGIC, sizeof(header.magic)) != 0 || header.version != RECORD_VERSION) {
+        fprintf(stderr, "%s: 녹화 파일이 아니거나 버전이 다릅니다\n", path);
+        fclose(file);
+        return false;
+    }
+
+    size_t capacity = 4096;
+    entries = malloc(sizeof(RecordEntry) * capacity);
+    while (entries != NULL) {
+        if (entry_count == capacity) {
+            capacity *= 2;
+            RecordEntry *grown = realloc(entries, sizeof(RecordEntry) * capacity);
+            if (grown == NULL) {
+                break;
+            }
+            entries = grown;
+        }
+        if (fread(&entries[entry_count], sizeof(RecordEntry), 1, file) != 1) {
+            break;
+        }
+        if (entries[entry_count].conn_id > max_conn_id) {
+            max_conn_id = entries[entry_count].conn_id;
+        }
+        entry_count++;
+    }
+    fclose(file);
+    if (entries == NULL) {
+        fprintf(stderr, "메모리 부족\n");
+        return false;
+    }
+    return true;
+}
+
+// 녹화 시각 -> 재생 목표 시각
+static unsigned long target_ns(unsigned long start, const RecordEntry *entry) {
+    return config.speed > 0 ? start + (unsigned long)(entry->time_ns / config.speed) : 0;
+}
+
+static int pixel_json(const RecordEntry *entry, char *buf, size_t size) {
+    return snprintf(buf, size, "{\"pixel\":{\"x\":%u,\"y\":%u,\"color\":\"#%02x%02x%02x\"}}",
+                    entry->x, entry->y, entry->rgb[0], entry->rgb[1], entry->rgb[2]);
+}
+
+static void print_histogram(const char *name, Histogram *h) {
+    unsigned long count = atomic_load(&h->total);
+    printf("%-16s n=%-10lu mean=%9.3fms p50=%9.3fms p99=%9.3fms max=%9.3fms\n", name, count,
+           count ? atomic_load(&h->sum) / 1e6 / count : 0.0,
+           histogram_percentile(h, 0.5) / 1e6, histogram_percentile(h, 0.99) / 1e6,
+           atomic_load(&h->max) / 1e6);
+}
+
+// ---- 소켓 모드 ----
+
+typedef struct {
+    int fd;                     // -1이면 아직 안 열었거나 닫힘
+    bool failed;
+} ReplayConn;
+
+static ReplayConn *conns = NULL;
+static int epoll_fd = -1;
+static unsigned long bytes_in = 0, sent = 0, failed = 0, closed = 0;
+
+// 블로킹 connect + 핸드셰이크, 이후 수신은 epoll로 읽고 버린다
+static int open_connection(ReplayConn *conn) {
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(config.port)};
+    inet_pton(AF_INET, config.host, &addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "GET / HTTP/1.1\r\nHost: %s:%d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+                       config.host, config.port);
+    if (send(fd, request, len, MSG_NOSIGNAL) != len) {
+        close(fd);
+        return -1;
+    }
+
+    // 101 응답 헤더까지 한 바이트씩 읽는다 (뒤따르는 스냅샷은 epoll에서 버린다)
+    char response[REPLAY_HEADER_MAX];
+    size_t used = 0;
+    while (used < sizeof(response) - 1) {
+        if (recv(fd, response + used, 1, 0) != 1) {
+            close(fd);
+            return -1;
+        }
+        used++;
+        if (used >= 4 && memcmp(response + used - 4, "\r\n\r\n", 4) == 0) {
+            break;
+        }
+    }
+    response[used] = '\0';
+    if (strncmp(response, "HTTP/1.1 101", 12) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = conn};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    conn->fd = fd;
+    return 0;
+}
+
+static void close_connection(ReplayConn *conn) {
+    if (conn->fd != -1) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        close(conn->fd);
+        conn->fd = -1;
+    }
+}
+
+// 서버가 보낸 데이터를 읽고 버린다
+static void drain(int timeout_ms) {
+
+    static char buffer[REPLAY_RECV_SIZE];
+    struct epoll_event events[REPLAY_MAX_EVENTS];
+    int n = epoll_wait(epoll_fd, events, REPLAY_MAX_EVENTS, timeout_ms);
+    for (int i = 0; i < n; i++) {
+        ReplayConn *conn = events[i].data.ptr;
+        while (conn->fd != -1) {
+            ssize_t len = recv(conn->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (len > 0) {
+                bytes_in += len;
+                continue;
+            }
+            if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                close_connection(conn);
+                closed++;
+            }
+            break;
+        }
+    }
+}
+
+static void send_pixel(ReplayConn *conn, const RecordEntry *entry) {
+
+    char payload[96];
+    int len = pixel_json(entry, payload, sizeof(payload));
+
+    // 클라이언트 frame은 마스킹해야 한다
+    uint8_t frame[128];
+    static const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame[0] = 0x81;
+    frame[1] = 0x80 | (uint8_t)len;
+    memcpy(frame + 2, mask, 4);
+    for (int i = 0; i < len; i++) {
+        frame[6 + i] = payload[i] ^ mask[i % 4];
+    }
+    if (send(conn->fd, frame, 6 + len, MSG_NOSIGNAL) != 6 + len) {
+        close_connection(conn);
+        closed++;
+        return;
+    }
+    sent++;
+}
+
+static int replay_sockets(void) {
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    conns = calloc(max_conn_id + 1, sizeof(ReplayConn));
+    if (epoll_fd == -1 || conns == NULL) {
+        perror("초기화 실패");
+        return 1;
+    }
+    for (uint32_t i = 0; i <= max_conn_id; i++) {
+        conns[i].fd = -1;
+    }
+
+    Histogram lag;              // 목표 시각보다 늦게 보낸 정도
+    histogram_init(&lag);
+
+    unsigned long start = now_ns();
+    for (size_t i = 0; i < entry_count; i++) {
+        const RecordEntry *entry = &entries[i];
+        unsigned long target = target_ns(start, entry);
+
+        // 목표 시각까지 서버 데이터를 받으며 기다린다
+        unsigned long now;
+        while ((now = now_ns()) < target) {
+            drain((int)((target - now) / 1000000));
+        }
+        histogram_record(&lag, target ? now - target : 0);
+        if ((i & 63) == 0) {
+            drain(0);
+        }
+
+        ReplayConn *conn = &conns[entry->conn_id];
+        if (conn->fd == -1 && !conn->failed) {
+            // 녹화 중간에 시작했으면 JOIN 없이 픽셀부터 나올 수 있다
+            if (open_connection(conn) == -1) {
+                conn->failed = true;
+                failed++;
+            }
+        }
+        if (conn->fd != -1 && entry->type == RECORD_PIXEL) {
+            send_pixel(conn, entry);
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    unsigned long wait_until = now_ns() + config.wait * 1000000000UL;
+    while (now_ns() < wait_until) {
+        drain(100);
+    }
+    for (uint32_t i = 0; i <= max_conn_id; i++) {
+        close_connection(&conns[i]);
+    }
+
+    printf("재생: 이벤트 %zu개, %.3f초 (%.0f 이벤트/s), 픽셀 전송 %lu\n",
+           entry_count, elapsed, entry_count / elapsed, sent);
+    printf("연결: %u개, 실패 %lu, 서버가 끊음 %lu, 수신 %.1f MB\n", max_conn_id, failed, closed, bytes_in / 1e6);
+    print_histogram("schedule lag", &lag);
+    return 0;
+}
+
+// ---- 프로세스 내 모드 (캔버스 코어만, 스레드 없음) ----
+
+static int replay_in_process(void) {
+
+    static TaskQueue queue;
+    static ClientManager manager;
+    static Canvas canvas;
+
+    // 브로드캐스트 작업을 다 담을 수 있는 크기 (재생 중에 비운다)
+    init_task_queue(&queue, 1024, "replay");
+    memset(&manager, 0, sizeof(manager));
+    manager.queue = &queue;
+    manager.canvas_queue = &queue;
+    pthread_spin_init(&manager.lock, PTHREAD_PROCESS_PRIVATE);
+
+    memset(&canvas, 0, sizeof(canvas));
+    canvas.cm = &manager;
+    canvas.queue = &queue;
+    canvas.canvas_width = header.width;
+    canvas.canvas_height = header.height;
+    canvas.pixels = malloc(sizeof(Pixel) * header.width * header.height);
+    if (canvas.pixels == NULL) {
+        fprintf(stderr, "메모리 부족\n");
+        return 1;
+    }
+    for (int i = 0; i < header.width * header.height; i++) {
+        canvas.pixels[i].x = i % header.width;
+        canvas.pixels[i].y = i / header.width;
+        strcpy(canvas.pixels[i].color, "#FFFFFF");
+    }
+
+    Histogram apply, snapshot, tick;
+    histogram_init(&apply);
+    histogram_init(&snapshot);
+    histogram_init(&tick);
+    unsigned long busy_ns = 0;
+
+    unsigned long start = now_ns();
+    unsigned long next_tick = REPLAY_TICK_NS;
+    for (size_t i = 0; i <= entry_count; i++) {
+        const RecordEntry *entry = i < entry_count ? &entries[i] : NULL;
+
+        // 녹화 시각 기준 500ms 경계를 지나면 브로드캐스트 (마지막에는 남은 변경을 보낸다)
+        while (entry == NULL ? canvas.modified_pixels != NULL : entry->time_ns >= next_tick) {
+            unsigned long t0 = now_ns();
+            broadcast_updates(&canvas);
+            unsigned long t1 = now_ns();
+            histogram_record(&tick, t1 - t0);
+            busy_ns += t1 - t0;
+            while (task_queue_depth(&queue) > 0) {
+                Task task = pop_task(&queue);
+                free(task.data);
+            }
+            next_tick += REPLAY_TICK_NS;
+            if (entry == NULL) {
+                break;
+            }
+        }
+        if (entry == NULL) {
+            break;
+        }
+
+        unsigned long target = target_ns(start, entry);
+        unsigned long now = now_ns();
+        if (now < target) {
+            struct timespec ts = {(target - now) / 1000000000UL, (target - now) % 1000000000UL};
+            nanosleep(&ts, NULL);
+        }
+
+        unsigned long t0 = now_ns();
+        if (entry->type == RECORD_JOIN) {
+            char *json = trans_canvas_as_json(&canvas);
+            size_t frame_len = 0;
+            uint8_t *frame = create_websocket_frame((uint8_t *)json, strlen(json), &frame_len);
+            free(json);
+            free(frame);
+            unsigned long t1 = now_ns();
+            histogram_record(&snapshot, t1 - t0);
+            busy_ns += t1 - t0;
+        } else if (entry->type == RECORD_PIXEL) {
+            char json[96];
+            int len = pixel_json(entry, json, sizeof(json));
+            process_json(&canvas, (int)entry->conn_id, json, len, t0);
+            unsigned long t1 = now_ns();
+            histogram_record(&apply, t1 - t0);
+            busy_ns += t1 - t0;
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    printf("재생(프로세스 내): 이벤트 %zu개, %.3f초 (%.0f 이벤트/s), 캔버스 스레드 사용률 %.1f%%\n",
+           entry_count, elapsed, entry_count / elapsed, busy_ns / 1e7 / elapsed);
+    print_histogram("pixel apply", &apply);
+    print_histogram("snapshot encode", &snapshot);
+    print_histogram("tick broadcast", &tick);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-a 주소] [-p 포트] [-x 배속(0이면 최대)] [-w 대기(초)] [-C] 녹화파일\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:p:x:w:C")) != -1) {
+        switch (opt) {
+            case 'a': snprintf(config.host, sizeof(config.host), "%s", optarg); break;
+            case 'p': config.port = atoi(optarg); break;
+            case 'x': config.speed = atof(optarg); break;
+            case 'w': config.wait = atoi(optarg); break;
+            case 'C': config.in_process = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc || !load_recording(argv[optind])) {
+        usage(argv[0]);
+    }
+
+    double span = entry_count ? entries[entry_count - 1].time_ns / 1e9 : 0;
+    printf("녹화: %ux%u 캔버스, 이벤트 %zu개, 접속 %u개, 길이 %.3f초, 배속 ",
+           header.width, header.height, entry_count, max_conn_id, span);
+    config.speed > 0 ? printf("%gx\n", config.speed) : printf("최대\n");
+
+    return config.in_process ? replay_in_process() : replay_sockets();
+}
@@ -0,0 +1,70 @@
+// 통계 샘플러의 바이너리 링 파일을 CSV로 변환 (서버 없이 오프라인으로)
+//
+// 사용법: ./tools/stats_csv [-s 시작 시각(unix ms)] [-n 마지막 샘플 수] [파일(기본 save/stats.bin)]
+// 출력 형식은 GET /stats 와 같다. 서버가 쓰고 있는 파일을 읽어도 된다.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../stats.h"
+
+static void usage(const char *prog) {
+    fprintf(stderr, "사용법: %s [-s 시작 시각(unix ms)] [-n 마지막 샘플 수] [파일(기본 %s)]\n",
+            prog, STATS_DEFAULT_FILE);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+
+    unsigned long since_ms = 0;
+    unsigned long last = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+        switch (opt) {
+            case 's': since_ms = strtoul(optarg, NULL, 10); break;
+            case 'n': last = strtoul(optarg, NULL, 10); break;
+            default: usage(argv[0]);
+        }
+    }
+    const char *path = optind < argc ? argv[optind] : STATS_DEFAULT_FILE;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror(path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < STATS_HEADER_SIZE) {
+        fprintf(stderr, "%s: 통계 파일이 아닙니다\n", path);
+        return 1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    const StatsFileHeader *header = (const StatsFileHeader *)map;
+    if (memcmp(header->magic, STATS_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != STATS_VERSION || header->record_size != sizeof(StatsSample) ||
+        (size_t)st.st_size < STATS_HEADER_SIZE + (size_t)header->record_size * header->capacity) {
+        fprintf(stderr, "%s: 형식이 다릅니다 (버전 %u, 레코드 %u바이트)\n",
+                path, header->version, header->record_size);
+        return 1;
+    }
+
+    size_t length = 0;
+    char *csv = stats_render_csv(header, since_ms, last, &length);
+    if (csv == NULL) {
+        fprintf(stderr, "메모리 부족\n");
+        return 1;
+    }
+    fwrite(csv, 1, length, stdout);
+    free(csv);
+    munmap(map, st.st_size);
+    return 0;
+}
@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include "trace.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+atomic_int trace_enabled = 0;
+
+static __thread TraceRing *local_ring = NULL;
+static __thread const char *local_thread_name = NULL;
+static TraceRing *rings = NULL;                      // 등록된 스레드별 링 리스트
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void trace_init(void) {
+    const char *env = getenv("FAINTER_TRACE");
+    if (env != NULL && strcmp(env, "1") == 0) {
+        trace_start();
+    }
+}
+
+void trace_set_thread_name(const char *name) {
+    local_thread_name = name;
+    if (local_ring != NULL) {
+        snprintf(local_ring->thread_name, sizeof(local_ring->thread_name), "%s", name);
+    }
+}
+
+// 현재 스레드의 링 (처음 기록할 때 한 번 할당)
+static TraceRing *thread_ring(void) {
+
+    TraceRing *ring = (TraceRing *)malloc(sizeof(TraceRing));
+    TraceEvent *events = (TraceEvent *)calloc(TRACE_RING_SIZE, sizeof(TraceEvent));
+    if (ring == NULL || events == NULL) {
+        free(ring);
+        free(events);
+        atomic_store(&trace_enabled, 0);
+        LOG_ERROR("트레이스 버퍼 할당 실패, 트레이스를 끕니다");
+        return NULL;
+    }
+    ring->events = events;
+    atomic_init(&ring->head, 0);
+    ring->tid = gettid();
+    snprintf(ring->thread_name, sizeof(ring->thread_name), "%s",
+             local_thread_name ? local_thread_name : "thread");
+
+    pthread_mutex_lock(&rings_lock);
+    ring->next = rings;
+    rings = ring;
+    pthread_mutex_unlock(&rings_lock);
+
+    local_ring = ring;
+    return ring;
+}
+
+void trace_record(const char *name, unsigned long start_ns, unsigned long dur_ns, unsigned long arg) {
+
+    TraceRing *ring = local_ring;
+    if (ring == NULL && (ring = thread_ring()) == NULL) {
+        return;
+    }
+    unsigned long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent *event = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->dur_ns = dur_ns;
+    event->arg = arg;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void trace_start(void) {
+    atomic_store(&trace_enabled, 1);
+}
+
+void trace_stop(void) {
+    atomic_store(&trace_enabled, 0);
+}
+
+// 늘어나는 출력 버퍼
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} DumpBuffer;
+
+static int dump_append(DumpBuffer *buf, const char *format, ...) {
+
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf->data + buf->length, buf->capacity - buf->length, format, args);
+        va_end(args);
+        if (n < 0) {
+            return -1;
+        }
+        if (buf->length + n < buf->capacity) {
+            buf->length += n;
+            return 0;
+        }
+        size_t capacity = buf->capacity * 2 + n;
+        char *data = (char *)realloc(buf->data, capacity);
+        if (data == NULL) {
+            return -1;
+        }
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+}
+
+char *trace_dump(size_t *length) {
+
+    // 덤프하는 동안은 기록을 멈춰서 읽고 있는 칸이 덮어써지지 않게 한다
+    int was_enabled = atomic_exchange(&trace_enabled, 0);
+
+    DumpBuffer buf = {malloc(1 << 20), 0, 1 << 20};
+    if (buf.data == NULL) {
+        atomic_store(&trace_enabled, was_enabled);
+        return NULL;
+    }
+    int failed = dump_append(&buf, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    pid_t pid = getpid();
+
+    pthread_mutex_lock(&rings_lock);
+    for (TraceRing *ring = rings; ring != NULL && !failed; ring = ring->next) {
+        failed |= dump_append(&buf, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                                    "\"args\":{\"name\":\"%s\"}}",
+                              first ? "" : ",", pid, ring->tid, ring->thread_name);
+        first = false;
+
+        unsigned long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        unsigned long count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        for (unsigned long i = head - count; i < head && !failed; i++) {
+            TraceEvent *event = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            // Chrome trace 시간 단위는 마이크로초
+            if (event->dur_ns == 0) {
+                failed |= dump_append(&buf, ",{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+                                            "\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%lu}}",
+                                      event->name, event->start_ns / 1e3, pid, ring->tid, event->arg);
+            } else {
+                failed |= dump_append(&buf, ",{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                                            "\"pid\":%d,\"tid\":%d,\"args\":{\"arg\":%lu}}",
+                                      event->name, event->start_ns / 1e3, event->dur_ns / 1e3,
+                                      pid, ring->tid, event->arg);
+            }
+        }
+    }
+    pthread_mutex_unlock(&rings_lock);
+
+    failed |= dump_append(&buf, "]}\n");
+    atomic_store(&trace_enabled, was_enabled);
+
+    if (failed) {
+        free(buf.data);
+        return NULL;
+    }
+    *length = buf.length;
+    return buf.data;
+}
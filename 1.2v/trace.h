@@ -0,0 +1,60 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "metrics.h"
+
+// 스레드별 이벤트 링 버퍼 (가득 차면 오래된 이벤트부터 덮어쓴다)
+// 꺼져 있을 때는 trace_begin에서 원자 변수 하나만 읽고 끝난다.
+#define TRACE_RING_SIZE (1 << 15)       // 스레드당 이벤트 수 (2의 거듭제곱)
+
+typedef struct {
+    const char *name;           // 이벤트 이름 (정적 문자열이어야 한다)
+    unsigned long start_ns;     // 시작 시각 (monotonic)
+    unsigned long dur_ns;       // 길이, 0이면 순간 이벤트
+    unsigned long arg;          // 이벤트별 값 (fd, 바이트 수, 작업 유형 등)
+} TraceEvent;
+
+typedef struct TraceRing {
+    TraceEvent *events;
+    atomic_ulong head;          // 지금까지 기록한 이벤트 수 (소유 스레드만 쓴다)
+    int tid;
+    char thread_name[16];
+    struct TraceRing *next;
+} TraceRing;
+
+extern atomic_int trace_enabled;
+
+static inline bool trace_on(void) {
+    return atomic_load_explicit(&trace_enabled, memory_order_relaxed) != 0;
+}
+
+// 구간 시작 (꺼져 있으면 0)
+static inline unsigned long trace_begin(void) {
+    return trace_on() ? monotonic_ns() : 0;
+}
+
+void trace_record(const char *name, unsigned long start_ns, unsigned long dur_ns, unsigned long arg);
+
+// 구간 끝 (trace_begin이 0을 돌려줬으면 아무것도 하지 않는다)
+static inline void trace_end(const char *name, unsigned long start_ns, unsigned long arg) {
+    if (start_ns != 0) {
+        trace_record(name, start_ns, monotonic_ns() - start_ns, arg);
+    }
+}
+
+// 환경 변수 FAINTER_TRACE=1 이면 시작부터 기록
+void trace_init(void);
+
+// 현재 스레드 이름 (Chrome trace의 스레드 이름으로 표시)
+void trace_set_thread_name(const char *name);
+
+void trace_start(void);
+void trace_stop(void);
+
+// 모든 스레드의 이벤트를 Chrome/Perfetto JSON으로 만든다 (호출자가 free, 실패 시 NULL)
+char *trace_dump(size_t *length);
+
+#endif // TRACE_H
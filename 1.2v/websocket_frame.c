@@ -0,0 +1,178 @@
+#include "websocket_frame.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "task_queue.h"
+
+// WebSocket 프레임을 처리하고 Task 구조체를 반환하는 함수
+void process_websocket_frame(ClientManager *manager, int client_fd, unsigned int gen, char *buf, size_t buf_len, unsigned long recv_ns) {
+    uint8_t *buffer = (uint8_t *)buf;
+    size_t buffer_len = buf_len;
+    size_t payload_len = 0;
+    size_t header_len = 2;
+
+    // 기본 헤더가 도착했는지 확인 (헤더가 2바이트 미만이면 처리 불가)
+    if (buffer_len < 2) {
+        //printf("불완전한 헤더가 도착함\n");
+        return;
+    }
+
+    bool fin = (buffer[0] & 0x80) != 0;         // FIN 플래그 확인 (1인경우 true)
+
+    uint8_t opcode = buffer[0] & 0x0F;          // opcode는 하위 4비트
+    uint8_t masked = (buffer[1] & 0x80) != 0;   // 마스킹 여부 (상위 비트 확인)
+    payload_len = buffer[1] & 0x7F;             // 페이로드 길이는 하위 7비트
+
+    // 확장된 페이로드 길이 처리
+    if (payload_len == 126) { // 페이로드 길이가 126일 때
+        header_len += 2;      // 확장 길이 2바이트 추가
+        if (buffer_len < header_len) {
+            return;
+        }
+        // 확장 길이를 big-endian으로 읽음
+        payload_len = ((uint8_t)buffer[2] << 8) | (uint8_t)buffer[3];
+    }
+    else if (payload_len == 127) { // 페이로드 길이가 127일 때
+        header_len += 8;             // 확장 길이 8바이트 추가
+        if (buffer_len < header_len) {
+            // printf("프레임 불완전: 확장된 페이로드 길이를 위한 %zu 바이트 필요\n", header_len);
+            return;
+        }
+
+        // 64비트 확장 길이를 big-endian으로 읽음
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | (uint8_t)buffer[2 + i];
+        }
+    }
+
+    // 마스킹 키 위치 계산
+    size_t masking_key_offset = header_len; // 마스킹 키는 헤더 끝에 위치
+    if (masked) {
+        header_len += 4; // 마스킹 키가 4바이트이므로 헤더 길이에 추가
+    }
+
+    // 프레임 전체 길이 확인
+    size_t total_frame_len = header_len + payload_len; // 헤더 길이 + 페이로드 길이
+    if (buffer_len < total_frame_len) {
+        //printf("프레임 불완전: 전체 프레임을 위한 %zu 바이트 필요\n", total_frame_len);
+        return;
+    }
+
+    // 페이로드 데이터의 시작 위치 계산
+    uint8_t *payload_data = buffer + header_len;
+
+    // 마스킹이 적용된 경우 데이터 디마스킹 수행
+    if (masked) {
+        uint8_t *masking_key = buffer + masking_key_offset; // 마스킹 키 시작 위치
+        //printf("마스킹 키를 사용하여 페이로드 데이터 디마스킹 수행\n");
+        for (size_t i = 0; i < payload_len; i++) {
+            payload_data[i] ^= masking_key[i % 4]; // 마스킹 키로 XOR 연산
+        }
+    }
+
+    // 작업(Task) 구조체 생성
+    Task task;
+    task.client = client_fd;
+    task.recv_ns = recv_ns;
+    task.gen = gen;
+
+    // opcode에 따라 작업 유형 설정 및 데이터 처리
+    if (opcode == 0x8) {
+        // 클라이언트 종료 프레임 처리 (opcode 0x8)
+        task.type = TASK_WEBSOCKET_CLOSE;
+        task.data = NULL; // 종료 프레임, 동일한 프레임 그대로 전송
+        task.data_len = 0;
+    }
+    else if (opcode == 0x2) {
+
+        // 바이너리 메시지 처리 (opcode 0x2)
+
+        // 페이로드 데이터를 복사하여 새로운 버퍼에 할당
+        uint8_t *payload_copy = (uint8_t *)malloc(payload_len);
+        memcpy(payload_copy, payload_data, payload_len);
+
+        if (fin) task.type = TASK_FRAME_MESSAGE;
+        else task.type = TASK_MESSAGE_INCOMPLETE_FRAME;
+        task.data = payload_copy;
+        task.data_len = payload_len;
+
+    }
+    else if (opcode == 0x1) {
+        // 텍스트 메시지 처리 (opcode 0x1)
+        // 문자열을 NULL 종료하여 안전하게 처리
+        char *text = (char *)malloc(payload_len + 1);
+        memcpy(text, payload_data, payload_len);
+        text[payload_len] = '\0'; // NULL 종료
+
+        if (fin) task.type = TASK_FRAME_MESSAGE;
+        else task.type = TASK_MESSAGE_INCOMPLETE_FRAME;
+        task.data = text;
+        task.data_len = payload_len;
+
+    }
+    else if (opcode == 0x9) {
+        // 클라이언트 ping (opcode 0x9): 제어 frame은 125바이트 이하
+        if (payload_len > 125) {
+            return;
+        }
+        uint8_t *payload_copy = (uint8_t *)malloc(payload_len + 1);
+        memcpy(payload_copy, payload_data, payload_len);
+        task.type = TASK_WEBSOCKET_PING;
+        task.data = payload_copy;
+        task.data_len = payload_len;
+    }
+    else if (opcode == 0xA) {
+        // 서버가 보낸 ping의 답 (opcode 0xA)
+        task.type = TASK_WEBSOCKET_PONG;
+        task.data = NULL;
+        task.data_len = 0;
+    }
+    else {
+        // 알 수 없는 opcode 처리
+        return;
+    }
+    // 종료 frame은 버리지 않는다 (같은 레인의 frame 뒤에서 자리가 나기를 기다린다)
+    if (task.type == TASK_WEBSOCKET_CLOSE) {
+        push_task_wait(manager->queue, task);
+    }
+    else if (!push_task(manager->queue, task)) {
+        free(task.data);
+    }
+}
+
+// 버퍼 앞에 있는 frame 하나의 전체 길이 (헤더 + 마스킹 키 + 페이로드), 헤더가 아직 다 오지 않았으면 0
+size_t websocket_frame_length(const uint8_t *data, size_t length) {
+
+    if (length < 2) {
+        return 0;
+    }
+    size_t header_len = 2;
+    uint64_t payload_len = data[1] & 0x7F;
+    if (payload_len == 126) {
+        header_len += 2;
+        if (length < header_len) {
+            return 0;
+        }
+        payload_len = ((uint64_t)data[2] << 8) | data[3];
+    }
+    else if (payload_len == 127) {
+        header_len += 8;
+        if (length < header_len) {
+            return 0;
+        }
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | data[2 + i];
+        }
+    }
+    if (data[1] & 0x80) {
+        header_len += 4;    // 마스킹 키
+    }
+    // 64비트 길이가 size_t 덧셈을 넘지 않게 (호출하는 쪽이 WEBSOCKET_MAX_PAYLOAD로 거른다)
+    if (payload_len > SIZE_MAX / 2) {
+        payload_len = SIZE_MAX / 2;
+    }
+    return header_len + (size_t)payload_len;
+}
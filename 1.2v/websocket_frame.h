@@ -0,0 +1,20 @@
+#ifndef WEBSOCKET_FRAME_H
+#define WEBSOCKET_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "client_manager.h"
+
+// 메세지 하나의 최대 페이로드 (CM이 조각을 모으는 수신 버퍼 크기), 더 긴 frame을 보내면 연결을 닫는다
+#define WEBSOCKET_MAX_PAYLOAD (REQUEST_BUFFER_SIZE - 1)
+#define WEBSOCKET_MAX_HEADER 14         // 2 + 확장 길이 8 + 마스킹 키 4
+
+// 수신한 WebSocket 프레임을 디마스킹하고 Task로 만들어 CM 큐에 넣는다 (buf는 제자리에서 디마스킹된다, gen은 읽은 연결의 세대)
+void process_websocket_frame(ClientManager *manager, int client_fd, unsigned int gen, char *buf, size_t buf_len, unsigned long recv_ns);
+
+// 버퍼 앞에 있는 frame 하나의 전체 길이 (헤더 + 마스킹 키 + 페이로드), 헤더가 아직 다 오지 않았으면 0
+// 메인 스레드가 recv한 바이트를 frame 단위로 나눌 때 (페이로드를 보기 전에 속도 제한도 frame마다 검사한다)
+size_t websocket_frame_length(const uint8_t *data, size_t length);
+
+#endif // WEBSOCKET_FRAME_H
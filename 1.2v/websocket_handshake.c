@@ -5,53 +5,93 @@
 #include <openssl/evp.h>
 #include <openssl/sha.h>
 
-// SHA-1 해시 함수
-void sha1_hash(const char *input, size_t len, unsigned char *output) {
-    EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-    if (mdctx == NULL) {
-        fprintf(stderr, "EVP_MD_CTX_new failed\n");
-        return;
-    }
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WEBSOCKET_GUID_LEN (sizeof(WEBSOCKET_GUID) - 1)
 
-    if (EVP_DigestInit_ex(mdctx, EVP_sha1(), NULL) != 1) {
-        fprintf(stderr, "EVP_DigestInit_ex failed\n");
-        EVP_MD_CTX_free(mdctx);
-        return;
-    }
+// 스레드마다 한 번만 만들어서 재사용하는 SHA-1 컨텍스트
+static __thread EVP_MD_CTX *thread_mdctx = NULL;
+static __thread const EVP_MD *thread_sha1 = NULL;
 
-    if (EVP_DigestUpdate(mdctx, input, len) != 1) {
-        fprintf(stderr, "EVP_DigestUpdate failed\n");
-        EVP_MD_CTX_free(mdctx);
-        return;
+// SHA-1 해시 함수 (컨텍스트를 매번 할당하지 않는다)
+int sha1_hash(const char *input, size_t len, unsigned char *output) {
+
+    if (thread_mdctx == NULL) {
+        thread_mdctx = EVP_MD_CTX_new();
+        if (thread_mdctx == NULL) {
+            fprintf(stderr, "EVP_MD_CTX_new failed\n");
+            return -1;
+        }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        // OpenSSL 3에서는 미리 fetch 해두면 DigestInit마다 알고리즘을 찾지 않는다
+        thread_sha1 = EVP_MD_fetch(NULL, "SHA1", NULL);
+#endif
+        if (thread_sha1 == NULL) {
+            thread_sha1 = EVP_sha1();
+        }
     }
 
     unsigned int md_len;
-    if (EVP_DigestFinal_ex(mdctx, output, &md_len) != 1) {
-        fprintf(stderr, "EVP_DigestFinal_ex failed\n");
-        EVP_MD_CTX_free(mdctx);
-        return;
+    if (EVP_DigestInit_ex(thread_mdctx, thread_sha1, NULL) != 1 ||
+        EVP_DigestUpdate(thread_mdctx, input, len) != 1 ||
+        EVP_DigestFinal_ex(thread_mdctx, output, &md_len) != 1) {
+        fprintf(stderr, "SHA-1 digest failed\n");
+        return -1;
     }
-
-    EVP_MD_CTX_free(mdctx);
+    return 0;
 }
 
-// Base64 인코딩 함수
-void base64_encode(const unsigned char *input, int length, char *output, int output_size) {
-    int encoded_length = EVP_EncodeBlock((unsigned char *)output, input, length);
-    if (encoded_length < 0 || encoded_length >= output_size) {
-        fprintf(stderr, "Base64 encoding failed\n");
+// Sec-WebSocket-Accept 값(28바이트, NULL 종료 없음)을 accept_key에 기록
+static int compute_accept_key(const char *client_key, size_t client_key_len, char *accept_key) {
+
+    // 클라이언트 키 + GUID (키는 base64 24바이트이므로 스택 버퍼로 충분하다)
+    char combined_key[WEBSOCKET_KEY_MAX_LEN + WEBSOCKET_GUID_LEN];
+    if (client_key_len == 0 || client_key_len > WEBSOCKET_KEY_MAX_LEN) {
+        return -1;
+    }
+    memcpy(combined_key, client_key, client_key_len);
+    memcpy(combined_key + client_key_len, WEBSOCKET_GUID, WEBSOCKET_GUID_LEN);
+
+    unsigned char sha1_result[SHA_DIGEST_LENGTH];
+    if (sha1_hash(combined_key, client_key_len + WEBSOCKET_GUID_LEN, sha1_result) == -1) {
+        return -1;
     }
-    output[encoded_length] = '\0';
+
+    // 20바이트 -> base64 28바이트 (EVP_EncodeBlock은 NULL 종료까지 쓰므로 임시 버퍼 사용)
+    unsigned char encoded[WEBSOCKET_ACCEPT_KEY_LEN + 1];
+    EVP_EncodeBlock(encoded, sha1_result, SHA_DIGEST_LENGTH);
+    memcpy(accept_key, encoded, WEBSOCKET_ACCEPT_KEY_LEN);
+    return 0;
 }
 
 // WebSocket Accept 키 생성 함수
 void generate_websocket_accept_key(const char *client_key, char *accept_key) {
-    const char *guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    char combined_key[256];
-    unsigned char sha1_result[SHA_DIGEST_LENGTH];
 
-    snprintf(combined_key, sizeof(combined_key), "%s%s", client_key, guid);
+    if (compute_accept_key(client_key, strlen(client_key), accept_key) == -1) {
+        accept_key[0] = '\0';
+        return;
+    }
+    accept_key[WEBSOCKET_ACCEPT_KEY_LEN] = '\0';
+}
 
-    sha1_hash(combined_key, strlen(combined_key), sha1_result);
-    base64_encode(sha1_result, SHA_DIGEST_LENGTH, accept_key, 256);
+// 101 Switching Protocols 응답 전체를 response에 만든다 (할당, snprintf 없음)
+int build_websocket_accept_response(const char *client_key, char *response, size_t response_size) {
+
+    static const char prefix[] =
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: ";
+    static const char suffix[] = "\r\n\r\n";
+    const size_t length = (sizeof(prefix) - 1) + WEBSOCKET_ACCEPT_KEY_LEN + (sizeof(suffix) - 1);
+
+    if (response_size < length) {
+        return -1;
+    }
+
+    memcpy(response, prefix, sizeof(prefix) - 1);
+    if (compute_accept_key(client_key, strlen(client_key), response + sizeof(prefix) - 1) == -1) {
+        return -1;
+    }
+    memcpy(response + sizeof(prefix) - 1 + WEBSOCKET_ACCEPT_KEY_LEN, suffix, sizeof(suffix) - 1);
+    return (int)length;
 }
@@ -2,6 +2,16 @@
 #ifndef WEBSOCKET_HANDSHAKE_H
 #define WEBSOCKET_HANDSHAKE_H
 
+#include <stddef.h>
+
+#define WEBSOCKET_KEY_MAX_LEN 64        // Sec-WebSocket-Key 최대 길이 (정상 키는 24바이트)
+#define WEBSOCKET_ACCEPT_KEY_LEN 28     // base64(SHA-1) 길이
+#define WEBSOCKET_ACCEPT_RESPONSE_SIZE 256
+
+int sha1_hash(const char *input, size_t len, unsigned char *output);
 void generate_websocket_accept_key(const char *client_key, char *accept_key);
 
+// 101 응답을 response에 작성하고 길이를 반환 (실패 시 -1)
+int build_websocket_accept_response(const char *client_key, char *response, size_t response_size);
+
 #endif // WEBSOCKET_HANDSHAKE_H
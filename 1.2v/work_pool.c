@@ -0,0 +1,205 @@
+#include "work_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "trace.h"
+#include "log.h"
+#include "affinity.h"
+
+static WorkDeque *deques = NULL;
+static int pool_size = 0;
+static atomic_uint next_deque = 0;              // 외부 스레드가 제출할 큐 (돌아가며)
+static atomic_ulong pending = 0;                // 아직 아무도 꺼내지 않은 작업 수
+
+// 작업이 없을 때 잠드는 곳
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static int sleeping = 0;
+
+static __thread WorkDeque *current_deque = NULL;  // 워커 스레드면 자기 큐
+
+// 큐를 늘리지 못하면 false
+static bool deque_push(WorkDeque *deque, WorkItem item) {
+
+    pthread_spin_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity) {
+        // 가득 찼으면 두 배로 (링 순서를 펴서 옮긴다)
+        unsigned long capacity = deque->capacity * 2;
+        WorkItem *items = malloc(sizeof(WorkItem) * capacity);
+        if (items == NULL) {
+            pthread_spin_unlock(&deque->lock);
+            return false;
+        }
+        for (unsigned long i = deque->top; i < deque->bottom; i++) {
+            items[i & (capacity - 1)] = deque->items[i & (deque->capacity - 1)];
+        }
+        free(deque->items);
+        deque->items = items;
+        deque->capacity = capacity;
+    }
+    deque->items[deque->bottom & (deque->capacity - 1)] = item;
+    deque->bottom++;
+    pthread_spin_unlock(&deque->lock);
+    return true;
+}
+
+// 자기 큐의 뒤에서 꺼낸다 (방금 넣은 작업이 캐시에 남아 있을 가능성이 크다)
+static bool deque_pop(WorkDeque *deque, WorkItem *item) {
+
+    pthread_spin_lock(&deque->lock);
+    bool found = deque->bottom != deque->top;
+    if (found) {
+        deque->bottom--;
+        *item = deque->items[deque->bottom & (deque->capacity - 1)];
+    }
+    pthread_spin_unlock(&deque->lock);
+    return found;
+}
+
+// 다른 워커 큐의 앞에서 훔친다 (가장 오래 기다린 작업)
+static bool deque_steal(WorkDeque *deque, WorkItem *item) {
+
+    pthread_spin_lock(&deque->lock);
+    bool found = deque->bottom != deque->top;
+    if (found) {
+        *item = deque->items[deque->top & (deque->capacity - 1)];
+        deque->top++;
+    }
+    pthread_spin_unlock(&deque->lock);
+    return found;
+}
+
+// 자기 큐, 다른 워커 큐 순서로 작업 하나를 찾는다
+static bool find_work(WorkDeque *self, WorkItem *item) {
+
+    if (deque_pop(self, item)) {
+        return true;
+    }
+    for (int i = 1; i < pool_size; i++) {
+        WorkDeque *victim = &deques[(self->index + i) % pool_size];
+        if (deque_steal(victim, item)) {
+            atomic_fetch_add_explicit(&self->stolen, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *worker_thread(void *arg) {
+
+    WorkDeque *self = (WorkDeque *)arg;
+    affinity_apply("worker", self->index);
+    current_deque = self;
+    char name[16];
+    snprintf(name, sizeof(name), "worker %d", self->index);
+    trace_set_thread_name(name);
+
+    while (1) {
+        WorkItem item;
+        if (find_work(self, &item)) {
+            atomic_fetch_sub(&pending, 1);
+            unsigned long trace_start_ns = trace_begin();
+            item.fn(item.arg);
+            trace_end("work", trace_start_ns, self->index);
+            atomic_fetch_add_explicit(&self->executed, 1, memory_order_relaxed);
+            continue;
+        }
+
+        // 꺼낼 작업이 없으면 제출될 때까지 잔다
+        pthread_mutex_lock(&idle_lock);
+        while (atomic_load(&pending) == 0) {
+            sleeping++;
+            pthread_cond_wait(&idle_cond, &idle_lock);
+            sleeping--;
+        }
+        pthread_mutex_unlock(&idle_lock);
+    }
+
+    return NULL;
+}
+
+void work_pool_init(void) {
+
+    int size = WORK_POOL_DEFAULT_SIZE;
+    const char *env = getenv("FAINTER_WORKERS");
+    if (env != NULL && atoi(env) > 0) {
+        size = atoi(env) < WORK_POOL_MAX_SIZE ? atoi(env) : WORK_POOL_MAX_SIZE;
+    }
+
+    deques = calloc(size, sizeof(WorkDeque));
+    if (deques == NULL) {
+        LOG_ERROR("작업 풀 할당 실패, 부수 작업은 호출 스레드에서 실행");
+        return;
+    }
+    for (int i = 0; i < size; i++) {
+        WorkDeque *deque = &deques[i];
+        pthread_spin_init(&deque->lock, PTHREAD_PROCESS_PRIVATE);
+        deque->capacity = WORK_DEQUE_INITIAL_SIZE;
+        deque->items = malloc(sizeof(WorkItem) * deque->capacity);
+        deque->index = i;
+    }
+
+    // 모든 큐를 만든 다음 스레드를 띄운다 (훔치기가 아직 없는 큐를 보지 않도록)
+    pool_size = size;
+    for (int i = 0; i < size; i++) {
+        const int n = pthread_create(&deques[i].tid, NULL, worker_thread, &deques[i]);
+        if (n != 0) {
+            LOG_ERROR("작업 풀 스레드 생성 실패: %s", strerror(n));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    LOG_INFO("작업 풀 시작: 워커 %d개", size);
+}
+
+void work_pool_submit(WorkFn fn, void *arg) {
+
+    if (pool_size == 0) {
+        fn(arg);
+        return;
+    }
+
+    WorkDeque *deque = current_deque;
+    if (deque == NULL) {
+        deque = &deques[atomic_fetch_add_explicit(&next_deque, 1, memory_order_relaxed) % pool_size];
+    }
+    atomic_fetch_add(&pending, 1);
+    if (!deque_push(deque, (WorkItem){fn, arg})) {
+        atomic_fetch_sub(&pending, 1);
+        LOG_ERROR("작업 큐 확장 실패, 호출 스레드에서 실행");
+        fn(arg);
+        return;
+    }
+
+    // 자는 워커가 있으면 하나 깨운다 (나머지는 깬 워커가 못 찾은 만큼 다시 잔다)
+    pthread_mutex_lock(&idle_lock);
+    if (sleeping > 0) {
+        pthread_cond_signal(&idle_cond);
+    }
+    pthread_mutex_unlock(&idle_lock);
+}
+
+int work_pool_size(void) {
+    return pool_size;
+}
+
+unsigned long work_pool_executed(void) {
+    unsigned long total = 0;
+    for (int i = 0; i < pool_size; i++) {
+        total += atomic_load_explicit(&deques[i].executed, memory_order_relaxed);
+    }
+    return total;
+}
+
+unsigned long work_pool_stolen(void) {
+    unsigned long total = 0;
+    for (int i = 0; i < pool_size; i++) {
+        total += atomic_load_explicit(&deques[i].stolen, memory_order_relaxed);
+    }
+    return total;
+}
+
+unsigned long work_pool_pending(void) {
+    return atomic_load(&pending);
+}
@@ -0,0 +1,49 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// 작업 훔치기(work-stealing) 스레드 풀
+// CM/캔버스 스레드가 하던 블로킹성 부수 작업(HTTP 응답 전송, 초기 스냅샷 인코딩, 정적 파일 캐시 재적재)을 맡는다.
+// 워커마다 양방향 큐(deque)가 있고, 자기 큐는 뒤에서(LIFO), 다른 워커 큐는 앞에서(FIFO) 꺼낸다.
+// 작업이 끝나면 결과는 작업을 맡긴 스레드의 Task Queue로 완료 작업을 넣어서 돌려준다
+// (클라이언트 목록, 캔버스 같은 상태는 계속 소유 스레드만 만진다).
+
+#define WORK_POOL_DEFAULT_SIZE 4        // FAINTER_WORKERS 로 변경
+#define WORK_POOL_MAX_SIZE 64
+#define WORK_DEQUE_INITIAL_SIZE 64      // 가득 차면 두 배로 늘린다
+
+typedef void (*WorkFn)(void *arg);
+
+typedef struct {
+    WorkFn fn;
+    void *arg;
+} WorkItem;
+
+// 워커 하나의 양방향 큐 (링 버퍼, top에서 훔치고 bottom에 넣고 뺀다)
+typedef struct {
+    _Alignas(64) pthread_spinlock_t lock;
+    WorkItem *items;
+    unsigned long top, bottom;          // 쌓인 작업 수 = bottom - top
+    unsigned long capacity;             // 2의 거듭제곱
+    pthread_t tid;
+    int index;
+    atomic_ulong executed;              // 실행한 작업 수
+    atomic_ulong stolen;                // 다른 워커 큐에서 훔친 작업 수
+} WorkDeque;
+
+// 풀 시작 (크기는 FAINTER_WORKERS, 없으면 WORK_POOL_DEFAULT_SIZE)
+void work_pool_init(void);
+
+// 작업 제출 (워커 스레드에서 부르면 자기 큐에, 아니면 워커 큐를 돌아가며)
+// 풀을 시작하지 않았으면(벤치마크, 도구) 호출한 스레드에서 바로 실행한다.
+void work_pool_submit(WorkFn fn, void *arg);
+
+// 풀 상태 (/metrics)
+int work_pool_size(void);
+unsigned long work_pool_executed(void);
+unsigned long work_pool_stolen(void);
+unsigned long work_pool_pending(void);
+
+#endif // WORK_POOL_H
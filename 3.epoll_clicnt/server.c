@@ -18,6 +18,7 @@
 #include <sys/time.h>
 #include <time.h>
 #include <signal.h>
+#include <stdatomic.h>
 
 
 #define PORT 8080
@@ -31,9 +32,25 @@
 
 #define MSG_TYPE_CANVAS_UPDATE 1
 #define MSG_TYPE_CLIENT_COUNT  2
+
+// 로그 레벨: 픽셀/브로드캐스트/접속 단위 출력은 DEBUG에서만 컴파일된다
+// (make CFLAGS="-Wall -O2 -DLOG_LEVEL=0" 으로 켠다)
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_DEBUG(...) do { if (LOG_LEVEL <= LOG_LEVEL_DEBUG) printf(__VA_ARGS__); } while (0)
 FILE *log_file;
 pthread_mutex_t log_file_mutex;
 
+// 브로드캐스트 통계: broadcast_to_clients는 원자 카운터만 갱신하고,
+// 샘플러 스레드가 STATS_INTERVAL초마다 broadcast_log.csv에 한 줄씩 쓴다
+#define STATS_INTERVAL 1
+static atomic_ulong stat_broadcasts;
+static atomic_ulong stat_broadcast_us;          // 수행 시간 합계 (us)
+static atomic_ulong stat_broadcast_max_us;
+
 static uint8_t canvas[WIDTH][HEIGHT];
 static pthread_mutex_t canvas_mutex;
 
@@ -50,6 +67,11 @@ typedef struct {
 } client_t;
 
 client_t clients[MAX_CLIENTS];
+
+// 클라이언트 주소 문자열 (inet_ntoa는 정적 버퍼를 공유하므로 쓰지 않는다)
+static const char *addr_str(const client_t *cli, char *buf) {
+    return inet_ntop(AF_INET, &cli->address.sin_addr, buf, INET_ADDRSTRLEN);
+}
 pthread_mutex_t clients_mutex;
 
 // 캔버스 저장 함수
@@ -125,17 +147,19 @@ void broadcast_client_count(unsigned int clientCnt) {
                 clients[i].active = 0;
                 close(clients[i].socket_fd);
                 clientCnt--;
-                printf("동접자 수:%d(나감)\n",clientCnt);
+                LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                 broadcast_client_count(clientCnt);
-                printf("Closed connection with %s:%d due to send failure\n",
-                       inet_ntoa(clients[i].address.sin_addr),
-                       ntohs(clients[i].address.sin_port));
+                char addr[INET_ADDRSTRLEN];
+                LOG_DEBUG("Closed connection with %s:%d due to send failure\n",
+                          addr_str(&clients[i], addr),
+                          ntohs(clients[i].address.sin_port));
                 continue;
             }
 
-            printf("Broadcasted client count (%u) to %s:%d\n", clientCnt,
-                   inet_ntoa(clients[i].address.sin_addr),
-                   ntohs(clients[i].address.sin_port));
+            char addr[INET_ADDRSTRLEN];
+            LOG_DEBUG("Broadcasted client count (%u) to %s:%d\n", clientCnt,
+                      addr_str(&clients[i], addr),
+                      ntohs(clients[i].address.sin_port));
         }
     }
     pthread_mutex_unlock(&clients_mutex);
@@ -230,18 +254,20 @@ void broadcast_to_clients(unsigned char *pixel_updates, size_t len) {
                 clients[i].active = 0;
                 close(clients[i].socket_fd);
                 clientCnt--;
-                printf("동접자 수:%d(나감)\n",clientCnt);
+                LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                 broadcast_client_count(clientCnt);
-                printf("Closed connection with %s:%d due to send failure\n",
-                       inet_ntoa(clients[i].address.sin_addr),
-                       ntohs(clients[i].address.sin_port));
+                char addr[INET_ADDRSTRLEN];
+                LOG_DEBUG("Closed connection with %s:%d due to send failure\n",
+                          addr_str(&clients[i], addr),
+                          ntohs(clients[i].address.sin_port));
                 free(message);
                 continue;
             }
 
-            printf("Broadcasted %zu bytes to %s:%d\n", total_len,
-                   inet_ntoa(clients[i].address.sin_addr),
-                   ntohs(clients[i].address.sin_port));
+            char addr[INET_ADDRSTRLEN];
+            LOG_DEBUG("Broadcasted %zu bytes to %s:%d\n", total_len,
+                      addr_str(&clients[i], addr),
+                      ntohs(clients[i].address.sin_port));
             free(message);
         }
     }
@@ -250,26 +276,47 @@ void broadcast_to_clients(unsigned char *pixel_updates, size_t len) {
     gettimeofday(&t2, NULL);
     elapsedTime = (t2.tv_sec - t1.tv_sec) * 1000.0;      
     elapsedTime += ((t2.tv_usec - t1.tv_usec) / 1000.0); 
-    printf("broadcast_to_clients 수행시간: %f ms\n", elapsedTime);
+    LOG_DEBUG("broadcast_to_clients 수행시간: %f ms\n", elapsedTime);
 
-    pthread_mutex_lock(&log_file_mutex);
-    if (log_file) {
-        // 현재 시간 가져오기
-        time_t now = time(NULL);
-        struct tm *tm_info = localtime(&now);
-        char timestamp[26];
-        strftime(timestamp, 26, "%Y-%m-%d %H:%M:%S", tm_info);
+    unsigned long elapsed_us = (unsigned long)(elapsedTime * 1000.0);
+    atomic_fetch_add_explicit(&stat_broadcasts, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stat_broadcast_us, elapsed_us, memory_order_relaxed);
+    unsigned long max_us = atomic_load_explicit(&stat_broadcast_max_us, memory_order_relaxed);
+    while (elapsed_us > max_us &&
+           !atomic_compare_exchange_weak_explicit(&stat_broadcast_max_us, &max_us, elapsed_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
 
-        // 클라이언트 수 가져오기 (스레드 안전하게)
-        pthread_mutex_lock(&clients_mutex);
-        unsigned int current_client_count = clientCnt;
-        pthread_mutex_unlock(&clients_mutex);
+// STATS_INTERVAL초마다 브로드캐스트 통계를 한 줄로 기록
+// elapsed_time_ms는 구간 평균이라 total.py처럼 client_count별 평균을 내는 스크립트는 그대로 쓸 수 있다
+void *stats_sampler(void *arg) {
+    while (1) {
+        sleep(STATS_INTERVAL);
+
+        unsigned long broadcasts = atomic_exchange(&stat_broadcasts, 0);
+        unsigned long total_us = atomic_exchange(&stat_broadcast_us, 0);
+        unsigned long max_us = atomic_exchange(&stat_broadcast_max_us, 0);
+        if (broadcasts == 0) {
+            continue;
+        }
 
-        // CSV 형식으로 기록: timestamp,client_count,elapsed_time_ms
-        fprintf(log_file, "%s,%u,%.3f\n", timestamp, current_client_count, elapsedTime);
-        fflush(log_file);
+        time_t now = time(NULL);
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        char timestamp[26];
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+        pthread_mutex_lock(&log_file_mutex);
+        if (log_file) {
+            // CSV 형식으로 기록: timestamp,client_count,elapsed_time_ms,broadcasts,max_elapsed_ms
+            fprintf(log_file, "%s,%u,%.3f,%lu,%.3f\n", timestamp, __atomic_load_n(&clientCnt, __ATOMIC_RELAXED),
+                    total_us / 1000.0 / broadcasts, broadcasts, max_us / 1000.0);
+            fflush(log_file);
+        }
+        pthread_mutex_unlock(&log_file_mutex);
     }
-    pthread_mutex_unlock(&log_file_mutex);
+    return NULL;
 }
 
 
@@ -393,12 +440,13 @@ int websocket_handshake(client_t *cli) {
     if (sent < 0) {
         perror("send failed");
         clientCnt--;
-        printf("동접자 수:%d(나감)\n",clientCnt);
+        LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
         broadcast_client_count(clientCnt);
         return -1;
     }
 
-    printf("Handshake completed with %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+    char addr[INET_ADDRSTRLEN];
+    LOG_DEBUG("Handshake completed with %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
 
     return 0;
 }
@@ -454,20 +502,22 @@ ssize_t process_websocket_frame(client_t *cli) {
     // opcode에 따라 처리
     if (opcode == 0x8) {
         // 연결 종료 프레임
-        printf("Client disconnected: %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+        char addr[INET_ADDRSTRLEN];
+        LOG_DEBUG("Client disconnected: %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
         close(cli->socket_fd);
         cli->active = 0;
         clientCnt--;
-        printf("동접자 수:%d(나감)\n",clientCnt);
+        LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
         broadcast_client_count(clientCnt);
         return total_frame_len;
     } 
     else if (opcode == 0x2) {
         // 바이너리 메시지 처리
-        printf("Received binary message from %s:%d - Payload Length: %zu\n", 
-               inet_ntoa(cli->address.sin_addr), 
-               ntohs(cli->address.sin_port), 
-               payload_len);
+        char addr[INET_ADDRSTRLEN];
+        LOG_DEBUG("Received binary message from %s:%d - Payload Length: %zu\n",
+                  addr_str(cli, addr),
+                  ntohs(cli->address.sin_port),
+                  payload_len);
         size_t i = 0;
         while (i + 5 <= payload_len) { // 5바이트씩 처리 (x: 2바이트, y: 2바이트, color: 1바이트)
             uint16_t x = payload_data[i] | (payload_data[i + 1] << 8); 
@@ -489,7 +539,7 @@ ssize_t process_websocket_frame(client_t *cli) {
                 msg[4] = color;
                 broadcast_to_clients(msg, 5);
 
-                printf("Updated pixel (%d, %d) to color %d\n", x, y, color);
+                LOG_DEBUG("Updated pixel (%d, %d) to color %d\n", x, y, color);
             }
         }
     }
@@ -564,7 +614,7 @@ int main(void) {
         return -1;
     }
     // CSV 헤더 추가
-    fprintf(log_file, "timestamp,client_count,elapsed_time_ms\n");
+    fprintf(log_file, "timestamp,client_count,elapsed_time_ms,broadcasts,max_elapsed_ms\n");
     fflush(log_file);
 
     // SIGINT 시그널 처리기 설정
@@ -616,6 +666,14 @@ int main(void) {
         // 계속 진행하되, 저장이 되지 않을 것임을 경고
     }
 
+    // 브로드캐스트 통계 기록 스레드
+    pthread_t stats_thread;
+    if (pthread_create(&stats_thread, NULL, stats_sampler, NULL) != 0) {
+        perror("Failed to create stats thread");
+    } else {
+        pthread_detach(stats_thread);
+    }
+
     while (1) {
         int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
         if (n == -1) {
@@ -670,12 +728,13 @@ int main(void) {
                             perror("epoll_ctl: client_fd");
                             close(client_fd);
                             clientCnt--;
-                            printf("동접자 수:%d(나감)\n",clientCnt);
+                            LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                             broadcast_client_count(clientCnt);
                             clients[idx].active = 0;
                         } 
                         else {
-                            printf("Client connected: %s:%d\n", inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+                            char addr[INET_ADDRSTRLEN];
+                            LOG_DEBUG("Client connected: %s:%d\n", inet_ntop(AF_INET, &client_addr.sin_addr, addr, sizeof(addr)), ntohs(client_addr.sin_port));
                         }
                     } 
                     else {
@@ -768,20 +827,22 @@ int main(void) {
                                 close(cli->socket_fd);
                                 cli->active = 0;
                                 clientCnt--;
-                                printf("동접자 수:%d(나감)\n",clientCnt);
+                                LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                                 broadcast_client_count(clientCnt);
                                 continue;
                             }
 
-                            printf("Initial canvas sent to %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+                            char addr[INET_ADDRSTRLEN];
+                            LOG_DEBUG("Initial canvas sent to %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
                             clientCnt++;
-                            printf("동접자 수:%d(들어옴)\n",clientCnt);
+                            LOG_DEBUG("동접자 수:%d(들어옴)\n",clientCnt);
                             broadcast_client_count(clientCnt);
                             free(init_msg);
                         } 
                         else {
                             // 핸드셰이크 실패
-                            printf("Handshake failed with %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+                            char addr[INET_ADDRSTRLEN];
+                            LOG_DEBUG("Handshake failed with %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
                             close(cli->socket_fd);
                             broadcast_client_count(clientCnt);
                         }
@@ -806,11 +867,12 @@ int main(void) {
                                 } 
                                 else {
                                     // 오류 발생
-                                    printf("Error processing frame for %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+                                    char addr[INET_ADDRSTRLEN];
+                                    LOG_DEBUG("Error processing frame for %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
                                     close(cli->socket_fd);
                                     cli->active = 0;
                                     clientCnt--;
-                                    printf("동접자 수:%d(나감)\n",clientCnt);
+                                    LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                                     broadcast_client_count(clientCnt);
                                     break;
                                 }
@@ -822,10 +884,11 @@ int main(void) {
                         } 
                         else if (bytes_read == 0) {
                             // 클라이언트 연결 종료
-                            printf("Client disconnected: %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+                            char addr[INET_ADDRSTRLEN];
+                            LOG_DEBUG("Client disconnected: %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
                             close(cli->socket_fd);
                             cli->active = 0;clientCnt--;
-                            printf("동접자 수:%d(나감)\n",clientCnt);
+                            LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                             broadcast_client_count(clientCnt);
                         }
                         
@@ -833,11 +896,12 @@ int main(void) {
                 }
                 if (events[i].events & (EPOLLHUP | EPOLLERR)) {
                     // 클라이언트 연결 종료 또는 오류 발생
-                    printf("Client disconnected (EPOLLHUP/EPOLLERR): %s:%d\n", inet_ntoa(cli->address.sin_addr), ntohs(cli->address.sin_port));
+                    char addr[INET_ADDRSTRLEN];
+                    LOG_DEBUG("Client disconnected (EPOLLHUP/EPOLLERR): %s:%d\n", addr_str(cli, addr), ntohs(cli->address.sin_port));
                     close(cli->socket_fd);
                     cli->active = 0;
                     clientCnt--;
-                    printf("동접자 수:%d(나감)\n",clientCnt);
+                    LOG_DEBUG("동접자 수:%d(나감)\n",clientCnt);
                     broadcast_client_count(clientCnt);
                 }
             }
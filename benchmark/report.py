@@ -0,0 +1,107 @@
+"""run_all.sh 결과(results.csv)로 서버 세대별 비교 보고서를 만든다.
+
+사용법: python3 benchmark/report.py <결과 디렉토리>
+- <결과 디렉토리>/report.md : 지표별로 클라이언트 수 x 서버 표
+- <결과 디렉토리>/*.png     : matplotlib이 있으면 지표별 그래프
+"""
+import csv
+import os
+import sys
+
+# (results.csv 열 이름, 보고서 제목, 단위)
+METRICS = [
+    ('deliveries_per_sec', 'Delivered pixels per second', 'px/s'),
+    ('latency_p50_ms', 'Delivery latency p50', 'ms'),
+    ('latency_p99_ms', 'Delivery latency p99', 'ms'),
+    ('latency_p999_ms', 'Delivery latency p99.9', 'ms'),
+    ('join_p50_ms', 'Join time p50 (connect to initial canvas)', 'ms'),
+    ('join_p99_ms', 'Join time p99', 'ms'),
+    ('rss_mb', 'Peak RSS', 'MB'),
+    ('cpu_pct', 'Server CPU', '%'),
+    ('failed', 'Failed connections', ''),
+    ('crashed', 'Server exited by the end of the run (1 = yes)', ''),
+]
+
+
+def load(path):
+    with open(path, newline='') as f:
+        rows = list(csv.DictReader(f))
+    for row in rows:
+        row['rss_mb'] = '%.1f' % (float(row['rss_kb'] or 0) / 1024)
+    return rows
+
+
+def table(rows, servers, clients, metric):
+    values = {(r['server'], int(r['connections'])): r[metric] for r in rows}
+    lines = ['| clients | ' + ' | '.join(servers) + ' |',
+             '|---:|' + '---:|' * len(servers)]
+    for n in clients:
+        cells = [values.get((s, n), '-') for s in servers]
+        lines.append('| %d | %s |' % (n, ' | '.join(cells)))
+    return '\n'.join(lines)
+
+
+def plot(rows, servers, out_dir):
+    try:
+        import matplotlib
+        matplotlib.use('Agg')
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print('matplotlib이 없어 그래프는 만들지 않습니다.')
+        return []
+
+    images = []
+    for metric, title, unit in METRICS:
+        plt.figure(figsize=(8, 4.5))
+        for server in servers:
+            points = sorted((int(r['connections']), float(r[metric] or 0))
+                            for r in rows if r['server'] == server)
+            if points:
+                plt.plot([p[0] for p in points], [p[1] for p in points], marker='o', label=server)
+        plt.xlabel('Client Count')
+        plt.ylabel('%s (%s)' % (title, unit) if unit else title)
+        plt.title(title)
+        plt.grid(True)
+        plt.legend()
+        plt.tight_layout()
+        name = metric + '.png'
+        plt.savefig(os.path.join(out_dir, name))
+        plt.close()
+        images.append((title, name))
+    return images
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    out_dir = sys.argv[1]
+    rows = load(os.path.join(out_dir, 'results.csv'))
+    if not rows:
+        print('results.csv가 비어 있습니다.')
+        sys.exit(1)
+
+    servers = list(dict.fromkeys(r['server'] for r in rows))
+    clients = sorted({int(r['connections']) for r in rows})
+    first = rows[0]
+
+    report = ['# Server generation comparison', '',
+              'painters: %s x %s px/s each, per-second logs: `<server>-<clients>.csv` (total.py format)'
+              % (first['painters'], first['rate']), '']
+    for metric, title, unit in METRICS:
+        report += ['## %s%s' % (title, ' (%s)' % unit if unit else ''), '',
+                   table(rows, servers, clients, metric), '']
+
+    images = plot(rows, servers, out_dir)
+    if images:
+        report += ['## Graphs', '']
+        report += ['![%s](%s)' % (title, name) for title, name in images]
+
+    path = os.path.join(out_dir, 'report.md')
+    with open(path, 'w') as f:
+        f.write('\n'.join(report) + '\n')
+    print('보고서: %s' % path)
+
+
+if __name__ == '__main__':
+    main()
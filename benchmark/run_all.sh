@@ -0,0 +1,164 @@
+#!/bin/bash
+# 서버 세대별 비교 벤치마크
+# 각 서버를 빌드하고, 같은 부하(1.2v/tools/loadgen)를 클라이언트 수별로 걸어서
+# 처리량, 지연 시간, 메모리(RSS), CPU 사용량을 모은 뒤 benchmark/report.py로 보고서를 만든다.
+#
+# 사용법: benchmark/run_all.sh [결과 디렉토리]
+# 환경 변수 (괄호 안은 기본값)
+#   SERVERS    비교할 서버 ("1.libwebsocket 2.multithreading 3.epoll_clicnt 1.2v")
+#   CLIENTS    클라이언트 수 목록 ("10 50 100 200")
+#   DURATION   클라이언트 수마다 부하를 거는 시간(초) (15)
+#   PAINTERS   픽셀을 칠하는 클라이언트 수 (10)
+#   RATE       painter당 초당 픽셀 수 (5)
+#   THREADS    loadgen 스레드 수 (2)
+#   PORT       서버 포트, 모든 서버가 8080으로 고정되어 있다 (8080)
+#
+# 서버는 결과 디렉토리 아래 복사본에서 빌드/실행하므로 저장 파일(canvas.dat, save/)이나 로그가 저장소를 건드리지 않는다.
+# 실행마다 서버를 새로 띄우므로 RSS는 그 실행의 최대치(VmHWM)다.
+# CPU/RSS는 부하를 거는 동안 0.5초마다 샘플링한다 (연결이 끊길 때 죽는 서버도 있어서 끝난 뒤에 읽지 않는다).
+# 부하가 끝났을 때 서버 프로세스가 없으면 crashed=1로 기록한다.
+set -u
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${1:-$ROOT/benchmark/results/$(date +%Y%m%d-%H%M%S)}
+SERVERS=${SERVERS:-"1.libwebsocket 2.multithreading 3.epoll_clicnt 1.2v"}
+CLIENTS=${CLIENTS:-"10 50 100 200"}
+DURATION=${DURATION:-15}
+PAINTERS=${PAINTERS:-10}
+RATE=${RATE:-5}
+THREADS=${THREADS:-2}
+PORT=${PORT:-8080}
+
+LOADGEN=$ROOT/1.2v/tools/loadgen
+RESULTS=$OUT/results.csv
+CLK_TCK=$(getconf CLK_TCK)
+
+mkdir -p "$OUT/work" "$OUT/logs"
+
+echo "[bench] loadgen 빌드"
+if ! make -s -C "$ROOT/1.2v" loadgen; then
+    echo "[bench] loadgen 빌드 실패" >&2
+    exit 1
+fi
+
+# 서버별 프로토콜/캔버스 크기 (loadgen 옵션)
+loadgen_args() {
+    case "$1" in
+        1.libwebsocket)   echo "-m bin3 -W 100 -H 100 -S rplace-protocol" ;;
+        2.multithreading) echo "-m bin3 -W 100 -H 100" ;;
+        3.epoll_clicnt)   echo "-m bin5 -W 500 -H 500" ;;
+        1.2v)             echo "-m json -W 500 -H 500" ;;
+    esac
+}
+
+# 작업 디렉토리에 복사해서 빌드
+build_server() {
+    local name=$1
+    local dir=$OUT/work/$name
+    rm -rf "$dir"
+    cp -r "$ROOT/$name" "$dir"
+    case "$name" in
+        1.libwebsocket)
+            # Makefile이 없어서 직접 빌드 (libwebsockets가 없으면 건너뛴다)
+            if ! pkg-config --exists libwebsockets; then
+                echo "[bench] $name: libwebsockets가 없어 건너뜀" >&2
+                return 1
+            fi
+            gcc -O2 -o "$dir/server" "$dir/server.c" $(pkg-config --cflags --libs libwebsockets) -lpthread
+            ;;
+        *)
+            make -s -C "$dir" clean >/dev/null 2>&1
+            make -s -C "$dir"
+            ;;
+    esac
+}
+
+wait_for_port() {
+    for _ in $(seq 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+# 서버가 살아 있는 동안 "시각 CPU(clock tick, utime + stime) 최대RSS(KB)"를 한 줄씩 기록
+sample_server() {
+    local pid=$1 file=$2
+    while [ -r "/proc/$pid/stat" ]; do
+        local ticks rss
+        ticks=$(awk '{print $14 + $15}' "/proc/$pid/stat" 2>/dev/null) || break
+        rss=$(awk '/^VmHWM:/ {print $2}' "/proc/$pid/status" 2>/dev/null) || break
+        echo "$(date +%s.%N) $ticks $rss" >> "$file"
+        sleep 0.5
+    done
+}
+
+stop_server() {
+    kill "$1" 2>/dev/null
+    for _ in $(seq 20); do
+        kill -0 "$1" 2>/dev/null || return 0
+        sleep 0.1
+    done
+    kill -9 "$1" 2>/dev/null
+    wait "$1" 2>/dev/null
+}
+
+if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+    echo "[bench] 포트 $PORT 를 이미 다른 프로세스가 쓰고 있습니다" >&2
+    exit 1
+fi
+
+rm -f "$RESULTS"
+for name in $SERVERS; do
+    echo "[bench] $name 빌드"
+    if ! build_server "$name"; then
+        continue
+    fi
+    summary=$OUT/work/$name.summary.csv
+    rm -f "$summary"
+
+    for clients in $CLIENTS; do
+        painters=$PAINTERS
+        [ "$painters" -gt "$clients" ] && painters=$clients
+
+        (cd "$OUT/work/$name" && exec ./server > "$OUT/logs/$name-$clients.log" 2>&1) &
+        pid=$!
+        if ! wait_for_port; then
+            echo "[bench] $name 서버가 포트 $PORT 를 열지 않음" >&2
+            stop_server "$pid"
+            continue
+        fi
+
+        echo "[bench] $name: 클라이언트 $clients (painter $painters x $RATE/s, ${DURATION}초)"
+        samples=$OUT/logs/$name-$clients.samples
+        rm -f "$samples"
+        sample_server "$pid" "$samples" &
+        sampler=$!
+        "$LOADGEN" -p "$PORT" -c "$clients" -P "$painters" -r "$RATE" -d "$DURATION" -t "$THREADS" \
+            $(loadgen_args "$name") -o "$OUT/$name-$clients.csv" -O "$summary" > "$OUT/logs/loadgen-$name-$clients.log"
+        crashed=0
+        kill -0 "$pid" 2>/dev/null || crashed=1
+        kill "$sampler" 2>/dev/null
+        wait "$sampler" 2>/dev/null
+        stop_server "$pid"
+
+        # 첫 샘플과 마지막 샘플 사이의 CPU 사용률, 마지막 샘플의 최대 RSS
+        read -r cpu_pct rss < <(awk -v hz="$CLK_TCK" '
+            NR == 1 { t0 = $1; c0 = $2 }
+            { t1 = $1; c1 = $2; rss = $3 }
+            END { printf "%.1f %d\n", (t1 > t0 ? (c1 - c0) / hz / (t1 - t0) * 100 : 0), rss }' "$samples" 2>/dev/null)
+        if [ ! -f "$RESULTS" ]; then
+            echo "server,rss_kb,cpu_pct,crashed,$(head -1 "$summary")" > "$RESULTS"
+        fi
+        echo "$name,${rss:-0},${cpu_pct:-0},$crashed,$(tail -1 "$summary")" >> "$RESULTS"
+    done
+done
+
+if [ ! -f "$RESULTS" ]; then
+    echo "[bench] 결과가 없습니다" >&2
+    exit 1
+fi
+
+python3 "$ROOT/benchmark/report.py" "$OUT"